@@ -0,0 +1,160 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./AuthorRegistry.h"
+#include "./ColdStore.h"
+#include "./publications.h"
+
+void init_string_pool(String_Pool *pool) {
+  if (pool == NULL) {
+    return;
+  }
+
+  strings_ht_init(&pool->index, HMAX_SMALL);
+  memset(&pool->strings, 0, sizeof(String_List));
+  pool->store = NULL;
+}
+
+int intern_string(String_Pool *pool, const char *string) {
+  int *string_id = strings_ht_get(&pool->index, string);
+  if (string_id) {
+    return *string_id;
+  }
+
+  // First time seen => stored for good
+  char *copy = pool->store ? cold_store_string(pool->store, string)
+                           : copy_string(string);
+  string_list_push(&pool->strings, copy);
+  *strings_ht_put(&pool->index, copy) = pool->strings.size - 1;
+
+  return pool->strings.size - 1;
+}
+
+int find_string(String_Pool *pool, const char *string) {
+  int *string_id = strings_ht_get(&pool->index, string);
+
+  return string_id ? *string_id : NO_STRING;
+}
+
+void free_string_pool(String_Pool *pool) {
+  int i;
+
+  if (pool == NULL) {
+    return;
+  }
+
+  strings_ht_destroy(&pool->index);
+  for (i = 0; !pool->store && i < pool->strings.size; i++) {
+    free(pool->strings.items[i]);
+  }
+  string_list_free(&pool->strings);
+}
+
+void init_author_registry(Author_Registry *registry) {
+  if (registry == NULL) {
+    return;
+  }
+
+  author_index_init(&registry->index, HMAX_SMALL);
+  registry->authors = NULL;
+  registry->num_authors = 0;
+  registry->cap_authors = 0;
+  init_string_pool(&registry->strings);
+}
+
+static int add_author_entry(Author_Registry *registry, int64_t author_id,
+                            const char *name) {
+  if (registry->num_authors == registry->cap_authors) {
+    registry->cap_authors =
+        registry->cap_authors ? 2 * registry->cap_authors : HMAX_SMALL;
+    registry->authors = realloc(registry->authors,
+                                registry->cap_authors * sizeof(Author_Entry));
+    DIE(registry->authors == NULL, "registry->authors realloc");
+  }
+
+  int author = registry->num_authors++;
+  Author_Entry *entry = &registry->authors[author];
+  memset(entry, 0, sizeof(Author_Entry));
+  entry->id = author_id;
+  entry->name = intern_string(&registry->strings, name);
+
+  *author_index_put(&registry->index, author_id) = author;
+  return author;
+}
+
+void register_author(Author_Registry *registry, int64_t author_id,
+                     const char *name, const char *institution, int paper_idx,
+                     int paper_year, Paper_Author *paper_author) {
+  int i;
+
+  int *known = author_index_get(&registry->index, author_id);
+  int author = known ? *known : add_author_entry(registry, author_id, name);
+  Author_Entry *entry = &registry->authors[author];
+
+  // Affiliation history - a new institution goes at the end
+  int org = intern_string(&registry->strings, institution);
+  for (i = 0; i < entry->affiliations.size; i++) {
+    if (entry->affiliations.items[i] == org) {
+      break;
+    }
+  }
+  if (i == entry->affiliations.size) {
+    idx_list_push(&entry->affiliations, org);
+  }
+
+  authors_paper new_paper = {.paper_idx = paper_idx, .paper_year = paper_year};
+  authored_list_push(&entry->papers, new_paper);
+
+  paper_author->author = author;
+  paper_author->name = intern_string(&registry->strings, name);
+  paper_author->org = org;
+}
+
+void unregister_author(Author_Registry *registry, int author,
+                       struct paper **papers) {
+  Author_Entry *entry = &registry->authors[author];
+  Authored_List *list = &entry->papers;
+  int i, live = 0;
+
+  entry->removed++;
+  if (entry->removed == list->size) {
+    // Nothing alive left
+    list->size = 0;
+    entry->removed = 0;
+  } else if (2 * entry->removed > list->size) {
+    // Dropping the entries of removed papers
+    for (i = 0; i < list->size; i++) {
+      if (papers[list->items[i].paper_idx]) {
+        list->items[live++] = list->items[i];
+      }
+    }
+    list->size = live;
+    entry->removed = 0;
+  }
+}
+
+Author_Entry *find_author(Author_Registry *registry, int64_t author_id) {
+  int *author = author_index_get(&registry->index, author_id);
+
+  return author ? &registry->authors[*author] : NULL;
+}
+
+void free_author_registry(Author_Registry *registry) {
+  int i;
+
+  if (registry == NULL) {
+    return;
+  }
+
+  for (i = 0; i < registry->num_authors; i++) {
+    idx_list_free(&registry->authors[i].affiliations);
+    authored_list_free(&registry->authors[i].papers);
+  }
+  free(registry->authors);
+  author_index_destroy(&registry->index);
+  free_string_pool(&registry->strings);
+}
@@ -0,0 +1,105 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef AUTHOR_REGISTRY_H_
+#define AUTHOR_REGISTRY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "./GenericHT.h"
+#include "./Hashtables.h"
+
+#define NO_STRING -1
+
+/*
+ * String Pool - every distinct string (author name, institution) is stored
+ * once and named by a dense ID, so comparing two of them is comparing ints
+ */
+DEFINE_HT(Strings_HT, strings_ht, const char *, int, hash_string,
+          equal_strings, KEEP_KEY, NO_FREE, NO_FREE)
+
+DEFINE_VECTOR(String_List, string_list, char *)
+
+typedef struct String_Pool {
+  Strings_HT index;  // string -> ID (keys point inside strings)
+  String_List strings;  // ID -> string
+  struct Cold_Store *store;  // Where the strings go (NULL => heap)
+} String_Pool;
+
+void init_string_pool(String_Pool *pool);
+
+int intern_string(String_Pool *pool, const char *string);
+
+/* ID of an already interned string, NO_STRING otherwise */
+int find_string(String_Pool *pool, const char *string);
+
+static inline const char *get_string(String_Pool *pool, int string_id) {
+  return pool->strings.items[string_id];
+}
+
+void free_string_pool(String_Pool *pool);
+
+/* An author of a paper, as stored in the paper */
+typedef struct paper_author {
+  int author;  // Dense author ID (position in Author_Registry->authors)
+  int name;  // The name the paper lists them under (String_Pool ID)
+  int org;  // The institution they signed the paper from (String_Pool ID)
+} Paper_Author;
+
+/* A paper of an author, with its year - all task 8 needs */
+typedef struct authors_paper {
+  int paper_idx;
+  int paper_year;
+} authors_paper;
+
+DEFINE_VECTOR(Authored_List, authored_list, authors_paper)
+
+/*
+ * Author Registry - one entry per author ID, shared by all their papers
+ * Entries are never removed (an author with no papers left just has an empty
+ * list), so dense author IDs stay valid.
+ */
+typedef struct author_entry {
+  int64_t id;
+  int name;  // Canonical name (String_Pool ID) - the first one seen
+  Idx_List affiliations;  // Institutions (String_Pool IDs), by first paper
+  Authored_List papers;
+  int removed;  // Entries of removed papers in the list
+  uint64_t generation;  // Of the last change (see Query_Cache)
+} Author_Entry;
+
+DEFINE_HT(Author_Index, author_index, int64_t, int, hash_int64, equal_int64,
+          KEEP_KEY, NO_FREE, NO_FREE)
+
+typedef struct Author_Registry {
+  Author_Index index;  // author ID -> dense author ID
+  Author_Entry *authors;
+  int num_authors;
+  int cap_authors;
+  String_Pool strings;  // Names & institutions
+} Author_Registry;
+
+void init_author_registry(Author_Registry *registry);
+
+/*
+ * Adds the paper to the author's list (creating the entry, if new) and
+ * fills in how the paper refers to the author
+ */
+void register_author(Author_Registry *registry, int64_t author_id,
+                     const char *name, const char *institution, int paper_idx,
+                     int paper_year, Paper_Author *paper_author);
+
+/* One of the author's papers was removed */
+void unregister_author(Author_Registry *registry, int author,
+                       struct paper **papers);
+
+/* The author's entry, NULL if the ID is unknown */
+Author_Entry *find_author(Author_Registry *registry, int64_t author_id);
+
+void free_author_registry(Author_Registry *registry);
+
+/* Set of dense IDs (ints), for the queries that count distinct things */
+DEFINE_HT(Id_Set, id_set, int64_t, char, hash_int64, equal_int64, KEEP_KEY,
+          NO_FREE, NO_FREE)
+
+#endif /* AUTHOR_REGISTRY_H_ */
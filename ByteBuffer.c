@@ -0,0 +1,113 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./ByteBuffer.h"
+#include "./EdgeList.h"
+#include "./publications.h"
+
+void byte_buffer_reserve(Byte_Buffer *buf, size_t extra) {
+  if (buf->len + extra <= buf->cap) {
+    return;
+  }
+
+  size_t cap = buf->cap ? buf->cap : 4096;
+  while (cap < buf->len + extra) {
+    cap *= 2;
+  }
+  buf->bytes = realloc(buf->bytes, cap);
+  DIE(buf->bytes == NULL, "byte buffer realloc");
+  buf->cap = cap;
+}
+
+void byte_buffer_put(Byte_Buffer *buf, const void *bytes, size_t len) {
+  byte_buffer_reserve(buf, len);
+  if (len) {
+    memcpy(buf->bytes + buf->len, bytes, len);
+  }
+  buf->len += len;
+}
+
+void byte_buffer_put_varint(Byte_Buffer *buf, uint64_t value) {
+  byte_buffer_reserve(buf, VARINT_MAX_BYTES);
+  while (value >= 0x80u) {
+    buf->bytes[buf->len++] = (uint8_t)(value | 0x80u);
+    value >>= 7;
+  }
+  buf->bytes[buf->len++] = (uint8_t)value;
+}
+
+void byte_buffer_put_zigzag(Byte_Buffer *buf, int64_t value) {
+  byte_buffer_put_varint(buf, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+void byte_buffer_put_string(Byte_Buffer *buf, const char *string) {
+  size_t len = strlen(string);
+
+  byte_buffer_put_varint(buf, len);
+  byte_buffer_put(buf, string, len);
+}
+
+void byte_buffer_free(Byte_Buffer *buf) {
+  free(buf->bytes);
+  memset(buf, 0, sizeof(Byte_Buffer));
+}
+
+int byte_reader_byte(Byte_Reader *reader) {
+  if (reader->pos == reader->end) {
+    reader->ok = 0;
+    return 0;
+  }
+
+  return *reader->pos++;
+}
+
+uint64_t byte_reader_varint(Byte_Reader *reader) {
+  uint64_t value = 0;
+  unsigned shift = 0;
+
+  while (reader->pos < reader->end && shift < 64) {
+    uint8_t byte = *reader->pos++;
+    value |= (uint64_t)(byte & 0x7fu) << shift;
+    if (!(byte & 0x80u)) {
+      return value;
+    }
+    shift += 7;
+  }
+
+  reader->ok = 0;
+  return 0;
+}
+
+int64_t byte_reader_zigzag(Byte_Reader *reader) {
+  uint64_t value = byte_reader_varint(reader);
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1u);
+}
+
+int byte_reader_count(Byte_Reader *reader) {
+  uint64_t count = byte_reader_varint(reader);
+  if (count > (uint64_t)(reader->end - reader->pos)) {
+    reader->ok = 0;
+    return 0;
+  }
+
+  return (int)count;
+}
+
+char *byte_reader_string(Byte_Reader *reader) {
+  int len = byte_reader_count(reader);
+  if (!reader->ok) {
+    return NULL;
+  }
+
+  char *string = malloc(len + 1);
+  DIE(string == NULL, "byte_reader_string malloc");
+  memcpy(string, reader->pos, len);
+  string[len] = '\0';
+  reader->pos += len;
+
+  return string;
+}
@@ -0,0 +1,59 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef BYTE_BUFFER_H_
+#define BYTE_BUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Byte Buffer - growable bytes, for the binary forms (the log, the cluster's
+ * messages): numbers as varints (7 bits per byte, as in EdgeList.h), signed
+ * ones zigzagged first so that small negative numbers stay small, strings
+ * as a varint length + the bytes
+ */
+typedef struct byte_buffer {
+  uint8_t *bytes;
+  size_t len;
+  size_t cap;
+} Byte_Buffer;
+
+void byte_buffer_reserve(Byte_Buffer *buf, size_t extra);
+
+void byte_buffer_put(Byte_Buffer *buf, const void *bytes, size_t len);
+
+void byte_buffer_put_varint(Byte_Buffer *buf, uint64_t value);
+
+void byte_buffer_put_zigzag(Byte_Buffer *buf, int64_t value);
+
+void byte_buffer_put_string(Byte_Buffer *buf, const char *string);
+
+void byte_buffer_free(Byte_Buffer *buf);
+
+/* Reading it back - every read past the end clears ok (and returns 0) */
+typedef struct byte_reader {
+  const uint8_t *pos;
+  const uint8_t *end;
+  int ok;
+} Byte_Reader;
+
+static inline void byte_reader_init(Byte_Reader *reader, const uint8_t *bytes,
+                                    size_t len) {
+  reader->pos = bytes;
+  reader->end = bytes + len;
+  reader->ok = 1;
+}
+
+int byte_reader_byte(Byte_Reader *reader);
+
+uint64_t byte_reader_varint(Byte_Reader *reader);
+
+int64_t byte_reader_zigzag(Byte_Reader *reader);
+
+/* A count of things to come, each at least a byte - checked against that */
+int byte_reader_count(Byte_Reader *reader);
+
+/* A new string, NULL past the end */
+char *byte_reader_string(Byte_Reader *reader);
+
+#endif /* BYTE_BUFFER_H_ */
@@ -0,0 +1,270 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./CitationYears.h"
+#include "./Columns.h"
+#include "./EdgeList.h"
+#include "./publications.h"
+#include "./utils.h"
+
+/* ------------------------- Fenwick trees ------------------------- */
+/* tree[1 .. span] - position pos is tree index pos + 1 */
+static void fenwick_add(int *tree, int span, int pos, int delta) {
+  for (pos++; pos <= span; pos += pos & -pos) {
+    tree[pos] += delta;
+  }
+}
+
+/* Sum of the positions [0, end) */
+static int fenwick_prefix(const int *tree, int end) {
+  int sum = 0;
+
+  for (; end > 0; end -= end & -end) {
+    sum += tree[end];
+  }
+
+  return sum;
+}
+
+/*
+ * The same counts, moved `shift` positions to the right in a tree of
+ * new_span positions (built bottom-up, in O(new_span))
+ */
+static int *rebuild_tree(int *tree, int span, int shift, int new_span) {
+  int i, j;
+
+  int *rebuilt = calloc(new_span + 1, sizeof(int));
+  DIE(rebuilt == NULL, "rebuilt calloc");
+
+  for (i = 0; i < span; i++) {
+    rebuilt[i + shift + 1] =
+        fenwick_prefix(tree, i + 1) - fenwick_prefix(tree, i);
+  }
+  for (i = 1; i <= new_span; i++) {
+    j = i + (i & -i);
+    if (j <= new_span) {
+      rebuilt[j] += rebuilt[i];
+    }
+  }
+
+  free(tree);
+  return rebuilt;
+}
+
+/* ------------------------- Venues ------------------------- */
+static Venue_Years *get_venue_years(Citation_Years *years, int venue) {
+  if (venue >= years->cap) {
+    int cap = years->cap ? years->cap : 16;
+    while (cap <= venue) {
+      cap *= 2;
+    }
+
+    years->venues = realloc(years->venues, cap * sizeof(Venue_Years));
+    DIE(years->venues == NULL, "years->venues realloc");
+    memset(years->venues + years->cap, 0,
+           (cap - years->cap) * sizeof(Venue_Years));
+    years->cap = cap;
+  }
+
+  return &years->venues[venue];
+}
+
+/* Widens the venue's trees (at least twice) until they cover the year */
+static void cover_year(Venue_Years *venue, int year) {
+  int i;
+
+  if (venue->span && year >= venue->base &&
+      (int64_t)year - venue->base < venue->span) {
+    return;
+  }
+
+  int low = year, high = year, span = 1;
+  if (venue->span) {
+    low = year < venue->base ? year : venue->base;
+    high = venue->base + venue->span - 1;
+    high = year > high ? year : high;
+    span = 2 * venue->span;
+  }
+  while (span < high - low + 1) {
+    span *= 2;
+  }
+
+  // The room left over goes on the side the new year came from
+  int base = venue->span && year < venue->base ? high - span + 1 : low;
+  int shift = venue->span ? venue->base - base : 0;
+
+  venue->papers = rebuild_tree(venue->papers, venue->span, shift, span);
+
+  int **citations = calloc(span, sizeof(int *));
+  DIE(citations == NULL, "citations calloc");
+  for (i = 0; i < venue->span; i++) {
+    if (venue->citations[i]) {
+      citations[i + shift] =
+          rebuild_tree(venue->citations[i], venue->span, shift, span);
+    }
+  }
+  free(venue->citations);
+
+  venue->citations = citations;
+  venue->base = base;
+  venue->span = span;
+}
+
+/* Sum of the tree over the years [early, late] */
+static int sum_years(const int *tree, const Venue_Years *venue, int early,
+                     int late) {
+  int64_t start = (int64_t)early - venue->base;
+  int64_t end = (int64_t)late - venue->base + 1;
+
+  start = start > 0 ? start : 0;
+  end = end < venue->span ? end : venue->span;
+  if (tree == NULL || start >= end) {
+    return 0;
+  }
+
+  return fenwick_prefix(tree, end) - fenwick_prefix(tree, start);
+}
+
+/* ------------------------- Papers ------------------------- */
+static void count_paper(PublData *data, int idx, int delta) {
+  int venue = data->columns->venue[idx];
+  if (venue == NO_VENUE) {
+    return;
+  }
+
+  Venue_Years *years = get_venue_years(data->citation_years, venue);
+  int year = data->columns->year[idx];
+
+  cover_year(years, year);
+  fenwick_add(years->papers, years->span, year - years->base, delta);
+}
+
+static void count_citation(PublData *data, int cited, int citing,
+                           int delta) {
+  int venue = data->columns->venue[cited];
+  if (venue == NO_VENUE) {
+    return;
+  }
+
+  Venue_Years *years = get_venue_years(data->citation_years, venue);
+  int year = data->columns->year[cited];
+  int citing_year = data->columns->year[citing];
+
+  cover_year(years, year);
+  cover_year(years, citing_year);
+
+  int **row = &years->citations[citing_year - years->base];
+  if (*row == NULL) {
+    *row = calloc(years->span + 1, sizeof(int));
+    DIE(*row == NULL, "citations row calloc");
+  }
+  fenwick_add(*row, years->span, year - years->base, delta);
+}
+
+/*
+ * Every edge between two added papers is in the refs of one and the
+ * influenced of the other - a self-citation only counts from its refs
+ */
+static void count_paper_edges(PublData *data, int idx, int delta) {
+  Paper *publication = data->papers[idx];
+  Edge_Iter it;
+  int other;
+
+  count_paper(data, idx, delta);
+
+  edge_iter_init(&it, &publication->info->refs);
+  while (edge_iter_next_idx(&it, &other)) {
+    if (data->papers[other]) {
+      count_citation(data, other, idx, delta);
+    }
+  }
+
+  edge_iter_init(&it, &publication->influenced);
+  while (edge_iter_next_idx(&it, &other)) {
+    if (other != idx && data->papers[other]) {
+      count_citation(data, idx, other, delta);
+    }
+  }
+}
+
+void citation_years_add_paper(PublData *data, int idx) {
+  count_paper_edges(data, idx, 1);
+}
+
+void citation_years_remove_paper(PublData *data, int idx) {
+  count_paper_edges(data, idx, -1);
+}
+
+void citation_years_remove_venue(Citation_Years *years, int venue) {
+  int i;
+
+  if (venue < 0 || venue >= years->cap) {
+    return;
+  }
+
+  // A new venue gets a new dense ID, so nothing would free these
+  Venue_Years *venue_years = &years->venues[venue];
+  for (i = 0; i < venue_years->span; i++) {
+    free(venue_years->citations[i]);
+  }
+  free(venue_years->citations);
+  free(venue_years->papers);
+  memset(venue_years, 0, sizeof(Venue_Years));
+}
+
+/* ------------------------- Queries ------------------------- */
+int count_venue_papers(Citation_Years *years, int venue, int early_date,
+                       int late_date) {
+  if (venue < 0 || venue >= years->cap) {
+    return 0;
+  }
+
+  Venue_Years *venue_years = &years->venues[venue];
+  return sum_years(venue_years->papers, venue_years, early_date, late_date);
+}
+
+int count_venue_citations(Citation_Years *years, int venue, int early_date,
+                          int late_date, int early_citing, int late_citing) {
+  int64_t citing, first, last;
+  int cnt = 0;
+
+  if (venue < 0 || venue >= years->cap) {
+    return 0;
+  }
+
+  Venue_Years *venue_years = &years->venues[venue];
+  first = (int64_t)early_citing - venue_years->base;
+  last = (int64_t)late_citing - venue_years->base;
+
+  first = first > 0 ? first : 0;
+  last = last < venue_years->span ? last : venue_years->span - 1;
+
+  for (citing = first; citing <= last; citing++) {
+    cnt += sum_years(venue_years->citations[citing], venue_years, early_date,
+                     late_date);
+  }
+
+  return cnt;
+}
+
+void free_citation_years(Citation_Years *years) {
+  int i, j;
+
+  if (years == NULL) {
+    return;
+  }
+
+  for (i = 0; i < years->cap; i++) {
+    for (j = 0; j < years->venues[i].span; j++) {
+      free(years->venues[i].citations[j]);
+    }
+    free(years->venues[i].citations);
+    free(years->venues[i].papers);
+  }
+  free(years->venues);
+  free(years);
+}
@@ -0,0 +1,59 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef CITATION_YEARS_H_
+#define CITATION_YEARS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct publications_data;
+
+/*
+ * Citation Years - the citations of every venue, by year
+ * Each citation counts for the cited paper's venue and publication year and
+ * for the year of the citing paper. Per venue, there is a Fenwick tree over
+ * the publication years for the papers published, and one more for the
+ * citations made in every citing year - so "citations in year Y to the
+ * papers published in [A, B]" and "papers published in [A, B]" are two
+ * prefix sums, O(log years) each.
+ * The trees of a venue cover the same years: [base, base + span), span a
+ * power of 2, widened (and rebuilt) when a year outside them shows up.
+ * Always on - init_publ_data creates it, add_paper / remove_paper keep
+ * everything up to date.
+ */
+typedef struct venue_years {
+  int base;  // Year of position 0
+  int span;  // Years covered (0 - nothing counted yet)
+  int *papers;  // Fenwick tree (span + 1) - papers, by publication year
+  int **citations;  // [citing year - base] - same, the citations made that
+                    // year to them (NULL - none)
+} Venue_Years;
+
+typedef struct Citation_Years {
+  Venue_Years *venues;  // By dense venue ID (see add_venue)
+  int cap;
+} Citation_Years;
+
+/* Counts the paper and all the citations it makes / gets from added papers */
+void citation_years_add_paper(struct publications_data *data, int idx);
+
+/* The opposite - before the paper is removed */
+void citation_years_remove_paper(struct publications_data *data, int idx);
+
+/* Frees the (empty) trees of a venue whose last paper was removed */
+void citation_years_remove_venue(Citation_Years *years, int venue);
+
+/* Papers of the venue published in [early_date, late_date] */
+int count_venue_papers(Citation_Years *years, int venue, int early_date,
+                       int late_date);
+
+/*
+ * Citations made in [early_citing, late_citing] to the papers of the venue
+ * published in [early_date, late_date]
+ */
+int count_venue_citations(Citation_Years *years, int venue, int early_date,
+                          int late_date, int early_citing, int late_citing);
+
+void free_citation_years(Citation_Years *years);
+
+#endif /* CITATION_YEARS_H_ */
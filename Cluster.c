@@ -0,0 +1,734 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "./ByteBuffer.h"
+#include "./Cluster.h"
+#include "./Hashtables.h"
+#include "./PaperOps.h"
+#include "./Shards.h"
+#include "./Transport.h"
+#include "./publications.h"
+#include "./utils.h"
+
+/*
+ * Messages: a type byte, then (ID lists as a varint count + zigzag IDs,
+ * "per worker" - one of them for each worker, in order)
+ *   request                        reply
+ *   APPLY ops (binary form)        notes per worker (count, (id, delta)...)
+ *   NOTES count, (id, delta)...    -
+ *   START_REFERENCES id            found byte, if found: IDs per worker
+ *   BEGIN_SEARCH id                -
+ *   EXPAND_REFERENCES IDs          IDs per worker
+ *   BEST                           found byte, if found: id, year,
+ *                                  citations, title
+ *   EXPAND_CITATIONS IDs           IDs
+ *   VENUE venue                    sum, count
+ *   DATES early, late              count
+ *   HISTOGRAM author id            num_years, count...
+ *   QUIT                           (none)
+ * Numbers are zigzag varints.
+ */
+typedef enum cluster_message {
+  MSG_APPLY,
+  MSG_NOTES,
+  MSG_START_REFERENCES,
+  MSG_BEGIN_SEARCH,
+  MSG_EXPAND_REFERENCES,
+  MSG_BEST,
+  MSG_EXPAND_CITATIONS,
+  MSG_VENUE,
+  MSG_DATES,
+  MSG_HISTOGRAM,
+  MSG_QUIT
+} Cluster_Message;
+
+static void put_ids(Byte_Buffer *buf, const Id_List *ids) {
+  int i;
+
+  byte_buffer_put_varint(buf, ids->size);
+  for (i = 0; i < ids->size; i++) {
+    byte_buffer_put_zigzag(buf, ids->items[i]);
+  }
+}
+
+/* Appended to ids */
+static void read_ids(Byte_Reader *reader, Id_List *ids) {
+  int i;
+
+  int count = byte_reader_count(reader);
+  for (i = 0; i < count && reader->ok; i++) {
+    id_list_push(ids, byte_reader_zigzag(reader));
+  }
+}
+
+static void put_notes(Byte_Buffer *buf, const Citation_Notes *notes) {
+  int i;
+
+  byte_buffer_put_varint(buf, notes->size);
+  for (i = 0; i < notes->size; i++) {
+    byte_buffer_put_zigzag(buf, notes->items[i].id);
+    byte_buffer_put_zigzag(buf, notes->items[i].delta);
+  }
+}
+
+static void read_notes(Byte_Reader *reader, Citation_Notes *notes) {
+  Citation_Note note;
+  int i;
+
+  int count = byte_reader_count(reader);
+  for (i = 0; i < count && reader->ok; i++) {
+    note.id = byte_reader_zigzag(reader);
+    note.delta = (int)byte_reader_zigzag(reader);
+    citation_notes_push(notes, note);
+  }
+}
+
+/* ------------------------- Worker ------------------------- */
+typedef struct cluster_worker {
+  PublData *data;
+  int s;
+  int num_shards;
+  Citation_Notes *notes;  // Outboxes, one per shard
+  Id_List *out;
+  Id_List in;
+  Paper *best;
+} Cluster_Worker;
+
+static void apply_ops(Cluster_Worker *worker, Byte_Reader *reader,
+                      Byte_Buffer *reply) {
+  int i, j;
+
+  int num_ops = byte_reader_count(reader);
+  Paper_Op *ops = calloc(num_ops + 1, sizeof(Paper_Op));
+  DIE(ops == NULL, "cluster ops calloc");
+  for (i = 0; i < num_ops; i++) {
+    DIE(decode_paper_op(reader, &ops[i]) < 0, "cluster op");
+  }
+
+  shard_apply_ops(worker->data, worker->s, worker->num_shards, ops, num_ops,
+                  worker->notes);
+
+  for (i = 0; i < num_ops; i++) {
+    free_paper_op(&ops[i]);
+  }
+  free(ops);
+
+  for (j = 0; j < worker->num_shards; j++) {
+    put_notes(reply, &worker->notes[j]);
+    worker->notes[j].size = 0;
+  }
+}
+
+static void put_outboxes(Cluster_Worker *worker, Byte_Buffer *reply) {
+  int j;
+
+  for (j = 0; j < worker->num_shards; j++) {
+    put_ids(reply, &worker->out[j]);
+    worker->out[j].size = 0;
+  }
+}
+
+static void put_best(Cluster_Worker *worker, Byte_Buffer *reply) {
+  Paper *best = worker->best;
+
+  byte_buffer_put_varint(reply, best != NULL);
+  if (best) {
+    byte_buffer_put_zigzag(reply, best->id);
+    byte_buffer_put_zigzag(reply, best->year);
+    byte_buffer_put_zigzag(reply, get_paper_citations(worker->data, best));
+    byte_buffer_put_string(reply, best->info->title);
+  }
+}
+
+/* 0 - the coordinator is done with the worker */
+static int answer(Cluster_Worker *worker, Byte_Reader *reader,
+                  Byte_Buffer *reply) {
+  PublData *data = worker->data;
+  int64_t sum;
+  int i, count, found;
+
+  switch (byte_reader_byte(reader)) {
+    case MSG_APPLY:
+      apply_ops(worker, reader, reply);
+      break;
+    case MSG_NOTES:
+      // Its outbox to itself - always empty otherwise
+      read_notes(reader, &worker->notes[worker->s]);
+      shard_apply_notes(data, &worker->notes[worker->s]);
+      break;
+    case MSG_START_REFERENCES:
+      found = shard_start_references(data, worker->num_shards,
+                                     byte_reader_zigzag(reader), worker->out);
+      byte_buffer_put_varint(reply, found);
+      if (found) {
+        put_outboxes(worker, reply);
+      }
+      break;
+    case MSG_BEGIN_SEARCH:
+      shard_begin_search(data, byte_reader_zigzag(reader));
+      worker->best = NULL;
+      break;
+    case MSG_EXPAND_REFERENCES:
+      worker->in.size = 0;
+      read_ids(reader, &worker->in);
+      shard_expand_references(data, worker->num_shards, &worker->in,
+                              worker->out, &worker->best);
+      put_outboxes(worker, reply);
+      break;
+    case MSG_BEST:
+      put_best(worker, reply);
+      break;
+    case MSG_EXPAND_CITATIONS:
+      worker->in.size = 0;
+      read_ids(reader, &worker->in);
+      worker->out[0].size = 0;
+      shard_expand_citations(data, worker->s, worker->num_shards,
+                             &worker->in, &worker->out[0]);
+      put_ids(reply, &worker->out[0]);
+      worker->out[0].size = 0;
+      break;
+    case MSG_VENUE: {
+      char *venue = byte_reader_string(reader);
+      DIE(venue == NULL, "cluster venue");
+      shard_sum_venue_citations(data, venue, &sum, &count);
+      byte_buffer_put_zigzag(reply, sum);
+      byte_buffer_put_zigzag(reply, count);
+      free(venue);
+      break;
+    }
+    case MSG_DATES: {
+      int early_date = (int)byte_reader_zigzag(reader);
+      int late_date = (int)byte_reader_zigzag(reader);
+      byte_buffer_put_zigzag(
+          reply, get_number_of_papers_between_dates(data, early_date,
+                                                    late_date));
+      break;
+    }
+    case MSG_HISTOGRAM: {
+      int *histogram = get_histogram_of_citations(
+          data, byte_reader_zigzag(reader), &count);
+      byte_buffer_put_zigzag(reply, count);
+      for (i = 0; i < count; i++) {
+        byte_buffer_put_zigzag(reply, histogram[i]);
+      }
+      free(histogram);
+      break;
+    }
+    case MSG_QUIT:
+      return 0;
+    default:
+      DIE(1, "cluster message type");
+  }
+
+  DIE(!reader->ok, "cluster message");
+
+  return 1;
+}
+
+void run_cluster_worker(Transport *transport, int s, int num_shards) {
+  Cluster_Worker worker = {0};
+  Byte_Buffer request = {0}, reply = {0};
+  Byte_Reader reader;
+  int i;
+
+  worker.data = init_publ_data();
+  worker.s = s;
+  worker.num_shards = num_shards;
+  worker.notes = calloc(num_shards, sizeof(Citation_Notes));
+  worker.out = calloc(num_shards, sizeof(Id_List));
+  DIE(worker.notes == NULL || worker.out == NULL, "cluster worker calloc");
+
+  while (transport->recv(transport, 0, &request) == 0) {
+    byte_reader_init(&reader, request.bytes, request.len);
+    reply.len = 0;
+    if (!answer(&worker, &reader, &reply)) {
+      break;
+    }
+    DIE(transport->send(transport, 0, &reply) < 0, "cluster worker send");
+  }
+
+  transport->close(transport);
+  for (i = 0; i < num_shards; i++) {
+    citation_notes_free(&worker.notes[i]);
+    id_list_free(&worker.out[i]);
+  }
+  free(worker.notes);
+  free(worker.out);
+  id_list_free(&worker.in);
+  byte_buffer_free(&request);
+  byte_buffer_free(&reply);
+  destroy_publ_data(worker.data);
+}
+
+/* ------------------------- Coordinator ------------------------- */
+Publ_Cluster *attach_publ_cluster(Transport *transport) {
+  Publ_Cluster *cluster = calloc(1, sizeof(Publ_Cluster));
+  DIE(cluster == NULL, "cluster calloc");
+
+  int n = transport->num_peers;
+  cluster->num_workers = n;
+  cluster->transport = transport;
+  cluster->requests = calloc(n, sizeof(Byte_Buffer));
+  cluster->notes = calloc(n, sizeof(Citation_Notes));
+  cluster->mail = calloc(n, sizeof(Id_List));
+  DIE(cluster->requests == NULL || cluster->notes == NULL ||
+          cluster->mail == NULL,
+      "cluster buffers calloc");
+
+  return cluster;
+}
+
+Publ_Cluster *init_publ_cluster(int num_workers) {
+  int pairs[MAX_CLUSTER_WORKERS][2], fds[MAX_CLUSTER_WORKERS];
+  pid_t pids[MAX_CLUSTER_WORKERS];
+  int w, i;
+
+  if (num_workers <= 0) {
+    num_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if (num_workers > MAX_CLUSTER_WORKERS) {
+    num_workers = MAX_CLUSTER_WORKERS;
+  }
+  if (num_workers <= 0) {
+    num_workers = 1;
+  }
+
+  for (w = 0; w < num_workers; w++) {
+    DIE(socketpair(AF_UNIX, SOCK_STREAM, 0, pairs[w]) < 0,
+        "cluster socketpair");
+  }
+
+  // Output still buffered would be written by every worker as well
+  fflush(NULL);
+  for (w = 0; w < num_workers; w++) {
+    pids[w] = fork();
+    DIE(pids[w] < 0, "cluster fork");
+
+    if (pids[w] == 0) {
+      // Only its own end of its own socket
+      for (i = 0; i < num_workers; i++) {
+        close(pairs[i][0]);
+        if (i != w) {
+          close(pairs[i][1]);
+        }
+      }
+      run_cluster_worker(init_socket_transport(&pairs[w][1], 1), w,
+                         num_workers);
+      _exit(0);
+    }
+  }
+
+  for (w = 0; w < num_workers; w++) {
+    close(pairs[w][1]);
+    fds[w] = pairs[w][0];
+  }
+
+  Publ_Cluster *cluster =
+      attach_publ_cluster(init_socket_transport(fds, num_workers));
+  cluster->pids = calloc(num_workers, sizeof(pid_t));
+  DIE(cluster->pids == NULL, "cluster->pids calloc");
+  memcpy(cluster->pids, pids, num_workers * sizeof(pid_t));
+
+  return cluster;
+}
+
+void destroy_publ_cluster(Publ_Cluster *cluster) {
+  int w;
+
+  if (cluster == NULL) {
+    return;
+  }
+
+  // No reply to wait for - a worker already gone does not matter either
+  for (w = 0; w < cluster->num_workers; w++) {
+    cluster->requests[w].len = 0;
+    byte_buffer_put_varint(&cluster->requests[w], MSG_QUIT);
+    cluster->transport->send(cluster->transport, w, &cluster->requests[w]);
+  }
+  cluster->transport->close(cluster->transport);
+
+  for (w = 0; w < cluster->num_workers; w++) {
+    if (cluster->pids) {
+      while (waitpid(cluster->pids[w], NULL, 0) < 0 && errno == EINTR) {
+      }
+    }
+    byte_buffer_free(&cluster->requests[w]);
+    citation_notes_free(&cluster->notes[w]);
+    id_list_free(&cluster->mail[w]);
+  }
+
+  free(cluster->pids);
+  free(cluster->requests);
+  free(cluster->notes);
+  free(cluster->mail);
+  byte_buffer_free(&cluster->reply);
+  id_list_free(&cluster->frontier);
+  free(cluster->title);
+  free(cluster);
+}
+
+/* The request being built for worker w */
+static Byte_Buffer *new_request(Publ_Cluster *cluster, int w,
+                                Cluster_Message type) {
+  Byte_Buffer *request = &cluster->requests[w];
+
+  request->len = 0;
+  byte_buffer_put_varint(request, type);
+
+  return request;
+}
+
+static void send_request(Publ_Cluster *cluster, int w) {
+  DIE(cluster->transport->send(cluster->transport, w,
+                               &cluster->requests[w]) < 0,
+      "cluster send");
+}
+
+/* Worker w's reply, to be read through reader */
+static void recv_reply(Publ_Cluster *cluster, int w, Byte_Reader *reader) {
+  DIE(cluster->transport->recv(cluster->transport, w, &cluster->reply) < 0,
+      "cluster recv");
+  byte_reader_init(reader, cluster->reply.bytes, cluster->reply.len);
+}
+
+/* The same request to every worker, then their replies (which are empty) */
+static void broadcast(Publ_Cluster *cluster) {
+  Byte_Reader reader;
+  int w;
+
+  for (w = 0; w < cluster->num_workers; w++) {
+    send_request(cluster, w);
+  }
+  for (w = 0; w < cluster->num_workers; w++) {
+    recv_reply(cluster, w, &reader);
+  }
+}
+
+/* ------------------------- Changes ------------------------- */
+void cluster_apply(Publ_Cluster *cluster, Paper_Op *ops, int num_ops) {
+  Byte_Reader reader;
+  int n, w, i, count;
+
+  if (cluster == NULL || num_ops <= 0) {
+    return;
+  }
+  n = cluster->num_workers;
+
+  // Every worker gets the ops it owns, in order
+  for (w = 0; w < n; w++) {
+    for (i = 0, count = 0; i < num_ops; i++) {
+      count += owner_shard(ops[i].id, n) == w;
+    }
+
+    Byte_Buffer *request = new_request(cluster, w, MSG_APPLY);
+    byte_buffer_put_varint(request, count);
+    for (i = 0; i < num_ops; i++) {
+      if (owner_shard(ops[i].id, n) == w) {
+        encode_paper_op(request, &ops[i]);
+      }
+    }
+    send_request(cluster, w);
+  }
+
+  // ... and the citations they made go to the cited papers' owners
+  for (w = 0; w < n; w++) {
+    recv_reply(cluster, w, &reader);
+    for (i = 0; i < n; i++) {
+      read_notes(&reader, &cluster->notes[i]);
+    }
+    DIE(!reader.ok, "cluster notes");
+  }
+
+  for (w = 0; w < n; w++) {
+    if (cluster->notes[w].size) {
+      put_notes(new_request(cluster, w, MSG_NOTES), &cluster->notes[w]);
+      send_request(cluster, w);
+    }
+  }
+  for (w = 0; w < n; w++) {
+    if (cluster->notes[w].size) {
+      recv_reply(cluster, w, &reader);
+      cluster->notes[w].size = 0;
+    }
+  }
+}
+
+void cluster_add_paper(Publ_Cluster *cluster, const char *title,
+                       const char *venue, const int year,
+                       const char **author_names, const int64_t *author_ids,
+                       const char **institutions, const int num_authors,
+                       const char **fields, const int num_fields,
+                       const int64_t id, const int64_t *references,
+                       const int num_refs) {
+  // The arguments are only read - no need for copies
+  Paper_Op op = {.type = OP_ADD_PAPER,
+                 .id = id,
+                 .title = (char *)title,
+                 .venue = (char *)venue,
+                 .year = year,
+                 .author_names = (char **)author_names,
+                 .author_ids = (int64_t *)author_ids,
+                 .institutions = (char **)institutions,
+                 .num_authors = num_authors,
+                 .fields = (char **)fields,
+                 .num_fields = num_fields,
+                 .references = (int64_t *)references,
+                 .num_refs = num_refs};
+
+  cluster_apply(cluster, &op, 1);
+}
+
+void cluster_update_paper(Publ_Cluster *cluster, const char *title,
+                          const char *venue, const int year,
+                          const char **author_names, const int64_t *author_ids,
+                          const char **institutions, const int num_authors,
+                          const char **fields, const int num_fields,
+                          const int64_t id, const int64_t *references,
+                          const int num_refs) {
+  Paper_Op op = {.type = OP_UPDATE_PAPER,
+                 .id = id,
+                 .title = (char *)title,
+                 .venue = (char *)venue,
+                 .year = year,
+                 .author_names = (char **)author_names,
+                 .author_ids = (int64_t *)author_ids,
+                 .institutions = (char **)institutions,
+                 .num_authors = num_authors,
+                 .fields = (char **)fields,
+                 .num_fields = num_fields,
+                 .references = (int64_t *)references,
+                 .num_refs = num_refs};
+
+  cluster_apply(cluster, &op, 1);
+}
+
+void cluster_remove_paper(Publ_Cluster *cluster, const int64_t id) {
+  Paper_Op op = {.type = OP_REMOVE_PAPER, .id = id};
+
+  cluster_apply(cluster, &op, 1);
+}
+
+/* ------------------------- Searches ------------------------- */
+static void begin_search(Publ_Cluster *cluster, int64_t id) {
+  int w;
+
+  for (w = 0; w < cluster->num_workers; w++) {
+    byte_buffer_put_zigzag(new_request(cluster, w, MSG_BEGIN_SEARCH), id);
+  }
+  broadcast(cluster);
+}
+
+/* The IDs per worker of a reply, added to the mailboxes */
+static void read_mail(Publ_Cluster *cluster, Byte_Reader *reader) {
+  int w;
+
+  for (w = 0; w < cluster->num_workers; w++) {
+    read_ids(reader, &cluster->mail[w]);
+  }
+  DIE(!reader->ok, "cluster mail");
+}
+
+char *cluster_get_oldest_influence(Publ_Cluster *cluster,
+                                   const int64_t id_paper) {
+  Influence_Candidate oldest_influence = {0}, candidate;
+  Byte_Reader reader;
+  int w, pending;
+  int n = cluster->num_workers;
+
+  int owner = owner_shard(id_paper, n);
+  byte_buffer_put_zigzag(new_request(cluster, owner, MSG_START_REFERENCES),
+                         id_paper);
+  send_request(cluster, owner);
+  recv_reply(cluster, owner, &reader);
+  if (!byte_reader_varint(&reader)) {
+    return "None";
+  }
+
+  // The first level - its references, grouped by owner
+  read_mail(cluster, &reader);
+  begin_search(cluster, id_paper);
+
+  do {
+    for (w = 0; w < n; w++) {
+      if (cluster->mail[w].size) {
+        put_ids(new_request(cluster, w, MSG_EXPAND_REFERENCES),
+                &cluster->mail[w]);
+        send_request(cluster, w);
+      }
+    }
+
+    // Sent - the mailboxes take the next level
+    int asked[MAX_CLUSTER_WORKERS];
+    for (w = 0; w < n; w++) {
+      asked[w] = cluster->mail[w].size > 0;
+      cluster->mail[w].size = 0;
+    }
+
+    pending = 0;
+    for (w = 0; w < n; w++) {
+      if (asked[w]) {
+        recv_reply(cluster, w, &reader);
+        read_mail(cluster, &reader);
+        pending = 1;
+      }
+    }
+  } while (pending);
+
+  free(cluster->title);
+  cluster->title = NULL;
+  for (w = 0; w < n; w++) {
+    new_request(cluster, w, MSG_BEST);
+    send_request(cluster, w);
+  }
+  for (w = 0; w < n; w++) {
+    recv_reply(cluster, w, &reader);
+    if (!byte_reader_varint(&reader)) {
+      continue;
+    }
+
+    candidate.id = byte_reader_zigzag(&reader);
+    candidate.year = (int)byte_reader_zigzag(&reader);
+    candidate.citations = (int)byte_reader_zigzag(&reader);
+    char *title = byte_reader_string(&reader);
+    DIE(title == NULL, "cluster best");
+    candidate.title = title;
+
+    if (cluster->title == NULL ||
+        is_older_influence(&candidate, &oldest_influence)) {
+      free(cluster->title);
+      cluster->title = title;
+      oldest_influence = candidate;
+    } else {
+      free(title);
+    }
+  }
+
+  return cluster->title ? cluster->title : "None";
+}
+
+int cluster_get_number_of_influenced_papers(Publ_Cluster *cluster,
+                                            const int64_t id_paper,
+                                            const int max_dist) {
+  Byte_Reader reader;
+  int w, distance, cnt = 0;
+
+  if (max_dist <= 0) {
+    return 0;
+  }
+
+  begin_search(cluster, id_paper);
+
+  // The first level are the papers citing it - added or not (pending)
+  cluster->frontier.size = 0;
+  id_list_push(&cluster->frontier, id_paper);
+  for (distance = 0; distance < max_dist && cluster->frontier.size;
+       distance++) {
+    for (w = 0; w < cluster->num_workers; w++) {
+      put_ids(new_request(cluster, w, MSG_EXPAND_CITATIONS),
+              &cluster->frontier);
+      send_request(cluster, w);
+    }
+
+    cluster->frontier.size = 0;
+    for (w = 0; w < cluster->num_workers; w++) {
+      recv_reply(cluster, w, &reader);
+      read_ids(&reader, &cluster->frontier);
+      DIE(!reader.ok, "cluster frontier");
+    }
+    cnt += cluster->frontier.size;
+  }
+
+  return cnt;
+}
+
+/* ------------------------- Aggregates ------------------------- */
+float cluster_get_venue_impact_factor(Publ_Cluster *cluster,
+                                      const char *venue) {
+  Byte_Reader reader;
+  int64_t x = 0;
+  int w, cnt = 0;
+
+  for (w = 0; w < cluster->num_workers; w++) {
+    byte_buffer_put_string(new_request(cluster, w, MSG_VENUE), venue);
+    send_request(cluster, w);
+  }
+  for (w = 0; w < cluster->num_workers; w++) {
+    recv_reply(cluster, w, &reader);
+    x += byte_reader_zigzag(&reader);
+    cnt += (int)byte_reader_zigzag(&reader);
+  }
+
+  if (cnt) {
+    return (float)x / cnt;
+  }
+
+  return 0.f;
+}
+
+int cluster_get_number_of_papers_between_dates(Publ_Cluster *cluster,
+                                               const int early_date,
+                                               const int late_date) {
+  Byte_Reader reader;
+  int w, cnt = 0;
+
+  for (w = 0; w < cluster->num_workers; w++) {
+    Byte_Buffer *request = new_request(cluster, w, MSG_DATES);
+    byte_buffer_put_zigzag(request, early_date);
+    byte_buffer_put_zigzag(request, late_date);
+    send_request(cluster, w);
+  }
+  for (w = 0; w < cluster->num_workers; w++) {
+    recv_reply(cluster, w, &reader);
+    cnt += (int)byte_reader_zigzag(&reader);
+  }
+
+  return cnt;
+}
+
+int *cluster_get_histogram_of_citations(Publ_Cluster *cluster,
+                                        const int64_t id_author,
+                                        int *num_years) {
+  Byte_Reader reader;
+  int w, i;
+  int *histogram = NULL;
+
+  for (w = 0; w < cluster->num_workers; w++) {
+    byte_buffer_put_zigzag(new_request(cluster, w, MSG_HISTOGRAM), id_author);
+    send_request(cluster, w);
+  }
+
+  // Bins count back from CURR_YEAR - the longest one covers them all
+  *num_years = 0;
+  for (w = 0; w < cluster->num_workers; w++) {
+    recv_reply(cluster, w, &reader);
+    int count = (int)byte_reader_zigzag(&reader);
+    DIE(!reader.ok || count < 0, "cluster histogram");
+
+    if (count > *num_years) {
+      histogram = realloc(histogram, count * sizeof(int));
+      DIE(histogram == NULL, "histogram realloc");
+      memset(histogram + *num_years, 0,
+             (count - *num_years) * sizeof(int));
+      *num_years = count;
+    }
+    for (i = 0; i < count; i++) {
+      histogram[i] += (int)byte_reader_zigzag(&reader);
+    }
+  }
+
+  if (histogram == NULL) {
+    histogram = calloc(1, sizeof(int));
+    DIE(histogram == NULL, "histogram calloc");
+  }
+
+  return histogram;
+}
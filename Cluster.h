@@ -0,0 +1,110 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef CLUSTER_H_
+#define CLUSTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "./ByteBuffer.h"
+#include "./Hashtables.h"
+#include "./PaperOps.h"
+#include "./Shards.h"
+#include "./Transport.h"
+#include "./publications.h"
+
+#define MAX_CLUSTER_WORKERS 64
+
+/*
+ * Cluster - the shards of Shards.h, each one in a worker process of its
+ * own; the caller (the coordinator) holds no papers and talks to the
+ * workers over a Transport.
+ * The coordinator routes everything, the workers only answer it:
+ *   - a change goes to the shard owning the paper; the citation notes it
+ *     produces come back and go on to the cited papers' owners
+ *   - task 1: the references reached come back, grouped by owner, and go
+ *     on to the owners as the next level; the workers' best candidates are
+ *     compared at the end
+ *   - task 3: the frontier goes to every worker, the citing papers they
+ *     found make up the next one
+ *   - aggregates (tasks 2, 6, 8): every worker's part, merged
+ * A request goes out to every worker involved before any reply is read, so
+ * the workers run at the same time.
+ * One caller at a time.
+ */
+typedef struct Publ_Cluster {
+  int num_workers;
+  Transport *transport;  // Peer w - the worker of shard w
+  pid_t *pids;  // Of the forked workers (NULL - started by someone else)
+
+  Byte_Buffer *requests;  // One per worker
+  Byte_Buffer reply;
+  Citation_Notes *notes;  // For each worker, to be sent to it
+  Id_List *mail;  // Same, task 1 candidates
+  Id_List frontier;
+  char *title;  // Last answer to task 1
+} Publ_Cluster;
+
+/*
+ * Forks num_workers workers (<= 0 => one per online CPU, at most
+ * MAX_CLUSTER_WORKERS), connected by the socket transport
+ */
+Publ_Cluster *init_publ_cluster(int num_workers);
+
+/*
+ * A coordinator for workers started some other way: peer w of transport
+ * must be running run_cluster_worker(.., w, transport->num_peers)
+ */
+Publ_Cluster *attach_publ_cluster(Transport *transport);
+
+/* Stops the workers (and waits for the forked ones) */
+void destroy_publ_cluster(Publ_Cluster *cluster);
+
+/*
+ * The worker of shard s: answers the coordinator (peer 0 of transport)
+ * until it says to stop or goes away, then closes the transport
+ */
+void run_cluster_worker(Transport *transport, int s, int num_shards);
+
+/* Same as the Publ_Shards functions */
+void cluster_apply(Publ_Cluster *cluster, Paper_Op *ops, int num_ops);
+
+void cluster_add_paper(Publ_Cluster *cluster, const char *title,
+                       const char *venue, const int year,
+                       const char **author_names, const int64_t *author_ids,
+                       const char **institutions, const int num_authors,
+                       const char **fields, const int num_fields,
+                       const int64_t id, const int64_t *references,
+                       const int num_refs);
+
+void cluster_update_paper(Publ_Cluster *cluster, const char *title,
+                          const char *venue, const int year,
+                          const char **author_names, const int64_t *author_ids,
+                          const char **institutions, const int num_authors,
+                          const char **fields, const int num_fields,
+                          const int64_t id, const int64_t *references,
+                          const int num_refs);
+
+void cluster_remove_paper(Publ_Cluster *cluster, const int64_t id);
+
+/* The title stays valid until the next call */
+char *cluster_get_oldest_influence(Publ_Cluster *cluster,
+                                   const int64_t id_paper);
+
+float cluster_get_venue_impact_factor(Publ_Cluster *cluster,
+                                      const char *venue);
+
+int cluster_get_number_of_influenced_papers(Publ_Cluster *cluster,
+                                            const int64_t id_paper,
+                                            const int max_dist);
+
+int cluster_get_number_of_papers_between_dates(Publ_Cluster *cluster,
+                                               const int early_date,
+                                               const int late_date);
+
+int *cluster_get_histogram_of_citations(Publ_Cluster *cluster,
+                                        const int64_t id_author,
+                                        int *num_years);
+
+#endif /* CLUSTER_H_ */
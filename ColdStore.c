@@ -0,0 +1,89 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "./ColdStore.h"
+#include "./GenericHT.h"
+#include "./publications.h"
+
+int init_cold_store(Cold_Store *store, const char *path) {
+  if (store == NULL) {
+    return -1;
+  }
+
+  memset(store, 0, sizeof(Cold_Store));
+
+  store->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (store->fd < 0) {
+    return -1;
+  }
+
+  // Address space only - no memory is committed for it
+  store->base = mmap(NULL, COLD_STORE_RESERVE, PROT_NONE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (store->base == MAP_FAILED) {
+    close(store->fd);
+    unlink(path);
+    return -1;
+  }
+
+  store->path = copy_string(path);
+  return 0;
+}
+
+/* Maps one more chunk of the file, right after the mapped ones */
+static void map_next_chunk(Cold_Store *store) {
+  DIE(store->mapped + COLD_STORE_CHUNK > COLD_STORE_RESERVE,
+      "cold store full");
+
+  DIE(ftruncate(store->fd, store->mapped + COLD_STORE_CHUNK) < 0,
+      "cold store ftruncate");
+
+  void *chunk =
+      mmap(store->base + store->mapped, COLD_STORE_CHUNK,
+           PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, store->fd,
+           store->mapped);
+  DIE(chunk == MAP_FAILED, "cold store mmap");
+
+  // The full chunks go to disk and leave the resident set
+  if (store->mapped > store->resident) {
+    msync(store->base + store->resident, store->mapped - store->resident,
+          MS_ASYNC);
+    madvise(store->base + store->resident, store->mapped - store->resident,
+            MADV_DONTNEED);
+    store->resident = store->mapped;
+  }
+
+  store->mapped += COLD_STORE_CHUNK;
+}
+
+char *cold_store_string(Cold_Store *store, const char *string) {
+  size_t len = strlen(string) + 1;
+
+  while (store->size + len > store->mapped) {
+    map_next_chunk(store);
+  }
+
+  char *copy = store->base + store->size;
+  memcpy(copy, string, len);
+  store->size += len;
+
+  return copy;
+}
+
+void free_cold_store(Cold_Store *store) {
+  if (store == NULL) {
+    return;
+  }
+
+  munmap(store->base, COLD_STORE_RESERVE);
+  close(store->fd);
+  unlink(store->path);
+  free(store->path);
+}
@@ -0,0 +1,38 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef COLD_STORE_H_
+#define COLD_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define COLD_STORE_RESERVE (1ULL << 36)  // Address space kept for the file
+#define COLD_STORE_CHUNK (1ULL << 26)  // The file grows 64 MB at a time
+
+/*
+ * Cold Store - append-only, memory-mapped file for the cold strings
+ * (titles, venues, fields, author names, institutions).
+ * A big range of address space is reserved up front and the file is mapped
+ * into it chunk by chunk as it grows, so a string never moves and can be
+ * used as a plain char *. Every chunk that fills up is written back and
+ * dropped from the resident set; reading a string faults its page back in.
+ */
+typedef struct Cold_Store {
+  int fd;
+  char *path;
+  char *base;  // Start of the reserved range
+  size_t size;  // Bytes appended so far
+  size_t mapped;  // Bytes of the file mapped (whole chunks)
+  size_t resident;  // Bytes before it were dropped from the resident set
+} Cold_Store;
+
+/* Returns 0, or -1 if the file cannot be created / mapped */
+int init_cold_store(Cold_Store *store, const char *path);
+
+/* Appends a copy of the string, returning where it lives */
+char *cold_store_string(Cold_Store *store, const char *string);
+
+/* Unmaps and deletes the file */
+void free_cold_store(Cold_Store *store);
+
+#endif /* COLD_STORE_H_ */
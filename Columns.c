@@ -0,0 +1,244 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./Columns.h"
+#include "./publications.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define X86_KERNELS 1
+#endif
+
+void init_columns(Paper_Columns *columns) {
+  if (columns == NULL) {
+    return;
+  }
+
+  memset(columns, 0, sizeof(Paper_Columns));
+}
+
+static int32_t *grow_column(int32_t *column, int cap) {
+  column = realloc(column, cap * sizeof(int32_t));
+  DIE(column == NULL, "grow_column realloc");
+  return column;
+}
+
+void grow_columns(Paper_Columns *columns, int cap) {
+  if (columns == NULL || cap <= columns->cap) {
+    return;
+  }
+
+  columns->year = grow_column(columns->year, cap);
+  columns->venue = grow_column(columns->venue, cap);
+  columns->citations = grow_column(columns->citations, cap);
+  columns->num_authors = grow_column(columns->num_authors, cap);
+  columns->cap = cap;
+}
+
+int32_t *get_column(Paper_Columns *columns, Paper_Column column) {
+  switch (column) {
+    case COLUMN_YEAR:
+      return columns->year;
+    case COLUMN_VENUE:
+      return columns->venue;
+    case COLUMN_CITATIONS:
+      return columns->citations;
+    case COLUMN_NUM_AUTHORS:
+      return columns->num_authors;
+  }
+
+  return NULL;
+}
+
+void free_columns(Paper_Columns *columns) {
+  if (columns == NULL) {
+    return;
+  }
+
+  free(columns->year);
+  free(columns->venue);
+  free(columns->citations);
+  free(columns->num_authors);
+  free(columns);
+}
+
+/* ----------------------- Scalar kernels (tails) ----------------------- */
+static int64_t count_in_range_scalar(const int32_t *column,
+                                     const int32_t *year, int from, int n,
+                                     int32_t low, int32_t high) {
+  int64_t cnt = 0;
+  int i;
+
+  for (i = from; i < n; i++) {
+    cnt += column[i] >= low && column[i] <= high && year[i] != DEAD_YEAR;
+  }
+
+  return cnt;
+}
+
+static int64_t sum_in_range_scalar(const int32_t *values,
+                                   const int32_t *filter, const int32_t *year,
+                                   int from, int n, int32_t low,
+                                   int32_t high) {
+  int64_t sum = 0;
+  int i;
+
+  for (i = from; i < n; i++) {
+    if (filter[i] >= low && filter[i] <= high && year[i] != DEAD_YEAR) {
+      sum += values[i];
+    }
+  }
+
+  return sum;
+}
+
+#ifdef X86_KERNELS
+/*
+ * A lane is in range unless (low > x) or (x > high) or its paper is dead
+ * (year == DEAD_YEAR); the "in range" mask is -1 per lane, so subtracting it
+ * counts, and and-ing it with values sums.
+ */
+static int64_t count_in_range_sse2(const int32_t *column, const int32_t *year,
+                                   int n, int32_t low, int32_t high) {
+  const __m128i vlow = _mm_set1_epi32(low);
+  const __m128i vhigh = _mm_set1_epi32(high);
+  const __m128i vdead = _mm_set1_epi32(DEAD_YEAR);
+  const __m128i ones = _mm_set1_epi32(-1);
+  __m128i acc = _mm_setzero_si128();
+  int32_t lanes[4];
+  int i;
+
+  for (i = 0; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(column + i));
+    __m128i y = _mm_loadu_si128((const __m128i *)(year + i));
+    __m128i out =
+        _mm_or_si128(_mm_cmpgt_epi32(vlow, x), _mm_cmpgt_epi32(x, vhigh));
+    out = _mm_or_si128(out, _mm_cmpeq_epi32(y, vdead));
+    acc = _mm_sub_epi32(acc, _mm_andnot_si128(out, ones));
+  }
+
+  _mm_storeu_si128((__m128i *)lanes, acc);
+  return (int64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+         count_in_range_scalar(column, year, i, n, low, high);
+}
+
+static int64_t sum_in_range_sse2(const int32_t *values, const int32_t *filter,
+                                 const int32_t *year, int n, int32_t low,
+                                 int32_t high) {
+  const __m128i vlow = _mm_set1_epi32(low);
+  const __m128i vhigh = _mm_set1_epi32(high);
+  const __m128i vdead = _mm_set1_epi32(DEAD_YEAR);
+  __m128i acc_low = _mm_setzero_si128();
+  __m128i acc_high = _mm_setzero_si128();
+  int64_t lanes[4];
+  int i;
+
+  for (i = 0; i + 4 <= n; i += 4) {
+    __m128i f = _mm_loadu_si128((const __m128i *)(filter + i));
+    __m128i v = _mm_loadu_si128((const __m128i *)(values + i));
+    __m128i y = _mm_loadu_si128((const __m128i *)(year + i));
+    __m128i out =
+        _mm_or_si128(_mm_cmpgt_epi32(vlow, f), _mm_cmpgt_epi32(f, vhigh));
+    out = _mm_or_si128(out, _mm_cmpeq_epi32(y, vdead));
+    __m128i in = _mm_andnot_si128(out, v);
+
+    // Widening to 64 bits (sign-extended) before adding
+    __m128i sign = _mm_srai_epi32(in, 31);
+    acc_low = _mm_add_epi64(acc_low, _mm_unpacklo_epi32(in, sign));
+    acc_high = _mm_add_epi64(acc_high, _mm_unpackhi_epi32(in, sign));
+  }
+
+  _mm_storeu_si128((__m128i *)lanes, acc_low);
+  _mm_storeu_si128((__m128i *)(lanes + 2), acc_high);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+         sum_in_range_scalar(values, filter, year, i, n, low, high);
+}
+
+__attribute__((target("avx2"))) static int64_t count_in_range_avx2(
+    const int32_t *column, const int32_t *year, int n, int32_t low,
+    int32_t high) {
+  const __m256i vlow = _mm256_set1_epi32(low);
+  const __m256i vhigh = _mm256_set1_epi32(high);
+  const __m256i vdead = _mm256_set1_epi32(DEAD_YEAR);
+  const __m256i ones = _mm256_set1_epi32(-1);
+  __m256i acc = _mm256_setzero_si256();
+  int32_t lanes[8];
+  int64_t cnt = 0;
+  int i, j;
+
+  for (i = 0; i + 8 <= n; i += 8) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(column + i));
+    __m256i y = _mm256_loadu_si256((const __m256i *)(year + i));
+    __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(vlow, x),
+                                  _mm256_cmpgt_epi32(x, vhigh));
+    out = _mm256_or_si256(out, _mm256_cmpeq_epi32(y, vdead));
+    acc = _mm256_sub_epi32(acc, _mm256_andnot_si256(out, ones));
+  }
+
+  _mm256_storeu_si256((__m256i *)lanes, acc);
+  for (j = 0; j < 8; j++) {
+    cnt += lanes[j];
+  }
+
+  return cnt + count_in_range_scalar(column, year, i, n, low, high);
+}
+
+__attribute__((target("avx2"))) static int64_t sum_in_range_avx2(
+    const int32_t *values, const int32_t *filter, const int32_t *year, int n,
+    int32_t low, int32_t high) {
+  const __m256i vlow = _mm256_set1_epi32(low);
+  const __m256i vhigh = _mm256_set1_epi32(high);
+  const __m256i vdead = _mm256_set1_epi32(DEAD_YEAR);
+  __m256i acc = _mm256_setzero_si256();
+  int64_t lanes[4];
+  int i;
+
+  for (i = 0; i + 8 <= n; i += 8) {
+    __m256i f = _mm256_loadu_si256((const __m256i *)(filter + i));
+    __m256i v = _mm256_loadu_si256((const __m256i *)(values + i));
+    __m256i y = _mm256_loadu_si256((const __m256i *)(year + i));
+    __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(vlow, f),
+                                  _mm256_cmpgt_epi32(f, vhigh));
+    out = _mm256_or_si256(out, _mm256_cmpeq_epi32(y, vdead));
+    __m256i in = _mm256_andnot_si256(out, v);
+
+    // Widening to 64 bits (sign-extended) before adding
+    acc = _mm256_add_epi64(
+        acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(in)));
+    acc = _mm256_add_epi64(
+        acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(in, 1)));
+  }
+
+  _mm256_storeu_si256((__m256i *)lanes, acc);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+         sum_in_range_scalar(values, filter, year, i, n, low, high);
+}
+#endif
+
+int64_t count_in_range(const int32_t *column, const int32_t *year, int n,
+                       int32_t low, int32_t high) {
+#ifdef X86_KERNELS
+  if (__builtin_cpu_supports("avx2")) {
+    return count_in_range_avx2(column, year, n, low, high);
+  }
+  return count_in_range_sse2(column, year, n, low, high);
+#else
+  return count_in_range_scalar(column, year, 0, n, low, high);
+#endif
+}
+
+int64_t sum_in_range(const int32_t *values, const int32_t *filter,
+                     const int32_t *year, int n, int32_t low, int32_t high) {
+#ifdef X86_KERNELS
+  if (__builtin_cpu_supports("avx2")) {
+    return sum_in_range_avx2(values, filter, year, n, low, high);
+  }
+  return sum_in_range_sse2(values, filter, year, n, low, high);
+#else
+  return sum_in_range_scalar(values, filter, year, 0, n, low, high);
+#endif
+}
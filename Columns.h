@@ -0,0 +1,54 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef COLUMNS_H_
+#define COLUMNS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DEAD_YEAR INT32_MIN
+#define NO_VENUE -1
+
+/*
+ * Paper Columns
+ * The hot scalar attributes of every paper, each in its own contiguous
+ * array indexed by dense ID. Removed papers keep their slots, with a year of
+ * DEAD_YEAR and a venue of NO_VENUE; the scans skip them by checking the
+ * year column in the same pass (a range may well contain 0 citations).
+ */
+typedef struct Paper_Columns {
+  int32_t *year;
+  int32_t *venue;  // Dense venue ID (see add_venue)
+  int32_t *citations;
+  int32_t *num_authors;
+  int cap;
+} Paper_Columns;
+
+typedef enum paper_column {
+  COLUMN_YEAR,
+  COLUMN_VENUE,
+  COLUMN_CITATIONS,
+  COLUMN_NUM_AUTHORS
+} Paper_Column;
+
+void init_columns(Paper_Columns *columns);
+
+void grow_columns(Paper_Columns *columns, int cap);
+
+int32_t *get_column(Paper_Columns *columns, Paper_Column column);
+
+void free_columns(Paper_Columns *columns);
+
+/*
+ * Scan kernels - vectorized (SSE2, or AVX2 when the CPU has it)
+ * Only the i with year[i] != DEAD_YEAR (live papers) are considered.
+ * count_in_range: how many of column[0..n) are in [low, high]
+ * sum_in_range: sum of values[i] over the i with filter[i] in [low, high]
+ */
+int64_t count_in_range(const int32_t *column, const int32_t *year, int n,
+                       int32_t low, int32_t high);
+
+int64_t sum_in_range(const int32_t *values, const int32_t *filter,
+                     const int32_t *year, int n, int32_t low, int32_t high);
+
+#endif /* COLUMNS_H_ */
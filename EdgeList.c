@@ -0,0 +1,71 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./EdgeList.h"
+#include "./publications.h"
+
+#define EDGE_LIST_MIN_BYTES 8
+
+void edge_list_push(Edge_List *list, uint64_t value) {
+  if (list->len + VARINT_MAX_BYTES > list->cap) {
+    int cap = list->cap ? 2 * list->cap : EDGE_LIST_MIN_BYTES;
+    if (cap < list->len + VARINT_MAX_BYTES) {
+      cap = list->len + VARINT_MAX_BYTES;
+    }
+
+    list->bytes = realloc(list->bytes, cap);
+    DIE(list->bytes == NULL, "edge_list_push realloc");
+    list->cap = cap;
+  }
+
+  uint64_t delta = value - list->last;
+  while (delta >= 0x80u) {
+    list->bytes[list->len++] = (uint8_t)(delta | 0x80u);
+    delta >>= 7;
+  }
+  list->bytes[list->len++] = (uint8_t)delta;
+
+  list->last = value;
+  list->size++;
+}
+
+static int compare_values(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+void edge_list_build(Edge_List *list, uint64_t *values, int n) {
+  int i;
+
+  qsort(values, n, sizeof(uint64_t), compare_values);
+  for (i = 0; i < n; i++) {
+    edge_list_push(list, values[i]);
+  }
+}
+
+void edge_list_compact(Edge_List *list, struct paper **papers) {
+  Edge_List live = {0};
+  Edge_Iter it;
+  int idx;
+
+  edge_iter_init(&it, list);
+  while (edge_iter_next_idx(&it, &idx)) {
+    if (papers[idx]) {
+      edge_list_push(&live, idx);
+    }
+  }
+
+  edge_list_free(list);
+  *list = live;
+}
+
+void edge_list_free(Edge_List *list) {
+  free(list->bytes);
+  memset(list, 0, sizeof(Edge_List));
+}
@@ -0,0 +1,94 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef EDGE_LIST_H_
+#define EDGE_LIST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define VARINT_MAX_BYTES 10
+
+struct paper;
+
+/*
+ * Edge List - compressed list of neighbours
+ * The values are kept sorted and stored as deltas from the previous one, each
+ * delta as a varint (7 bits per byte, high bit = "more bytes follow").
+ * Dense IDs of nearby papers cost 1-2 bytes per edge instead of a 4-byte slot
+ * (or 8 bytes for raw paper IDs).
+ *
+ * Values can only be appended in non-decreasing order - which is how the graph
+ * grows anyway: a new paper always gets the biggest dense ID.
+ */
+typedef struct edge_list {
+  uint8_t *bytes;
+  int len;  // Bytes used
+  int cap;  // Bytes allocated
+  int size;  // No. values (dead dense IDs included)
+  uint64_t last;  // Last value - base of the next delta
+} Edge_List;
+
+void edge_list_push(Edge_List *list, uint64_t value);
+
+/* Sorts the values (in place) and appends them */
+void edge_list_build(Edge_List *list, uint64_t *values, int n);
+
+/* Drops the dense IDs of removed papers */
+void edge_list_compact(Edge_List *list, struct paper **papers);
+
+void edge_list_free(Edge_List *list);
+
+/*
+ * Decoding, one value at a time:
+ *   Edge_Iter it;
+ *   int idx;
+ *   edge_iter_init(&it, &list);
+ *   while (edge_iter_next_idx(&it, &idx)) { ... }
+ */
+typedef struct edge_iter {
+  const uint8_t *pos;
+  const uint8_t *end;
+  uint64_t value;
+} Edge_Iter;
+
+static inline void edge_iter_init(Edge_Iter *it, const Edge_List *list) {
+  it->pos = list->bytes;
+  it->end = list->bytes + list->len;
+  it->value = 0;
+}
+
+static inline int edge_iter_next(Edge_Iter *it, uint64_t *value) {
+  if (it->pos == it->end) {
+    return 0;
+  }
+
+  // Small deltas (the common case) fit in one byte
+  uint64_t delta = *it->pos++;
+  if (delta & 0x80u) {
+    unsigned shift = 7;
+    delta &= 0x7fu;
+    uint8_t byte;
+    do {
+      byte = *it->pos++;
+      delta |= (uint64_t)(byte & 0x7fu) << shift;
+      shift += 7;
+    } while (byte & 0x80u);
+  }
+
+  it->value += delta;
+  *value = it->value;
+  return 1;
+}
+
+static inline int edge_iter_next_idx(Edge_Iter *it, int *idx) {
+  uint64_t value;
+
+  if (!edge_iter_next(it, &value)) {
+    return 0;
+  }
+
+  *idx = (int)value;
+  return 1;
+}
+
+#endif /* EDGE_LIST_H_ */
@@ -0,0 +1,282 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef GENERIC_HT_H_
+#define GENERIC_HT_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HT_MIN_CAPACITY 16
+#define VECTOR_MIN_CAPACITY 4
+
+/*
+ * Key helpers - meant to be passed as the HASH / EQ / KEY_COPY / KEY_FREE
+ * arguments of DEFINE_HT, so they get inlined into every probe.
+ */
+static inline uint64_t hash_int64(int64_t key) {
+  /*
+   * splitmix64 finalizer - every one of the 64 bits of the id matters
+   * Credits: http://xorshift.di.unimi.it/splitmix64.c
+   */
+  uint64_t x = (uint64_t)key;
+
+  x = (x ^ (x >> 30u)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27u)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31u);
+}
+
+static inline uint64_t hash_string(const char *key) {
+  /*
+   * 64-bit FNV-1a
+   * Credits: http://www.isthe.com/chongo/tech/comp/fnv/
+   */
+  const unsigned char *puchar_key = (const unsigned char *)key;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+
+  while (*puchar_key) {
+    hash ^= *puchar_key++;
+    hash *= 0x100000001b3ULL;
+  }
+
+  return hash;
+}
+
+static inline int equal_int64(int64_t a, int64_t b) { return a == b; }
+
+static inline int equal_strings(const char *a, const char *b) {
+  return strcmp(a, b) == 0;
+}
+
+static inline char *copy_string(const char *key) {
+  size_t len = strlen(key) + 1;
+  char *copy = malloc(len);
+  if (copy == NULL) {
+    perror("copy_string malloc");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(copy, key, len);
+  return copy;
+}
+
+#define KEEP_KEY(key) (key)
+#define NO_FREE(x) ((void)(x))
+
+/*
+ * Growable array
+ * NAME##_push appends a (copied) element, doubling the capacity if needed.
+ * A zeroed NAME is a valid empty vector.
+ */
+#define DEFINE_VECTOR(NAME, PREFIX, T)                                         \
+  typedef struct NAME {                                                        \
+    T *items;                                                                  \
+    int size;                                                                  \
+    int cap;                                                                   \
+  } NAME;                                                                      \
+                                                                               \
+  static inline void PREFIX##_reserve(NAME *vec, int cap) {                    \
+    if (cap <= vec->cap) {                                                     \
+      return;                                                                  \
+    }                                                                          \
+    int new_cap = vec->cap ? vec->cap : VECTOR_MIN_CAPACITY;                   \
+    while (new_cap < cap) {                                                    \
+      new_cap *= 2;                                                            \
+    }                                                                          \
+    T *items = realloc(vec->items, new_cap * sizeof(T));                       \
+    if (items == NULL) {                                                       \
+      perror(#PREFIX "_reserve realloc");                                      \
+      exit(EXIT_FAILURE);                                                      \
+    }                                                                          \
+    vec->items = items;                                                        \
+    vec->cap = new_cap;                                                        \
+  }                                                                            \
+                                                                               \
+  static inline void PREFIX##_push(NAME *vec, T item) {                        \
+    if (vec->size == vec->cap) {                                               \
+      PREFIX##_reserve(vec, vec->size + 1);                                    \
+    }                                                                          \
+    vec->items[vec->size++] = item;                                            \
+  }                                                                            \
+                                                                               \
+  static inline void PREFIX##_free(NAME *vec) {                                \
+    free(vec->items);                                                          \
+    vec->items = NULL;                                                         \
+    vec->size = 0;                                                             \
+    vec->cap = 0;                                                              \
+  }
+
+/*
+ * Type-specialized hashtable
+ * Method - Open addressing, linear probing, backward-shift deletion
+ *
+ * NAME      - the generated struct
+ * PREFIX    - prefix of the generated functions (PREFIX##_get etc.)
+ * KEY_T     - key type, stored by value (pointers are copied with KEY_COPY)
+ * VAL_T     - value type, stored by value inside the slot
+ * HASH, EQ  - 64-bit hash and equality on keys, inlined into the probe loop
+ * KEY_COPY  - called once when a new key is inserted
+ * KEY_FREE  - called on the stored key when it is removed / destroyed
+ * VAL_FREE  - called with a pointer to the stored value on destruction
+ *
+ * Every slot keeps the low 31 bits of the hash (tag), so resizing and
+ * removing never rehash keys. A tag of 0 marks an empty slot.
+ * Pointers returned by _get / _put are valid until the next _put / _remove.
+ */
+#define DEFINE_HT(NAME, PREFIX, KEY_T, VAL_T, HASH, EQ, KEY_COPY, KEY_FREE,    \
+                  VAL_FREE)                                                    \
+  typedef struct PREFIX##_slot {                                               \
+    KEY_T key;                                                                 \
+    uint32_t tag;                                                              \
+    VAL_T value;                                                               \
+  } PREFIX##_slot;                                                             \
+                                                                               \
+  typedef struct NAME {                                                        \
+    PREFIX##_slot *slots;                                                      \
+    uint32_t mask; /* capacity - 1, capacity is a power of 2 */                \
+    int size;                                                                  \
+  } NAME;                                                                      \
+                                                                               \
+  static inline uint32_t PREFIX##_tag(KEY_T key) {                             \
+    return (uint32_t)HASH(key) | 0x80000000u;                                  \
+  }                                                                            \
+                                                                               \
+  static inline void PREFIX##_init(NAME *ht, int capacity) {                   \
+    uint32_t cap = HT_MIN_CAPACITY;                                            \
+    while ((int64_t)cap < capacity) {                                          \
+      cap <<= 1u;                                                              \
+    }                                                                          \
+    ht->slots = calloc(cap, sizeof(PREFIX##_slot));                            \
+    if (ht->slots == NULL) {                                                   \
+      perror(#NAME ": ht->slots calloc");                                      \
+      exit(EXIT_FAILURE);                                                      \
+    }                                                                          \
+    ht->mask = cap - 1;                                                        \
+    ht->size = 0;                                                              \
+  }                                                                            \
+                                                                               \
+  static inline VAL_T *PREFIX##_get(const NAME *ht, KEY_T key) {               \
+    uint32_t tag = PREFIX##_tag(key);                                          \
+    uint32_t i = tag & ht->mask;                                               \
+                                                                               \
+    /* Iterating through the run until keymatch or empty slot */               \
+    while (ht->slots[i].tag) {                                                 \
+      if (ht->slots[i].tag == tag && EQ(ht->slots[i].key, key)) {              \
+        return &ht->slots[i].value;                                            \
+      }                                                                        \
+      i = (i + 1) & ht->mask;                                                  \
+    }                                                                          \
+                                                                               \
+    /* Nothing found */                                                        \
+    return NULL;                                                               \
+  }                                                                            \
+                                                                               \
+  static inline void PREFIX##_grow(NAME *ht) {                                 \
+    PREFIX##_slot *old_slots = ht->slots;                                      \
+    uint32_t old_cap = ht->mask + 1;                                           \
+    uint32_t i;                                                                \
+                                                                               \
+    ht->slots = calloc((size_t)old_cap * 2, sizeof(PREFIX##_slot));            \
+    if (ht->slots == NULL) {                                                   \
+      perror(#NAME ": grow calloc");                                           \
+      exit(EXIT_FAILURE);                                                      \
+    }                                                                          \
+    ht->mask = old_cap * 2 - 1;                                                \
+                                                                               \
+    /* Moving the slots, tags already hold the hashes */                       \
+    for (i = 0; i < old_cap; i++) {                                            \
+      if (old_slots[i].tag) {                                                  \
+        uint32_t j = old_slots[i].tag & ht->mask;                              \
+        while (ht->slots[j].tag) {                                             \
+          j = (j + 1) & ht->mask;                                              \
+        }                                                                      \
+        ht->slots[j] = old_slots[i];                                           \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    free(old_slots);                                                           \
+  }                                                                            \
+                                                                               \
+  /* Returns the value of the key, inserting a zeroed one if missing */        \
+  static inline VAL_T *PREFIX##_put(NAME *ht, KEY_T key) {                     \
+    if ((uint64_t)(ht->size + 1) * 4 > (uint64_t)(ht->mask + 1) * 3) {        \
+      PREFIX##_grow(ht);                                                       \
+    }                                                                          \
+                                                                               \
+    uint32_t tag = PREFIX##_tag(key);                                          \
+    uint32_t i = tag & ht->mask;                                               \
+                                                                               \
+    while (ht->slots[i].tag) {                                                 \
+      if (ht->slots[i].tag == tag && EQ(ht->slots[i].key, key)) {              \
+        return &ht->slots[i].value;                                            \
+      }                                                                        \
+      i = (i + 1) & ht->mask;                                                  \
+    }                                                                          \
+                                                                               \
+    /* New key => claiming the empty slot */                                   \
+    memset(&ht->slots[i].value, 0, sizeof(VAL_T));                             \
+    ht->slots[i].key = KEY_COPY(key);                                          \
+    ht->slots[i].tag = tag;                                                    \
+    ht->size++;                                                                \
+    return &ht->slots[i].value;                                                \
+  }                                                                            \
+                                                                               \
+  /* Removes the key, moving its value into *value (if not NULL) */            \
+  static inline int PREFIX##_remove(NAME *ht, KEY_T key, VAL_T *value) {       \
+    uint32_t tag = PREFIX##_tag(key);                                          \
+    uint32_t i = tag & ht->mask;                                               \
+                                                                               \
+    while (ht->slots[i].tag) {                                                 \
+      if (ht->slots[i].tag == tag && EQ(ht->slots[i].key, key)) {              \
+        break;                                                                 \
+      }                                                                        \
+      i = (i + 1) & ht->mask;                                                  \
+    }                                                                          \
+    if (!ht->slots[i].tag) {                                                   \
+      return 0;                                                                \
+    }                                                                          \
+                                                                               \
+    if (value) {                                                               \
+      *value = ht->slots[i].value;                                             \
+    }                                                                          \
+    KEY_FREE(ht->slots[i].key);                                                \
+                                                                               \
+    /* Backward shift - pulling back the slots displaced past the hole */      \
+    uint32_t j = i;                                                            \
+    for (;;) {                                                                 \
+      ht->slots[i].tag = 0;                                                    \
+      uint32_t home;                                                           \
+      do {                                                                     \
+        j = (j + 1) & ht->mask;                                                \
+        if (!ht->slots[j].tag) {                                               \
+          ht->size--;                                                          \
+          return 1;                                                            \
+        }                                                                      \
+        home = ht->slots[j].tag & ht->mask;                                    \
+      } while (i <= j ? (i < home && home <= j) : (i < home || home <= j));    \
+      ht->slots[i] = ht->slots[j];                                             \
+      i = j;                                                                   \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static inline void PREFIX##_destroy(NAME *ht) {                              \
+    uint32_t i;                                                                \
+                                                                               \
+    for (i = 0; i <= ht->mask; i++) {                                          \
+      if (ht->slots[i].tag) {                                                  \
+        KEY_FREE(ht->slots[i].key);                                            \
+        VAL_FREE(&ht->slots[i].value);                                         \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    free(ht->slots);                                                           \
+    ht->slots = NULL;                                                          \
+    ht->size = 0;                                                              \
+  }
+
+/* Iterating through the occupied slots of a generated hashtable */
+#define HT_FOREACH(ht, slot)                                                   \
+  for ((slot) = (ht)->slots; (slot) <= (ht)->slots + (ht)->mask; (slot)++)     \
+    if ((slot)->tag)
+
+#endif /* GENERIC_HT_H_ */
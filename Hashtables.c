@@ -5,66 +5,39 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "./Columns.h"
 #include "./Hashtables.h"
 #include "./LinkedList.h"
 #include "./publications.h"
 #include "./utils.h"
 
-void init_cit_ht(struct Citations_HT *ht) {
-  if (ht == NULL) {
-    return;
-  }
-
-  // Initializing citations HT
-  ht->hmax = HMAX_BIG;
-  ht->hash_function = hash_function_int;
-  ht->compare_function = compare_function_ints;
+void compact_idx_list(Idx_List *list, struct paper **papers) {
+  int i, live = 0;
 
-  // Initializing buckets
-  ht->buckets = calloc(ht->hmax, sizeof(struct LinkedList));
-  DIE(ht->buckets == NULL, "Citations_HT: ht->buckets");
-
-  int i;
-  for (i = 0; i < ht->hmax; i++) {
-    init_list(&ht->buckets[i]);
+  for (i = 0; i < list->size; i++) {
+    if (papers[list->items[i]]) {
+      list->items[live++] = list->items[i];
+    }
   }
+  list->size = live;
 }
 
-void add_citation(struct Citations_HT *ht, int64_t cited_paper_id) {
+void init_cit_ht(Citations_HT *ht) {
   if (ht == NULL) {
     return;
   }
 
-  unsigned int hash = ht->hash_function(&cited_paper_id) % ht->hmax;
-  struct LinkedList *bucket = &ht->buckets[hash];
-
-  // Iterate through the bucket until keymatch
-  struct Node *it = bucket->head;
-  while (it) {
-    struct cited_paper *inside_data = (struct cited_paper *)it->data;
-    // Key match
-    if (ht->compare_function(inside_data->id, &cited_paper_id) == 0) {
-      // Already cited => updating count
-      inside_data->citations++;
-      return;
-    }
-    it = it->next;
-  }
-
-  // First citation => new element in bucket
-  struct cited_paper *new_paper = malloc(sizeof(cited_paper));
-  DIE(new_paper == NULL, "add_citations -> new_paper malloc");
-
-  // Allocating memory for key
-  new_paper->id = malloc(sizeof(cited_paper_id));
-  DIE(new_paper->id == NULL, "paper->id");
+  cit_ht_init(ht, HMAX_BIG);
+}
 
-  // Copying key
-  memcpy(new_paper->id, &cited_paper_id, sizeof(cited_paper_id));
-  new_paper->citations = FIRST_CITATION;
+void add_citation(Citations_HT *ht, int64_t cited_paper_id) {
+  if (ht == NULL) {
+    return;
+  }
 
-  // Add/chain => bascially appending to the current bucket
-  add_last_node(bucket, new_paper);
+  // First citation => new zeroed slot, otherwise updating count
+  int *citations = cit_ht_put(ht, cited_paper_id);
+  (*citations)++;
 }
 
 int get_no_citations(Citations_HT *ht, int64_t paper_id) {
@@ -72,421 +45,196 @@ int get_no_citations(Citations_HT *ht, int64_t paper_id) {
     return -1;
   }
 
-  unsigned int hash = ht->hash_function(&paper_id) % ht->hmax;
-  struct Node *it = ht->buckets[hash].head;
-
-  while (it) {
-    cited_paper *inside_data = (cited_paper *)it->data;
-    // Key match
-    if (ht->compare_function(inside_data->id, &paper_id) == 0) {
-      return inside_data->citations;
-    }
-    it = it->next;
+  int *citations = cit_ht_get(ht, paper_id);
+  if (citations) {
+    return *citations;
   }
 
   // Nothing found
   return 0;
 }
 
-void free_cit_ht(Citations_HT *ht) {
-  if (ht == NULL) {
-    return;
-  }
-
-  int i;
-  for (i = 0; i < ht->hmax; i++) {
-    struct LinkedList *bucket = &ht->buckets[i];
-    struct Node *it = bucket->head;
+int take_citations(Citations_HT *ht, int64_t paper_id) {
+  int citations = 0;
 
-    struct Node *prev;
-    while (it != NULL) {
-      prev = it;
-      it = it->next;
-
-      cited_paper *inside_data = (cited_paper *)prev->data;
-      free(inside_data->id);
-      free(inside_data);
-      free(prev);
-    }
+  if (ht == NULL) {
+    return 0;
   }
 
-  free(ht->buckets);
-  free(ht);
+  // Carrying the count over => the paper no longer needs a slot
+  cit_ht_remove(ht, paper_id, &citations);
+  return citations;
 }
 
-void init_venue_ht(Venue_HT *ht) {
+int remove_citation(Citations_HT *ht, int64_t cited_paper_id) {
   if (ht == NULL) {
-    return;
+    return 0;
   }
 
-  // Initializing venue HT
-  ht->hmax = HMAX_SMALL;
-  ht->hash_function = hash_function_string;
-  ht->compare_function = compare_function_strings;
-
-  // Initializing buckets
-  ht->buckets = calloc(ht->hmax, sizeof(struct LinkedList));
-  DIE(ht->buckets == NULL, "Venue_HT: ht->buckets");
-
-  int i;
-  for (i = 0; i < ht->hmax; i++) {
-    init_list(&ht->buckets[i]);
+  int *citations = cit_ht_get(ht, cited_paper_id);
+  if (citations == NULL) {
+    return 0;
   }
-}
 
-void add_venue(Venue_HT *ht, char *venue, int64_t id) {
-  if (ht == NULL) {
-    return;
+  // Last citation gone => the slot goes too
+  if (--(*citations) == 0) {
+    cit_ht_remove(ht, cited_paper_id, NULL);
+    return 0;
   }
 
-  unsigned int hash = ht->hash_function(venue) % ht->hmax;
-  struct LinkedList *bucket = &ht->buckets[hash];
-
-  venue_paper *new_paper = (venue_paper *)calloc(1, sizeof(venue_paper));
-  DIE(new_paper == NULL, "add_venue -> new_paper malloc");
-
-  // Allocating memory for key
-  new_paper->venue = calloc(strlen(venue) + 1, sizeof(char));
-  DIE(new_paper->venue == NULL, "new_paper->venue");
-
-  memcpy(new_paper->venue, venue,
-         (strlen(venue) + 1) * sizeof(char));  // copying key
-  new_paper->id = id;
-
-  // Add/chain => bascially appending to the current bucket
-  add_last_node(bucket, new_paper);
+  return *citations;
 }
 
-void free_venue_ht(Venue_HT *ht) {
+void free_cit_ht(Citations_HT *ht) {
   if (ht == NULL) {
     return;
   }
 
-  int i;
-  for (i = 0; i < ht->hmax; i++) {
-    struct LinkedList *bucket = &ht->buckets[i];
-    struct Node *it = bucket->head;
-
-    struct Node *prev;
-    while (it != NULL) {
-      prev = it;
-      it = it->next;
-
-      venue_paper *inside_data = (venue_paper *)prev->data;
-      free(inside_data->venue);
-      free(inside_data);
-      free(prev);
-    }
-  }
-
-  free(ht->buckets);
+  cit_ht_destroy(ht);
   free(ht);
 }
 
-void init_field_ht(struct Field_HT *ht) {
+void init_venue_ht(Venue_HT *ht) {
   if (ht == NULL) {
     return;
   }
 
-  // Initializing field HT
-  ht->hmax = HMAX_SMALL;
-  ht->hash_function = hash_function_string;
-  ht->compare_function = compare_function_strings;
-
-  // Initializing buckets
-  ht->buckets = calloc(ht->hmax, sizeof(struct LinkedList));
-  DIE(ht->buckets == NULL, "Field_HT: ht->buckets");
-
-  int i;
-  for (i = 0; i < ht->hmax; i++) {
-    init_list(&ht->buckets[i]);
-  }
+  venue_ht_init(ht, HMAX_SMALL);
 }
 
-void add_field(Field_HT *ht, char *field, int64_t id) {
+int add_venue(Venue_HT *ht, const char *venue, int paper_idx,
+              int *num_venues) {
   if (ht == NULL) {
-    return;
+    return NO_VENUE;
   }
 
-  unsigned int hash = ht->hash_function(field) % ht->hmax;
-  struct LinkedList *bucket = &ht->buckets[hash];
-
-  field_paper *new_paper = (field_paper *)malloc(sizeof(field_paper));
-  DIE(new_paper == NULL, "add_field -> new_paper malloc");
-
-  // Allocating memory for key
-  new_paper->field = (char *)calloc(strlen(field) + 1, sizeof(char));
-  DIE(new_paper->field == NULL, "new_paper->field");
-
-  // long size = sizeof(field);
-  memcpy(new_paper->field, field,
-         (strlen(field) + 1) * sizeof(char));  // copying key
-  new_paper->id = id;
-
-  // Add/chain => bascially appending to the current bucket
-  add_last_node(bucket, new_paper);
-}
-
-void free_field_ht(Field_HT *ht) {
-  if (ht == NULL) {
-    return;
+  Paper_Postings *postings = venue_ht_put(ht, venue);
+  if (postings->papers.items == NULL) {
+    postings->id = (*num_venues)++;
   }
 
-  int i;
-  for (i = 0; i < ht->hmax; i++) {
-    struct LinkedList *bucket = &ht->buckets[i];
-    struct Node *it = bucket->head;
+  // Appending to the venue's list (created on first paper)
+  idx_list_push(&postings->papers, paper_idx);
+  return postings->id;
+}
 
-    struct Node *prev;
-    while (it != NULL) {
-      prev = it;
-      it = it->next;
+/*
+ * Shared by venues & fields - one of the list's papers was removed
+ * Returns 1 if nothing alive is left in the list
+ */
+static int remove_posting(Paper_Postings *postings, struct paper **papers) {
+  postings->removed++;
 
-      field_paper *inside_data = (field_paper *)prev->data;
-      free(inside_data->field);
-      free(inside_data);
-      free(prev);
-    }
+  if (postings->removed == postings->papers.size) {
+    return 1;
   }
 
-  free(ht->buckets);
-  free(ht);
-}
-
-void init_authors_ht(Authors_HT *ht) {
-  if (ht == NULL) {
-    return;
+  if (2 * postings->removed > postings->papers.size) {
+    compact_idx_list(&postings->papers, papers);
+    postings->removed = 0;
   }
 
-  // Initializing authors HT
-  ht->hmax = HMAX_SMALL;
-  ht->hash_function = hash_function_int;
-  ht->compare_function = compare_function_ints;
-
-  // Initializing buckets
-  ht->buckets = calloc(ht->hmax, sizeof(struct LinkedList));
-  DIE(ht->buckets == NULL, "Authors_HT: ht->buckets");
-
-  int i;
-  for (i = 0; i < ht->hmax; i++) {
-    init_list(&ht->buckets[i]);
-  }
+  return 0;
 }
 
-void add_author(Authors_HT *ht, int64_t author_id, int64_t paper_id,
-                int paper_year) {
+int remove_venue(Venue_HT *ht, const char *venue, struct paper **papers) {
   if (ht == NULL) {
-    return;
+    return NO_VENUE;
   }
 
-  unsigned int hash = ht->hash_function(&author_id) % ht->hmax;
-  struct LinkedList *bucket = &ht->buckets[hash];
-
-  authors_paper *new_author = (authors_paper *)calloc(1, sizeof(authors_paper));
-  DIE(new_author == NULL, "add_author->new_author calloc");
-
-  // Allocating memory for key
-  new_author->author_id = calloc(1, sizeof(int64_t));
-  DIE(new_author->author_id == NULL, "new_author->author_id calloc");
-
-  memcpy(new_author->author_id, &author_id, sizeof(int64_t));  // copying key
-
-  // Values
-  new_author->paper_id = paper_id;
-  new_author->paper_year = paper_year;
+  Paper_Postings *postings = venue_ht_get(ht, venue);
+  if (postings && remove_posting(postings, papers)) {
+    Paper_Postings dead = {0};
+    venue_ht_remove(ht, venue, &dead);
+    free_paper_postings(&dead);
+    return dead.id;
+  }
 
-  // Add/chain => bascially appending to the current bucket
-  add_last_node(bucket, new_author);
+  return NO_VENUE;
 }
 
-void free_author_ht(Authors_HT *ht) {
+void free_venue_ht(Venue_HT *ht) {
   if (ht == NULL) {
     return;
   }
 
-  int i;
-  for (i = 0; i < ht->hmax; i++) {
-    struct LinkedList *bucket = &ht->buckets[i];
-    struct Node *it = bucket->head;
-
-    struct Node *prev;
-    while (it != NULL) {
-      prev = it;
-      it = it->next;
-
-      authors_paper *inside_data = (authors_paper *)prev->data;
-      free(inside_data->author_id);
-      free(inside_data);
-      free(prev);
-    }
-  }
-
-  free(ht->buckets);
+  venue_ht_destroy(ht);
   free(ht);
 }
 
-void init_influence_ht(Influence_HT *ht) {
+void init_field_ht(Field_HT *ht) {
   if (ht == NULL) {
     return;
   }
 
-  // Initializing authors HT
-  ht->hmax = HMAX_BIG;
-  ht->hash_function = hash_function_int;
-  ht->compare_function = compare_function_ints;
-
-  // Initializing buckets
-  ht->buckets = calloc(ht->hmax, sizeof(struct LinkedList));
-  DIE(ht->buckets == NULL, "Authors_HT: ht->buckets");
-
-  int i;
-  for (i = 0; i < ht->hmax; i++) {
-    init_list(&ht->buckets[i]);
-  }
+  field_ht_init(ht, HMAX_SMALL);
 }
 
-void add_influence(Influence_HT *ht, int64_t influencer_id,
-                   int64_t imitator_id) {
+void add_field(Field_HT *ht, const char *field, int paper_idx) {
   if (ht == NULL) {
     return;
   }
 
-  unsigned int hash = ht->hash_function(&influencer_id) % ht->hmax;
-  struct LinkedList *bucket = &ht->buckets[hash];
-
-  influenced_paper *new_influence =
-      (influenced_paper *)calloc(1, sizeof(influenced_paper));
-  DIE(new_influence == NULL, "add_influence->new_influence calloc");
-
-  // Allocating memory for key
-  new_influence->key = calloc(1, sizeof(int64_t));
-  DIE(new_influence->key == NULL, "new_influence->influence_id calloc");
-
-  memcpy(new_influence->key, &influencer_id, sizeof(int64_t));  // copying key
-
-  // Values
-  new_influence->value = imitator_id;
-
-  // Add/chain => bascially appending to the current bucket
-  add_last_node(bucket, new_influence);
+  // Appending to the field's list (created on first paper)
+  idx_list_push(&field_ht_put(ht, field)->papers, paper_idx);
 }
 
-void free_influence_ht(Influence_HT *ht) {
+void remove_field(Field_HT *ht, const char *field, struct paper **papers) {
   if (ht == NULL) {
     return;
   }
 
-  int i;
-  for (i = 0; i < ht->hmax; i++) {
-    struct LinkedList *bucket = &ht->buckets[i];
-    struct Node *it = bucket->head;
-
-    struct Node *prev;
-    while (it != NULL) {
-      prev = it;
-      it = it->next;
-
-      influenced_paper *inside_data = (influenced_paper *)prev->data;
-      free(inside_data->key);
-      free(inside_data);
-      free(prev);
-    }
+  Paper_Postings *postings = field_ht_get(ht, field);
+  if (postings && remove_posting(postings, papers)) {
+    Paper_Postings dead = {0};
+    field_ht_remove(ht, field, &dead);
+    free_paper_postings(&dead);
   }
-
-  free(ht->buckets);
-  free(ht);
 }
 
-void init_markings_ht(Markings_HT *ht) {
+void free_field_ht(Field_HT *ht) {
   if (ht == NULL) {
     return;
   }
 
-  // Initializing authors HT
-  ht->hmax = HMAX_BIG;
-  ht->hash_function = hash_function_int;
-  ht->compare_function = compare_function_ints;
-
-  // Initializing buckets
-  ht->buckets = calloc(ht->hmax, sizeof(struct LinkedList));
-  DIE(ht->buckets == NULL, "Authors_HT: ht->buckets");
-
-  int i;
-  for (i = 0; i < ht->hmax; i++) {
-    init_list(&ht->buckets[i]);
-  }
+  field_ht_destroy(ht);
+  free(ht);
 }
 
-void add_marking(Markings_HT *ht, int64_t paper_id, int new_distance) {
+void init_pending_ht(Pending_HT *ht) {
   if (ht == NULL) {
     return;
   }
 
-  unsigned int hash = ht->hash_function(&paper_id) % ht->hmax;
-  struct LinkedList *bucket = &ht->buckets[hash];
-
-  // Each marking is unique
-  struct marking *new_marking = malloc(sizeof(marking));
-  DIE(new_marking == NULL, "add_marking -> new_marking malloc");
-
-  // Allocating memory for key
-  new_marking->id = malloc(sizeof(marking));
-  DIE(new_marking->id == NULL, "new_marking->id");
-
-  memcpy(new_marking->id, &paper_id, sizeof(paper_id));  // copying key
-  new_marking->visited = 1;
-  new_marking->distance = new_distance;
-
-  // Add/chain => bascially appending to the current bucket
-  add_last_node(bucket, new_marking);
+  pending_ht_init(ht, HMAX_BIG);
 }
 
-marking *get_markings(Markings_HT *ht, int64_t paper_id) {
+void add_pending(Pending_HT *ht, int64_t cited_id, int citing_idx) {
   if (ht == NULL) {
-    return NULL;
+    return;
   }
 
-  unsigned int hash = ht->hash_function(&paper_id) % ht->hmax;
-  struct LinkedList *bucket = &ht->buckets[hash];
+  // Appending to the cited paper's waiting list (created on first edge)
+  idx_list_push(pending_ht_put(ht, cited_id), citing_idx);
+}
 
-  struct Node *it = bucket->head;
+Idx_List take_pending(Pending_HT *ht, int64_t cited_id) {
+  Idx_List waiting = {0};
 
-  // Iterating through the bucket until keymatch
-  while (it) {
-    marking *inside_data = (marking *)it->data;
-    // Key match
-    if (ht->compare_function(inside_data->id, &paper_id) == 0) {
-      return inside_data;
-    }
-    it = it->next;
+  if (ht == NULL) {
+    return waiting;
   }
 
-  // Nothing found
-  return NULL;
+  // The edges are handed over => the paper no longer needs a slot
+  pending_ht_remove(ht, cited_id, &waiting);
+  return waiting;
 }
 
-void free_markings_ht(Markings_HT *ht) {
+void free_pending_ht(Pending_HT *ht) {
   if (ht == NULL) {
     return;
   }
 
-  int i;
-  for (i = 0; i < ht->hmax; i++) {
-    struct LinkedList *bucket = &ht->buckets[i];
-    struct Node *it = bucket->head;
-
-    struct Node *prev;
-    while (it != NULL) {
-      prev = it;
-      it = it->next;
-
-      marking *inside_data = (marking *)prev->data;
-      free(inside_data->id);
-      free(inside_data);
-      free(prev);
-    }
-  }
-
-  free(ht->buckets);
+  pending_ht_destroy(ht);
   free(ht);
 }
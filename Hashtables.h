@@ -6,31 +6,64 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "./GenericHT.h"
+
 #define HMAX_BIG 5003
 #define HMAX_SMALL 503
 #define FIRST_CITATION 1
 #define LEN_TITLE 300
-#define LEN_NAME 300
-#define MAX_AUTHORS 30
 #define NMAX 20000
 #define UNVISITED 0
 
-/* Citations Hashtable
+#define FREE_STRING(key) free((char *)(key))
+
+struct paper;
+
+/* Lists of paper IDs - values of the one-to-many hashtables */
+DEFINE_VECTOR(Id_List, id_list, int64_t)
+
+static inline void free_id_list(Id_List *list) { id_list_free(list); }
+
+/* Lists of dense paper indices (positions in PublData->papers) */
+DEFINE_VECTOR(Idx_List, idx_list, int)
+
+static inline void free_idx_list(Idx_List *list) { idx_list_free(list); }
+
+/*
+ * Removed papers leave their (dead) dense IDs behind in the lists.
+ * They are skipped by the queries and dropped once they make up half of a
+ * list, so removing a paper never scans a whole list.
+ */
+void compact_idx_list(Idx_List *list, struct paper **papers);
+
+/*
+ * Papers of a venue / field, with the number of dead entries and the
+ * generation of the last change (see Query_Cache)
+ */
+typedef struct paper_postings {
+  Idx_List papers;
+  int removed;
+  uint64_t generation;
+  int id;  // Dense venue ID (venues only, see add_venue)
+} Paper_Postings;
+
+static inline void free_paper_postings(Paper_Postings *postings) {
+  idx_list_free(&postings->papers);
+}
+
+/* Papers Hashtable (the "big" one, inside PublData)
  * Key - ID
- * Value - No. Citations
- * Method - Direct Chaining
+ * Value - the paper itself
+ */
+DEFINE_HT(Papers_HT, papers_ht, int64_t, struct paper *, hash_int64,
+          equal_int64, KEEP_KEY, NO_FREE, NO_FREE)
+
+/* Citations Hashtable
+ * Key - ID of a paper that was not added yet
+ * Value - No. Citations, carried over to its stats when it gets added
  */
-typedef struct cited_paper {
-  int64_t *id;
-  int citations;
-} cited_paper;
-
-typedef struct Citations_HT {
-  struct LinkedList *buckets; /* Array of simply-linked buckets */
-  int hmax;
-  unsigned int (*hash_function)(void *);
-  int (*compare_function)(void *, void *);
-} Citations_HT;
+DEFINE_HT(Citations_HT, cit_ht, int64_t, int, hash_int64, equal_int64,
+          KEEP_KEY, NO_FREE, NO_FREE)
 
 void init_cit_ht(Citations_HT *ht);
 
@@ -38,127 +71,61 @@ void add_citation(Citations_HT *ht, int64_t cited_paper_id);
 
 int get_no_citations(Citations_HT *ht, int64_t paper_id);
 
+int take_citations(Citations_HT *ht, int64_t paper_id);
+
+int remove_citation(Citations_HT *ht, int64_t cited_paper_id);
+
 void free_cit_ht(Citations_HT *ht);
 
 /* Venue Hashtable
  * Key - Venue
  * Value - Papers published at that venue
- * Method - Direct Chaining
  */
-typedef struct venue_paper {
-  char *venue;
-  int64_t id;
-} venue_paper;
-
-typedef struct Venue_HT {
-  struct LinkedList *buckets; /* Array of simply-linked buckets */
-  int hmax;
-  unsigned int (*hash_function)(void *);
-  int (*compare_function)(void *, void *);
-} Venue_HT;
+DEFINE_HT(Venue_HT, venue_ht, const char *, Paper_Postings, hash_string,
+          equal_strings, copy_string, FREE_STRING, free_paper_postings)
 
 void init_venue_ht(Venue_HT *ht);
 
-void add_venue(Venue_HT *ht, char *venue, int64_t id);
+/*
+ * Returns the venue's dense ID; a new venue gets *num_venues, which is then
+ * incremented
+ */
+int add_venue(Venue_HT *ht, const char *venue, int paper_idx,
+              int *num_venues);
+
+/* Returns the venue's dense ID if it was its last paper, NO_VENUE otherwise */
+int remove_venue(Venue_HT *ht, const char *venue, struct paper **papers);
 
 void free_venue_ht(Venue_HT *ht);
 
 /* Field Hashtable
  * Key - Field
  * Value - Papers published wihtin that field
- * Method - Direct Chaining
  */
-typedef struct field_paper {
-  char *field;
-  int64_t id;
-} field_paper;
-
-typedef struct Field_HT {
-  struct LinkedList *buckets; /* Array of simply-linked buckets */
-  int hmax;
-  unsigned int (*hash_function)(void *);
-  int (*compare_function)(void *, void *);
-} Field_HT;
+DEFINE_HT(Field_HT, field_ht, const char *, Paper_Postings, hash_string,
+          equal_strings, copy_string, FREE_STRING, free_paper_postings)
 
 void init_field_ht(Field_HT *ht);
 
-void add_field(Field_HT *ht, char *field, int64_t id);
+void add_field(Field_HT *ht, const char *field, int paper_idx);
 
-void free_field_ht(Field_HT *ht);
+void remove_field(Field_HT *ht, const char *field, struct paper **papers);
 
-/* Authors Hashtable
- * Key - Author ID
- * Value - Papers published by that author (represented by their ID)
- * Method - Direct Chaining
- */
-typedef struct authors_paper {
-  int64_t *author_id;
-  int64_t paper_id;
-  int paper_year;
-} authors_paper;
-
-typedef struct Authors_HT {
-  struct LinkedList *buckets; /* Array of simply-linked buckets */
-  int hmax;
-  unsigned int (*hash_function)(void *);
-  int (*compare_function)(void *, void *);
-} Authors_HT;
-
-void init_authors_ht(Authors_HT *ht);
-
-void add_author(Authors_HT *ht, int64_t author_id, int64_t paper_id,
-                int paper_year);
-
-void free_author_ht(Authors_HT *ht);
-
-/* Influenced Papers Hashtable
- * Key - Paper X (ID)
- * Value - Papers which X influences (IDs)
- * Method - Direct Chaining
- */
-typedef struct influenced_paper {
-  int64_t *key;  // influencer paper id
-  int64_t value;  // influenced paper id
-} influenced_paper;
-
-typedef struct Influence_HT {
-  struct LinkedList *buckets; /* Array of simply-linked buckets */
-  int hmax;
-  unsigned int (*hash_function)(void *);
-  int (*compare_function)(void *, void *);
-} Influence_HT;
-
-void init_influence_ht(Influence_HT *ht);
-
-void add_influence(Influence_HT *ht, int64_t influencer_id,
-                   int64_t imitator_id);
-
-void free_influence_ht(Influence_HT *ht);
+void free_field_ht(Field_HT *ht);
 
-/* Markings Hashtable
- * Key - Paper ID
- * Value(s) - visited status & distance to origin
- * Method - Direct Chaining
+/* Pending Edges Hashtable
+ * Key - Paper X (ID), not added yet
+ * Value - Added papers which reference X (dense IDs), waiting for X
  */
-typedef struct marking {
-  int64_t *id;
-  int visited;
-  int distance;
-} marking;
-
-typedef struct Markings_HT {
-  struct LinkedList *buckets; /* Array of simply-linked buckets */
-  int hmax;
-  unsigned int (*hash_function)(void *);
-  int (*compare_function)(void *, void *);
-} Markings_HT;
+DEFINE_HT(Pending_HT, pending_ht, int64_t, Idx_List, hash_int64, equal_int64,
+          KEEP_KEY, NO_FREE, free_idx_list)
 
-void init_markings_ht(Markings_HT *ht);
+void init_pending_ht(Pending_HT *ht);
 
-void add_marking(Markings_HT *ht, int64_t paper_id, int new_distance);
+void add_pending(Pending_HT *ht, int64_t cited_id, int citing_idx);
 
-marking *get_markings(Markings_HT *ht, int64_t paper_id);
+Idx_List take_pending(Pending_HT *ht, int64_t cited_id);
 
-void free_markings_ht(Markings_HT *ht);
+void free_pending_ht(Pending_HT *ht);
 
 #endif /* DATA_STRUCTURES_H_ */
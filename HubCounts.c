@@ -0,0 +1,164 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./EdgeList.h"
+#include "./Hashtables.h"
+#include "./HubCounts.h"
+#include "./publications.h"
+#include "./utils.h"
+
+void init_hub_counts(Hub_Counts *hub_counts, int max_dist, int min_degree,
+                     int cap) {
+  memset(hub_counts, 0, sizeof(Hub_Counts));
+  hub_counts->max_dist = max_dist;
+  hub_counts->min_degree = min_degree > 0 ? min_degree : 1;
+  grow_hub_counts(hub_counts, cap);
+}
+
+void grow_hub_counts(Hub_Counts *hub_counts, int cap) {
+  int i;
+
+  if (hub_counts == NULL || cap <= hub_counts->cap) {
+    return;
+  }
+
+  hub_counts->slots = realloc(hub_counts->slots, cap * sizeof(int));
+  DIE(hub_counts->slots == NULL, "hub_counts->slots realloc");
+  for (i = hub_counts->cap; i < cap; i++) {
+    hub_counts->slots[i] = -1;
+  }
+  hub_counts->cap = cap;
+}
+
+void check_hub_degree(PublData *data, int idx) {
+  Hub_Counts *hub_counts = data->hub_counts;
+
+  if (hub_counts->slots[idx] >= 0 ||
+      data->stats[idx].in_degree < hub_counts->min_degree) {
+    return;
+  }
+
+  if (hub_counts->num_hubs == hub_counts->cap_hubs) {
+    hub_counts->cap_hubs = hub_counts->cap_hubs ? 2 * hub_counts->cap_hubs : 16;
+    hub_counts->hubs = realloc(hub_counts->hubs,
+                               hub_counts->cap_hubs * sizeof(Hub_Entry));
+    DIE(hub_counts->hubs == NULL, "hub_counts->hubs realloc");
+  }
+
+  // Counted when it is first needed
+  Hub_Entry *hub = &hub_counts->hubs[hub_counts->num_hubs];
+  hub->idx = idx;
+  hub->generation = 0;
+  hub->levels = 0;
+  hub->counts = calloc(hub_counts->max_dist, sizeof(int));
+  DIE(hub->counts == NULL, "hub->counts calloc");
+  hub_counts->slots[idx] = hub_counts->num_hubs++;
+}
+
+/* One BFS, level by level */
+static void count_hub(PublData *data, Hub_Entry *hub, int max_dist) {
+  Traversal_Scratch *scratch = begin_traversal(data);
+  Idx_List visited = {0};
+  Edge_Iter it;
+  int i, j, cnt = 0, distance = 0;
+
+  hub->generation = data->region_generation[get_region(data, hub->idx)];
+  hub->levels = 0;
+
+  visit_paper(scratch, hub->idx);
+  idx_list_push(&visited, hub->idx);
+
+  int level_start = 0;
+  while (distance < max_dist) {
+    int level_end = visited.size;
+
+    for (i = level_start; i < level_end; i++) {
+      edge_iter_init(&it, &data->papers[visited.items[i]]->influenced);
+      while (edge_iter_next_idx(&it, &j)) {
+        if (data->papers[j] && visit_paper(scratch, j)) {
+          idx_list_push(&visited, j);
+          cnt++;
+        }
+      }
+    }
+    hub->counts[distance++] = cnt;
+
+    // Nothing more to reach - the rest of the distances have the same count
+    level_start = level_end;
+    if (level_start == visited.size) {
+      for (; distance < max_dist; distance++) {
+        hub->counts[distance] = cnt;
+      }
+    }
+  }
+  hub->levels = distance;
+
+  idx_list_free(&visited);
+}
+
+static int is_fresh(PublData *data, Hub_Entry *hub) {
+  return hub->levels == data->hub_counts->max_dist &&
+         hub->generation ==
+             data->region_generation[get_region(data, hub->idx)];
+}
+
+Hub_Entry *get_hub_entry(PublData *data, int idx) {
+  Hub_Counts *hub_counts = data->hub_counts;
+
+  if (hub_counts == NULL || hub_counts->slots[idx] < 0) {
+    return NULL;
+  }
+
+  // Stale => the caller searches (only the writer recounts)
+  Hub_Entry *hub = &hub_counts->hubs[hub_counts->slots[idx]];
+  return is_fresh(data, hub) ? hub : NULL;
+}
+
+void refresh_hubs(PublData *data) {
+  Hub_Counts *hub_counts = data->hub_counts;
+  int i = 0;
+
+  if (hub_counts == NULL) {
+    return;
+  }
+
+  while (i < hub_counts->num_hubs) {
+    Hub_Entry *hub = &hub_counts->hubs[i];
+
+    // Removed, or down to half the citers it became a hub with
+    if (data->papers[hub->idx] == NULL ||
+        2 * data->stats[hub->idx].in_degree < hub_counts->min_degree) {
+      hub_counts->slots[hub->idx] = -1;
+      free(hub->counts);
+      *hub = hub_counts->hubs[--hub_counts->num_hubs];
+      if (i < hub_counts->num_hubs) {
+        hub_counts->slots[hub->idx] = i;
+      }
+      continue;
+    }
+
+    if (!is_fresh(data, hub)) {
+      count_hub(data, hub, hub_counts->max_dist);
+    }
+    i++;
+  }
+}
+
+void free_hub_counts(Hub_Counts *hub_counts) {
+  int i;
+
+  if (hub_counts == NULL) {
+    return;
+  }
+
+  for (i = 0; i < hub_counts->num_hubs; i++) {
+    free(hub_counts->hubs[i].counts);
+  }
+  free(hub_counts->hubs);
+  free(hub_counts->slots);
+  free(hub_counts);
+}
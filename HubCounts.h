@@ -0,0 +1,55 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef HUB_COUNTS_H_
+#define HUB_COUNTS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct publications_data;
+
+/*
+ * Hub Counts - exact k-hop influence counts, materialized for the hubs
+ * A hub is a paper cited by at least min_degree added papers (in_degree):
+ * one of the few whose searches sweep a big part of the graph. Each one
+ * keeps the answers of task 3 for every distance 1 .. max_dist, all from a
+ * single BFS (the sizes of its levels, added up).
+ * The counts hold as long as the generation of the hub's region does not
+ * change (like the query cache's); a change near a hub only makes them
+ * stale - the queries then search as usual, until the writer recounts all
+ * the stale hubs at once with refresh_hub_counts (after a batch of changes).
+ */
+typedef struct hub_entry {
+  int idx;  // Dense ID
+  uint64_t generation;  // Of its region, when counted (0 - never)
+  int levels;  // Distances counted - counts[0 .. levels) are exact
+  int *counts;  // [d - 1] - papers it influenced up to distance d
+} Hub_Entry;
+
+typedef struct Hub_Counts {
+  int max_dist;
+  int min_degree;
+  int *slots;  // By dense ID - its entry in hubs, -1 if it is not a hub
+  int cap;
+  Hub_Entry *hubs;
+  int num_hubs;
+  int cap_hubs;
+} Hub_Counts;
+
+void init_hub_counts(Hub_Counts *hub_counts, int max_dist, int min_degree,
+                     int cap);
+
+void grow_hub_counts(Hub_Counts *hub_counts, int cap);
+
+/* The paper got more citers - it becomes a hub once it has enough */
+void check_hub_degree(struct publications_data *data, int idx);
+
+/* The paper's counts - NULL if it is not a hub or they are stale. Read-only */
+Hub_Entry *get_hub_entry(struct publications_data *data, int idx);
+
+/* Drops the hubs removed since, recounts the stale ones */
+void refresh_hubs(struct publications_data *data);
+
+void free_hub_counts(Hub_Counts *hub_counts);
+
+#endif /* HUB_COUNTS_H_ */
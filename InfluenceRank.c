@@ -0,0 +1,373 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./EdgeList.h"
+#include "./Hashtables.h"
+#include "./InfluenceRank.h"
+#include "./ThreadPool.h"
+#include "./publications.h"
+#include "./utils.h"
+
+/* The citations of RANK_ROW_CHUNK papers, sorted by block */
+typedef struct rank_chunk {
+  int num_edges;
+  uint16_t *rows;  // The cited paper, as an offset in the chunk
+  int *sources;  // The citing paper
+} Rank_Chunk;
+
+/*
+ * One run - the papers still added get compact IDs (0 .. n - 1, in dense ID
+ * order), so the vectors have no holes
+ */
+typedef struct rank_run {
+  PublData *data;
+  int n;
+  int *dense;  // Compact ID -> dense ID
+  int *compact;  // Dense ID -> compact ID (-1 - removed)
+  int *out_degree;  // By compact ID
+  Rank_Chunk *chunks;
+  int num_chunks;
+  int num_blocks;
+  atomic_int next_chunk;
+
+  double damping;
+  double base;  // (1 - d) / n + the dangling score's share
+  double *rank;
+  double *next;
+  double *contrib;  // rank / out-degree (0 - cites nothing)
+  double *next_contrib;
+  double *dangling;  // By chunk, so the sums do not depend on the workers
+  double *residual;
+} Rank_Run;
+
+/* ------------------------- Building ------------------------- */
+static void build_chunk(Rank_Run *run, int c) {
+  Paper **papers = run->data->papers;
+  Rank_Chunk *chunk = &run->chunks[c];
+  Idx_List rows = {0}, sources = {0};
+  Edge_Iter it;
+  int i, j, v, block;
+
+  int first = c * RANK_ROW_CHUNK;
+  int last = first + RANK_ROW_CHUNK < run->n ? first + RANK_ROW_CHUNK : run->n;
+
+  // The edge lists are decoded once, then sorted by block (counting sort)
+  int *offsets = calloc(run->num_blocks + 1, sizeof(int));
+  DIE(offsets == NULL, "offsets calloc");
+
+  for (v = first; v < last; v++) {
+    int idx = run->dense[v];
+
+    // Kept up to date by add_paper / remove_paper
+    run->out_degree[v] = run->data->stats[idx].out_degree;
+
+    edge_iter_init(&it, &papers[idx]->influenced);
+    while (edge_iter_next_idx(&it, &j)) {
+      if (run->compact[j] >= 0) {
+        idx_list_push(&rows, v - first);
+        idx_list_push(&sources, run->compact[j]);
+        offsets[run->compact[j] / RANK_BLOCK + 1]++;
+      }
+    }
+  }
+
+  for (block = 0; block < run->num_blocks; block++) {
+    offsets[block + 1] += offsets[block];
+  }
+  chunk->num_edges = sources.size;
+
+  // A chunk of papers nobody cites still gets (1-element) arrays
+  int cap = chunk->num_edges ? chunk->num_edges : 1;
+  chunk->rows = malloc(cap * sizeof(uint16_t));
+  DIE(chunk->rows == NULL, "chunk->rows malloc");
+  chunk->sources = malloc(cap * sizeof(int));
+  DIE(chunk->sources == NULL, "chunk->sources malloc");
+
+  for (i = 0; i < sources.size; i++) {
+    j = offsets[sources.items[i] / RANK_BLOCK]++;
+    chunk->rows[j] = (uint16_t)rows.items[i];
+    chunk->sources[j] = sources.items[i];
+  }
+
+  free(offsets);
+  idx_list_free(&rows);
+  idx_list_free(&sources);
+}
+
+static void build_chunks(void *arg, int worker) {
+  Rank_Run *run = arg;
+  int c;
+
+  (void)worker;
+  while ((c = atomic_fetch_add(&run->next_chunk, 1)) < run->num_chunks) {
+    build_chunk(run, c);
+  }
+}
+
+/* ------------------------- Iterating ------------------------- */
+static void iterate_chunk(Rank_Run *run, int c) {
+  const Rank_Chunk *chunk = &run->chunks[c];
+  const double *contrib = run->contrib;
+  double dangling = 0, residual = 0;
+  int i, v;
+
+  int first = c * RANK_ROW_CHUNK;
+  int last = first + RANK_ROW_CHUNK < run->n ? first + RANK_ROW_CHUNK : run->n;
+
+  // Block by block - contrib is only read inside the current one
+  double *sums = run->next + first;
+  memset(sums, 0, (last - first) * sizeof(double));
+  for (i = 0; i < chunk->num_edges; i++) {
+    sums[chunk->rows[i]] += contrib[chunk->sources[i]];
+  }
+
+  for (v = first; v < last; v++) {
+    double score = run->base + run->damping * run->next[v];
+
+    residual += fabs(score - run->rank[v]);
+    run->next[v] = score;
+    if (run->out_degree[v]) {
+      run->next_contrib[v] = score / run->out_degree[v];
+    } else {
+      run->next_contrib[v] = 0;
+      dangling += score;
+    }
+  }
+
+  run->dangling[c] = dangling;
+  run->residual[c] = residual;
+}
+
+static void iterate_chunks(void *arg, int worker) {
+  Rank_Run *run = arg;
+  int c;
+
+  (void)worker;
+  while ((c = atomic_fetch_add(&run->next_chunk, 1)) < run->num_chunks) {
+    iterate_chunk(run, c);
+  }
+}
+
+static void run_round(Thread_Pool *pool, Rank_Run *run, pool_task task) {
+  atomic_store(&run->next_chunk, 0);
+
+  if (pool) {
+    run_on_pool(pool, task, run);
+  } else {
+    task(run, 0);
+  }
+}
+
+static double *alloc_vector(int n) {
+  double *vector = malloc((n ? n : 1) * sizeof(double));
+  DIE(vector == NULL, "vector malloc");
+
+  return vector;
+}
+
+static void swap_vectors(double **a, double **b) {
+  double *aux = *a;
+  *a = *b;
+  *b = aux;
+}
+
+void compute_influence_ranks(PublData *data, Thread_Pool *pool,
+                             Influence_Ranks *ranks, double damping,
+                             double tolerance, int max_iterations) {
+  Rank_Run run;
+  int i, c, v;
+
+  memset(&run, 0, sizeof(Rank_Run));
+  run.data = data;
+  run.damping = damping;
+
+  free(ranks->scores);
+  ranks->scores = calloc(data->num_papers + 1, sizeof(double));
+  DIE(ranks->scores == NULL, "ranks->scores calloc");
+  ranks->num_papers = data->num_papers;
+  ranks->iterations = 0;
+  ranks->residual = 0;
+
+  // Compact IDs (no papers yet => 1-element arrays, never read)
+  int cap = data->num_papers ? data->num_papers : 1;
+  run.dense = malloc(cap * sizeof(int));
+  DIE(run.dense == NULL, "run.dense malloc");
+  run.compact = malloc(cap * sizeof(int));
+  DIE(run.compact == NULL, "run.compact malloc");
+
+  for (i = 0; i < data->num_papers; i++) {
+    run.compact[i] = data->papers[i] ? run.n : -1;
+    if (data->papers[i]) {
+      run.dense[run.n++] = i;
+    }
+  }
+
+  if (run.n) {
+    run.num_chunks = (run.n + RANK_ROW_CHUNK - 1) / RANK_ROW_CHUNK;
+    run.num_blocks = (run.n + RANK_BLOCK - 1) / RANK_BLOCK;
+
+    run.chunks = calloc(run.num_chunks, sizeof(Rank_Chunk));
+    DIE(run.chunks == NULL, "run.chunks calloc");
+    run.out_degree = malloc(run.n * sizeof(int));
+    DIE(run.out_degree == NULL, "run.out_degree malloc");
+    run.dangling = alloc_vector(run.num_chunks);
+    run.residual = alloc_vector(run.num_chunks);
+    run.rank = alloc_vector(run.n);
+    run.next = alloc_vector(run.n);
+    run.contrib = alloc_vector(run.n);
+    run.next_contrib = alloc_vector(run.n);
+
+    run_round(pool, &run, build_chunks);
+
+    // Starting from the uniform distribution
+    double dangling = 0;
+    for (v = 0; v < run.n; v++) {
+      run.rank[v] = 1.0 / run.n;
+      run.contrib[v] = run.out_degree[v] ? run.rank[v] / run.out_degree[v] : 0;
+      dangling += run.out_degree[v] ? 0 : run.rank[v];
+    }
+
+    while (ranks->iterations < max_iterations) {
+      run.base = (1 - damping) / run.n + damping * dangling / run.n;
+      run_round(pool, &run, iterate_chunks);
+      swap_vectors(&run.rank, &run.next);
+      swap_vectors(&run.contrib, &run.next_contrib);
+
+      dangling = 0;
+      ranks->residual = 0;
+      for (c = 0; c < run.num_chunks; c++) {
+        dangling += run.dangling[c];
+        ranks->residual += run.residual[c];
+      }
+
+      ranks->iterations++;
+      if (ranks->residual < tolerance) {
+        break;
+      }
+    }
+
+    for (v = 0; v < run.n; v++) {
+      ranks->scores[run.dense[v]] = run.rank[v];
+    }
+  }
+
+  for (c = 0; c < run.num_chunks; c++) {
+    free(run.chunks[c].rows);
+    free(run.chunks[c].sources);
+  }
+  free(run.chunks);
+  free(run.dense);
+  free(run.compact);
+  free(run.out_degree);
+  free(run.dangling);
+  free(run.residual);
+  free(run.rank);
+  free(run.next);
+  free(run.contrib);
+  free(run.next_contrib);
+}
+
+/* ------------------------- Top K ------------------------- */
+typedef struct rank_entry {
+  double score;
+  int64_t id;
+} Rank_Entry;
+
+static int is_better(const Rank_Entry *a, const Rank_Entry *b) {
+  return a->score > b->score || (a->score == b->score && a->id < b->id);
+}
+
+static int compare_entries(const void *a, const void *b) {
+  return is_better(b, a) - is_better(a, b);
+}
+
+/* Min-heap - the root is the worst of the best ones so far */
+static void sift_up(Rank_Entry *heap, int i) {
+  while (i && is_better(&heap[(i - 1) / 2], &heap[i])) {
+    Rank_Entry aux = heap[i];
+    heap[i] = heap[(i - 1) / 2];
+    heap[(i - 1) / 2] = aux;
+    i = (i - 1) / 2;
+  }
+}
+
+static void sift_down(Rank_Entry *heap, int size, int i) {
+  while (1) {
+    int worst = i, child;
+
+    for (child = 2 * i + 1; child <= 2 * i + 2 && child < size; child++) {
+      if (is_better(&heap[worst], &heap[child])) {
+        worst = child;
+      }
+    }
+    if (worst == i) {
+      return;
+    }
+
+    Rank_Entry aux = heap[i];
+    heap[i] = heap[worst];
+    heap[worst] = aux;
+    i = worst;
+  }
+}
+
+int64_t *top_influence_ranks(PublData *data, Influence_Ranks *ranks, int *k) {
+  int i, size = 0;
+
+  int wanted = *k < ranks->num_papers ? *k : ranks->num_papers;
+  *k = 0;
+  if (wanted <= 0) {
+    return NULL;
+  }
+
+  Rank_Entry *heap = malloc(wanted * sizeof(Rank_Entry));
+  DIE(heap == NULL, "heap malloc");
+
+  for (i = 0; i < ranks->num_papers; i++) {
+    if (data->papers[i] == NULL) {
+      continue;
+    }
+
+    Rank_Entry entry = {ranks->scores[i], data->papers[i]->id};
+    if (size < wanted) {
+      heap[size] = entry;
+      sift_up(heap, size++);
+    } else if (is_better(&entry, &heap[0])) {
+      heap[0] = entry;
+      sift_down(heap, size, 0);
+    }
+  }
+
+  // Every ranked paper was removed since
+  if (size == 0) {
+    free(heap);
+    return NULL;
+  }
+
+  qsort(heap, size, sizeof(Rank_Entry), compare_entries);
+
+  int64_t *ids = malloc(size * sizeof(int64_t));
+  DIE(ids == NULL, "ids malloc");
+  for (i = 0; i < size; i++) {
+    ids[i] = heap[i].id;
+  }
+  free(heap);
+
+  *k = size;
+  return ids;
+}
+
+void free_influence_ranks(Influence_Ranks *ranks) {
+  if (ranks == NULL) {
+    return;
+  }
+
+  free(ranks->scores);
+  free(ranks);
+}
@@ -0,0 +1,55 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef INFLUENCE_RANK_H_
+#define INFLUENCE_RANK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Papers whose scores one task computes at a time (offsets fit in 16 bits) */
+#define RANK_ROW_CHUNK (1 << 14)
+/* Citing papers whose contributions are read together (256KB of doubles) */
+#define RANK_BLOCK (1 << 15)
+
+struct publications_data;
+struct Thread_Pool;
+
+/*
+ * Influence Rank - PageRank over the citation graph
+ * A paper passes its score on to the papers it references, in equal parts:
+ *   rank(v) = (1 - d) / n + d * (sum over u citing v of rank(u) / out(u)
+ *                                + dangling / n)
+ * where dangling is the score of the papers citing nothing (spread over
+ * everyone). The iterations stop once the scores change by less than the
+ * tolerance (L1, the scores add up to 1).
+ *
+ * Each iteration is a sparse matrix - vector product, cache-blocked: the
+ * papers are cut in chunks of RANK_ROW_CHUNK (the rows, taken by the pool's
+ * workers) and the citations of a chunk are sorted by the RANK_BLOCK of the
+ * citing paper, so the scores read and the ones written both stay in cache
+ * while a block is being added up. The citations are copied out of the edge
+ * lists once per run, as (row offset, citing paper) pairs.
+ */
+typedef struct Influence_Ranks {
+  double *scores;  // By dense ID (0 - removed)
+  int num_papers;  // Dense IDs ranked - the ones added since have none
+  int iterations;
+  double residual;  // L1 change of the last iteration
+} Influence_Ranks;
+
+/* pool NULL => on the calling thread */
+void compute_influence_ranks(struct publications_data *data,
+                             struct Thread_Pool *pool, Influence_Ranks *ranks,
+                             double damping, double tolerance,
+                             int max_iterations);
+
+/*
+ * IDs of the k papers with the best scores, best first (equal ones by ID),
+ * *k set to how many there are
+ */
+int64_t *top_influence_ranks(struct publications_data *data,
+                             Influence_Ranks *ranks, int *k);
+
+void free_influence_ranks(Influence_Ranks *ranks);
+
+#endif /* INFLUENCE_RANK_H_ */
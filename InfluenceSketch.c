@@ -0,0 +1,268 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./EdgeList.h"
+#include "./Hashtables.h"
+#include "./InfluenceSketch.h"
+#include "./publications.h"
+#include "./utils.h"
+
+/* ----------------------- HyperLogLog registers ----------------------- */
+/* The first `precision` bits pick the register, the rest give the rank */
+static inline int hll_add(uint8_t *registers, int precision, uint64_t hash) {
+  uint64_t j = hash >> (64 - precision);
+  uint64_t rest = hash << precision;
+  uint8_t rank = rest ? __builtin_clzll(rest) + 1 : 64 - precision + 1;
+
+  if (registers[j] < rank) {
+    registers[j] = rank;
+    return 1;
+  }
+
+  return 0;
+}
+
+static inline int hll_merge(uint8_t *dst, const uint8_t *src, int m) {
+  int i, changed = 0;
+
+  for (i = 0; i < m; i++) {
+    if (src[i] > dst[i]) {
+      dst[i] = src[i];
+      changed = 1;
+    }
+  }
+
+  return changed;
+}
+
+static double hll_estimate(const uint8_t *registers, int m) {
+  double alpha, sum = 0;
+  int i, zeros = 0;
+
+  switch (m) {
+    case 16:
+      alpha = 0.673;
+      break;
+    case 32:
+      alpha = 0.697;
+      break;
+    case 64:
+      alpha = 0.709;
+      break;
+    default:
+      alpha = 0.7213 / (1 + 1.079 / m);
+  }
+
+  for (i = 0; i < m; i++) {
+    sum += ldexp(1.0, -registers[i]);
+    zeros += registers[i] == 0;
+  }
+
+  double estimate = alpha * m * m / sum;
+
+  // Small sets - linear counting is more precise
+  if (estimate <= 2.5 * m && zeros) {
+    estimate = m * log((double)m / zeros);
+  }
+
+  return estimate;
+}
+
+/* ----------------------- Per-paper sketches ----------------------- */
+static inline uint8_t *get_sketch(Influence_Sketches *sketches, int idx,
+                                  int distance) {
+  return sketches->registers +
+         ((size_t)idx * sketches->max_dist + (distance - 1)) * sketches->m;
+}
+
+static inline uint64_t paper_hash(PublData *data, int idx) {
+  // By paper ID - stays the same if the paper is updated
+  return hash_int64(data->papers[idx]->id);
+}
+
+void init_influence_sketches(Influence_Sketches *sketches, int max_dist,
+                             int precision, int cap) {
+  if (sketches == NULL) {
+    return;
+  }
+
+  if (precision < MIN_SKETCH_PRECISION) {
+    precision = MIN_SKETCH_PRECISION;
+  }
+  if (precision > MAX_SKETCH_PRECISION) {
+    precision = MAX_SKETCH_PRECISION;
+  }
+
+  sketches->registers = NULL;
+  sketches->max_dist = max_dist;
+  sketches->precision = precision;
+  sketches->m = 1 << precision;
+  sketches->cap = 0;
+  sketches->dirty = 0;
+  grow_influence_sketches(sketches, cap);
+}
+
+void grow_influence_sketches(Influence_Sketches *sketches, int cap) {
+  if (sketches == NULL || cap <= sketches->cap) {
+    return;
+  }
+
+  sketches->registers =
+      realloc(sketches->registers,
+              (size_t)cap * sketches->max_dist * sketches->m + 1);
+  DIE(sketches->registers == NULL, "sketches->registers realloc");
+  sketches->cap = cap;
+}
+
+void clear_paper_sketches(Influence_Sketches *sketches, int idx) {
+  memset(get_sketch(sketches, idx, 1), 0,
+         (size_t)sketches->max_dist * sketches->m);
+}
+
+/*
+ * S_d(parent) += {child} + S_{d-1}(child), for d >= from
+ * Returns the lowest distance whose sketch changed (max_dist + 1 if none)
+ */
+static int merge_child(PublData *data, int parent, int child, int from) {
+  Influence_Sketches *sketches = data->sketches;
+  uint64_t hash = paper_hash(data, child);
+  int d, lowest = sketches->max_dist + 1;
+
+  for (d = from; d <= sketches->max_dist; d++) {
+    uint8_t *sketch = get_sketch(sketches, parent, d);
+    int changed = hll_add(sketch, sketches->precision, hash);
+    if (d > 1) {
+      changed |= hll_merge(sketch, get_sketch(sketches, child, d - 1),
+                           sketches->m);
+    }
+
+    if (changed && d < lowest) {
+      lowest = d;
+    }
+  }
+
+  return lowest;
+}
+
+/*
+ * The sketches of `paper` changed from distance `from` on => the ones of the
+ * papers it cites change from `from` + 1 on, and so on (max_dist hops at most;
+ * a sketch that stays the same stops the propagation)
+ */
+static void propagate_upwards(PublData *data, int paper, int from) {
+  Edge_Iter it;
+  int cited;
+
+  if (from >= data->sketches->max_dist) {
+    return;
+  }
+
+  edge_iter_init(&it, &data->papers[paper]->info->refs);
+  while (edge_iter_next_idx(&it, &cited)) {
+    if (data->papers[cited]) {
+      int lowest = merge_child(data, cited, paper, from + 1);
+      if (lowest <= data->sketches->max_dist) {
+        propagate_upwards(data, cited, lowest);
+      }
+    }
+  }
+}
+
+void sketch_add_edge(PublData *data, int cited, int citing) {
+  // Dirty sketches get rebuilt from scratch anyway
+  if (data->sketches == NULL || data->sketches->dirty) {
+    return;
+  }
+
+  int lowest = merge_child(data, cited, citing, 1);
+  if (lowest <= data->sketches->max_dist) {
+    propagate_upwards(data, cited, lowest);
+  }
+}
+
+void rebuild_influence_sketches(PublData *data) {
+  Influence_Sketches *sketches = data->sketches;
+  Edge_Iter it;
+  int d, v, u;
+
+  if (sketches->cap) {
+    memset(sketches->registers, 0,
+           (size_t)sketches->cap * sketches->max_dist * sketches->m);
+  }
+
+  // Distance d only needs distance d - 1, complete by then
+  for (d = 1; d <= sketches->max_dist; d++) {
+    for (v = 0; v < data->num_papers; v++) {
+      if (data->papers[v] == NULL) {
+        continue;
+      }
+
+      uint8_t *sketch = get_sketch(sketches, v, d);
+      edge_iter_init(&it, &data->papers[v]->influenced);
+      while (edge_iter_next_idx(&it, &u)) {
+        if (data->papers[u]) {
+          hll_add(sketch, sketches->precision, paper_hash(data, u));
+          if (d > 1) {
+            hll_merge(sketch, get_sketch(sketches, u, d - 1), sketches->m);
+          }
+        }
+      }
+    }
+  }
+
+  sketches->dirty = 0;
+}
+
+int estimate_influence(PublData *data, int64_t id, int max_dist) {
+  Influence_Sketches *sketches = data->sketches;
+  int i;
+
+  Paper *publication = find_paper_with_id(data, id);
+  if (publication) {
+    return (int)(hll_estimate(get_sketch(sketches, publication->idx, max_dist),
+                              sketches->m) +
+                 0.5);
+  }
+
+  // Not added yet => built from the papers waiting for it
+  Idx_List *waiting = pending_ht_get(data->pending_ht, id);
+  if (waiting == NULL) {
+    return 0;
+  }
+
+  uint8_t *sketch = calloc(sketches->m, sizeof(uint8_t));
+  DIE(sketch == NULL, "sketch calloc");
+
+  for (i = 0; i < waiting->size; i++) {
+    int u = waiting->items[i];
+    if (data->papers[u]) {
+      hll_add(sketch, sketches->precision, paper_hash(data, u));
+      if (max_dist > 1) {
+        hll_merge(sketch, get_sketch(sketches, u, max_dist - 1), sketches->m);
+      }
+    }
+  }
+
+  int estimate = (int)(hll_estimate(sketch, sketches->m) + 0.5);
+  free(sketch);
+
+  return estimate;
+}
+
+float influence_sketch_error(Influence_Sketches *sketches) {
+  return 1.04f / sqrtf((float)sketches->m);
+}
+
+void free_influence_sketches(Influence_Sketches *sketches) {
+  if (sketches == NULL) {
+    return;
+  }
+
+  free(sketches->registers);
+  free(sketches);
+}
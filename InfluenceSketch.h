@@ -0,0 +1,58 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef INFLUENCE_SKETCH_H_
+#define INFLUENCE_SKETCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MIN_SKETCH_PRECISION 4
+#define MAX_SKETCH_PRECISION 16
+
+struct publications_data;
+
+/*
+ * Influence Sketches - approximate k-hop influence counts
+ * For every paper v and every distance d = 1 .. max_dist, a HyperLogLog
+ * sketch of the papers v influenced up to distance d:
+ *   S_1(v) = influenced(v)
+ *   S_d(v) = union over u in influenced(v) of ({u} + S_{d-1}(u))
+ * Each sketch has m = 2^precision one-byte registers; its estimate has a
+ * relative standard error of about 1.04 / sqrt(m).
+ *
+ * HyperLogLog sketches only grow (merging = register-wise max), so add_paper
+ * keeps them up to date by merging the new edges upwards; a removal marks
+ * them dirty and they are rebuilt by refresh_influence_sketches (writer side),
+ * the queries answering exactly in between.
+ */
+typedef struct Influence_Sketches {
+  uint8_t *registers;  // cap * max_dist * m, by dense ID then distance
+  int max_dist;
+  int precision;
+  int m;  // Registers per sketch
+  int cap;  // Papers with room for their sketches
+  int dirty;  // A paper was removed since the last rebuild
+} Influence_Sketches;
+
+void init_influence_sketches(Influence_Sketches *sketches, int max_dist,
+                             int precision, int cap);
+
+void grow_influence_sketches(Influence_Sketches *sketches, int cap);
+
+/* Empty sketches for a newly added paper */
+void clear_paper_sketches(Influence_Sketches *sketches, int idx);
+
+/* The paper `citing` was added to influenced(`cited`) */
+void sketch_add_edge(struct publications_data *data, int cited, int citing);
+
+void rebuild_influence_sketches(struct publications_data *data);
+
+/* Estimated |S_max_dist(id)|, for a paper that was not added, too */
+int estimate_influence(struct publications_data *data, int64_t id,
+                       int max_dist);
+
+float influence_sketch_error(Influence_Sketches *sketches);
+
+void free_influence_sketches(Influence_Sketches *sketches);
+
+#endif /* INFLUENCE_SKETCH_H_ */
@@ -74,15 +74,3 @@ int get_size(struct LinkedList *list) {
 
   return list->size;
 }
-
-void free_info_list(struct LinkedList **pp_list) {
-  struct Node *curr = (*pp_list)->head;
-  struct Node *copy_node;
-  while (curr != NULL) {
-    copy_node = curr;
-    curr = curr->next;
-    destroy_paper(copy_node->data);
-    free(copy_node);
-  }
-  free(*pp_list);
-}
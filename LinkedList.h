@@ -25,6 +25,4 @@ struct Node *remove_first_node(struct LinkedList *list);
 
 int get_size(struct LinkedList *list);
 
-void free_info_list(struct LinkedList **list);
-
 #endif /* LINKEDLIST_H_ */
@@ -0,0 +1,35 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./PaperFilter.h"
+#include "./publications.h"
+
+void init_paper_filter(Paper_Filter *filter, int cap) {
+  if (filter == NULL) {
+    return;
+  }
+
+  filter->cap = cap;
+  filter->num_blocks =
+      ((uint64_t)cap * FILTER_BITS_PER_PAPER + 32 * FILTER_BLOCK_WORDS - 1) /
+      (32 * FILTER_BLOCK_WORDS);
+  if (filter->num_blocks == 0) {
+    filter->num_blocks = 1;
+  }
+
+  filter->blocks = calloc(filter->num_blocks, sizeof(*filter->blocks));
+  DIE(filter->blocks == NULL, "filter->blocks calloc");
+}
+
+void free_paper_filter(Paper_Filter *filter) {
+  if (filter == NULL) {
+    return;
+  }
+
+  free(filter->blocks);
+  free(filter);
+}
@@ -0,0 +1,68 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef PAPER_FILTER_H_
+#define PAPER_FILTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "./GenericHT.h"
+
+#define FILTER_BLOCK_WORDS 8  // 8 x 32 bits = one 256-bit block per key
+#define FILTER_BITS_PER_PAPER 16  // ~0.1% false positives when full
+
+/*
+ * Paper Filter - split block Bloom filter in front of Papers_HT
+ * Most references point to papers that were never added, and every one of
+ * them used to cost a full probe sequence in Papers_HT. The filter answers
+ * "surely absent" for almost all of them by looking at a single 32-byte
+ * block: the key picks the block and sets one bit in each of its 8 words.
+ * It cannot forget a key - removed papers stay "maybe present" (the hashtable
+ * still gives the right answer) until the next rebuild.
+ */
+typedef struct Paper_Filter {
+  uint32_t (*blocks)[FILTER_BLOCK_WORDS];
+  uint64_t num_blocks;
+  int cap;  // Papers it was sized for
+} Paper_Filter;
+
+/* Empty filter, sized for cap papers */
+void init_paper_filter(Paper_Filter *filter, int cap);
+
+void free_paper_filter(Paper_Filter *filter);
+
+static const uint32_t filter_salt[FILTER_BLOCK_WORDS] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+/* High half of the hash -> block (multiply-shift, no modulo) */
+static inline uint32_t *filter_block(Paper_Filter *filter, uint64_t hash) {
+  return filter->blocks[((hash >> 32) * filter->num_blocks) >> 32];
+}
+
+static inline void paper_filter_add(Paper_Filter *filter, int64_t id) {
+  uint64_t hash = hash_int64(id);
+  uint32_t *block = filter_block(filter, hash);
+  int i;
+
+  for (i = 0; i < FILTER_BLOCK_WORDS; i++) {
+    block[i] |= 1U << (((uint32_t)hash * filter_salt[i]) >> 27);
+  }
+}
+
+/* 0 => surely never added; 1 => ask Papers_HT */
+static inline int paper_filter_may_contain(Paper_Filter *filter, int64_t id) {
+  uint64_t hash = hash_int64(id);
+  uint32_t *block = filter_block(filter, hash);
+  int i;
+
+  for (i = 0; i < FILTER_BLOCK_WORDS; i++) {
+    if (!(block[i] & (1U << (((uint32_t)hash * filter_salt[i]) >> 27)))) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+#endif /* PAPER_FILTER_H_ */
@@ -0,0 +1,285 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./ByteBuffer.h"
+#include "./PaperOps.h"
+#include "./publications.h"
+#include "./utils.h"
+
+static char **copy_strings(const char **strings, int n) {
+  int i;
+
+  // At least one element - malloc(0) may return NULL
+  char **copies = malloc((n ? n : 1) * sizeof(char *));
+  DIE(copies == NULL, "copies malloc");
+  for (i = 0; i < n; i++) {
+    copies[i] = copy_string(strings[i]);
+  }
+
+  return copies;
+}
+
+static int64_t *copy_ids(const int64_t *ids, int n) {
+  int64_t *copies = malloc((n ? n : 1) * sizeof(int64_t));
+  DIE(copies == NULL, "copies malloc");
+  if (n) {
+    memcpy(copies, ids, n * sizeof(int64_t));
+  }
+
+  return copies;
+}
+
+static void free_strings(char **strings, int n) {
+  int i;
+
+  for (i = 0; strings && i < n; i++) {
+    free(strings[i]);
+  }
+  free(strings);
+}
+
+void init_paper_op(Paper_Op *op, Paper_Op_Type type, const char *title,
+                   const char *venue, const int year,
+                   const char **author_names, const int64_t *author_ids,
+                   const char **institutions, const int num_authors,
+                   const char **fields, const int num_fields,
+                   const int64_t id, const int64_t *references,
+                   const int num_refs) {
+  memset(op, 0, sizeof(Paper_Op));
+  op->type = type;
+  op->id = id;
+  if (type == OP_REMOVE_PAPER) {
+    return;
+  }
+
+  op->title = copy_string(title);
+  op->venue = copy_string(venue);
+  op->year = year;
+  op->author_names = copy_strings(author_names, num_authors);
+  op->institutions = copy_strings(institutions, num_authors);
+  op->num_authors = num_authors;
+  op->fields = copy_strings(fields, num_fields);
+  op->num_fields = num_fields;
+  op->num_refs = num_refs;
+
+  op->author_ids = copy_ids(author_ids, num_authors);
+  op->references = copy_ids(references, num_refs);
+}
+
+/* ---------------- Text form ---------------- */
+/* Next argument as a number - 0 if there is none (*ok is cleared then) */
+static int64_t next_number(const char **line, int *ok) {
+  char *token = next_argument(line);
+  if (token == NULL) {
+    *ok = 0;
+    return 0;
+  }
+
+  char *end;
+  int64_t number = strtoll(token, &end, 10);
+  if (*end != '\0') {
+    *ok = 0;
+  }
+  free(token);
+
+  return number;
+}
+
+/* A count of things to come - small enough to be believed */
+static int next_count(const char **line, int *ok) {
+  int64_t count = next_number(line, ok);
+  if (count < 0 || count > (int64_t)strlen(*line)) {
+    *ok = 0;
+    return 0;
+  }
+
+  return (int)count;
+}
+
+int parse_paper_op(const char *line, Paper_Op *op) {
+  int i, ok = 1;
+
+  memset(op, 0, sizeof(Paper_Op));
+
+  char *name = next_argument(&line);
+  if (name && strcmp(name, "add_paper") == 0) {
+    op->type = OP_ADD_PAPER;
+  } else if (name && strcmp(name, "update_paper") == 0) {
+    op->type = OP_UPDATE_PAPER;
+  } else if (name && strcmp(name, "remove_paper") == 0) {
+    op->type = OP_REMOVE_PAPER;
+  } else {
+    ok = 0;
+  }
+  free(name);
+
+  op->id = ok ? next_number(&line, &ok) : 0;
+  if (!ok || op->type == OP_REMOVE_PAPER) {
+    return ok ? 0 : -1;
+  }
+
+  op->title = next_argument(&line);
+  op->venue = next_argument(&line);
+  op->year = (int)next_number(&line, &ok);
+  ok = ok && op->title && op->venue;
+
+  op->num_authors = ok ? next_count(&line, &ok) : 0;
+  op->author_names = calloc(op->num_authors + 1, sizeof(char *));
+  op->institutions = calloc(op->num_authors + 1, sizeof(char *));
+  op->author_ids = calloc(op->num_authors + 1, sizeof(int64_t));
+  DIE(op->author_names == NULL || op->institutions == NULL ||
+          op->author_ids == NULL,
+      "op authors calloc");
+  for (i = 0; ok && i < op->num_authors; i++) {
+    op->author_names[i] = next_argument(&line);
+    op->author_ids[i] = next_number(&line, &ok);
+    op->institutions[i] = next_argument(&line);
+    ok = ok && op->author_names[i] && op->institutions[i];
+  }
+
+  op->num_fields = ok ? next_count(&line, &ok) : 0;
+  op->fields = calloc(op->num_fields + 1, sizeof(char *));
+  DIE(op->fields == NULL, "op->fields calloc");
+  for (i = 0; ok && i < op->num_fields; i++) {
+    op->fields[i] = next_argument(&line);
+    ok = op->fields[i] != NULL;
+  }
+
+  op->num_refs = ok ? next_count(&line, &ok) : 0;
+  op->references = calloc(op->num_refs + 1, sizeof(int64_t));
+  DIE(op->references == NULL, "op->references calloc");
+  for (i = 0; ok && i < op->num_refs; i++) {
+    op->references[i] = next_number(&line, &ok);
+  }
+
+  if (!ok) {
+    free_paper_op(op);
+    return -1;
+  }
+
+  return 0;
+}
+
+/* ---------------- Binary form ---------------- */
+void encode_paper_op(Byte_Buffer *buf, const Paper_Op *op) {
+  int i;
+
+  byte_buffer_put(buf, &(uint8_t){(uint8_t)op->type}, 1);
+  byte_buffer_put_zigzag(buf, op->id);
+  if (op->type == OP_REMOVE_PAPER) {
+    return;
+  }
+
+  byte_buffer_put_string(buf, op->title);
+  byte_buffer_put_string(buf, op->venue);
+  byte_buffer_put_zigzag(buf, op->year);
+
+  byte_buffer_put_varint(buf, op->num_authors);
+  for (i = 0; i < op->num_authors; i++) {
+    byte_buffer_put_string(buf, op->author_names[i]);
+    byte_buffer_put_zigzag(buf, op->author_ids[i]);
+    byte_buffer_put_string(buf, op->institutions[i]);
+  }
+
+  byte_buffer_put_varint(buf, op->num_fields);
+  for (i = 0; i < op->num_fields; i++) {
+    byte_buffer_put_string(buf, op->fields[i]);
+  }
+
+  byte_buffer_put_varint(buf, op->num_refs);
+  for (i = 0; i < op->num_refs; i++) {
+    byte_buffer_put_zigzag(buf, op->references[i]);
+  }
+}
+
+int decode_paper_op(Byte_Reader *reader, Paper_Op *op) {
+  int i;
+
+  memset(op, 0, sizeof(Paper_Op));
+
+  int type = reader->pos < reader->end ? *reader->pos++ : -1;
+  op->id = byte_reader_zigzag(reader);
+  if (type != OP_ADD_PAPER && type != OP_UPDATE_PAPER &&
+      type != OP_REMOVE_PAPER) {
+    return -1;
+  }
+  op->type = type;
+  if (op->type == OP_REMOVE_PAPER) {
+    return reader->ok ? 0 : -1;
+  }
+
+  op->title = byte_reader_string(reader);
+  op->venue = byte_reader_string(reader);
+  op->year = (int)byte_reader_zigzag(reader);
+
+  op->num_authors = byte_reader_count(reader);
+  op->author_names = calloc(op->num_authors + 1, sizeof(char *));
+  op->institutions = calloc(op->num_authors + 1, sizeof(char *));
+  op->author_ids = calloc(op->num_authors + 1, sizeof(int64_t));
+  DIE(op->author_names == NULL || op->institutions == NULL ||
+          op->author_ids == NULL,
+      "op authors calloc");
+  for (i = 0; reader->ok && i < op->num_authors; i++) {
+    op->author_names[i] = byte_reader_string(reader);
+    op->author_ids[i] = byte_reader_zigzag(reader);
+    op->institutions[i] = byte_reader_string(reader);
+  }
+
+  op->num_fields = reader->ok ? byte_reader_count(reader) : 0;
+  op->fields = calloc(op->num_fields + 1, sizeof(char *));
+  DIE(op->fields == NULL, "op->fields calloc");
+  for (i = 0; reader->ok && i < op->num_fields; i++) {
+    op->fields[i] = byte_reader_string(reader);
+  }
+
+  op->num_refs = reader->ok ? byte_reader_count(reader) : 0;
+  op->references = calloc(op->num_refs + 1, sizeof(int64_t));
+  DIE(op->references == NULL, "op->references calloc");
+  for (i = 0; reader->ok && i < op->num_refs; i++) {
+    op->references[i] = byte_reader_zigzag(reader);
+  }
+
+  if (!reader->ok) {
+    free_paper_op(op);
+    return -1;
+  }
+
+  return 0;
+}
+
+void apply_paper_op(PublData *data, Paper_Op *op) {
+  switch (op->type) {
+    case OP_ADD_PAPER:
+      add_paper(data, op->title, op->venue, op->year,
+                (const char **)op->author_names, op->author_ids,
+                (const char **)op->institutions, op->num_authors,
+                (const char **)op->fields, op->num_fields, op->id,
+                op->references, op->num_refs);
+      break;
+    case OP_UPDATE_PAPER:
+      update_paper(data, op->title, op->venue, op->year,
+                   (const char **)op->author_names, op->author_ids,
+                   (const char **)op->institutions, op->num_authors,
+                   (const char **)op->fields, op->num_fields, op->id,
+                   op->references, op->num_refs);
+      break;
+    case OP_REMOVE_PAPER:
+      remove_paper(data, op->id);
+      break;
+  }
+}
+
+void free_paper_op(Paper_Op *op) {
+  free(op->title);
+  free(op->venue);
+  free_strings(op->author_names, op->num_authors);
+  free_strings(op->institutions, op->num_authors);
+  free_strings(op->fields, op->num_fields);
+  free(op->author_ids);
+  free(op->references);
+  memset(op, 0, sizeof(Paper_Op));
+}
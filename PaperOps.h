@@ -0,0 +1,79 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef PAPER_OPS_H_
+#define PAPER_OPS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "./ByteBuffer.h"
+#include "./GenericHT.h"
+#include "./publications.h"
+
+/*
+ * Paper Op - a change to the data (add_paper / update_paper / remove_paper)
+ * with its own copies of the arguments, so it can be kept and applied later
+ * (replayed on a snapshot replica, sent over a socket etc.)
+ * Text form - the command-file syntax, one op per line:
+ *   add_paper <id> <title> <venue> <year>
+ *             <num_authors> (<name> <author id> <institution>)...
+ *             <num_fields> <field>... <num_refs> <reference>...
+ *   update_paper - the same
+ *   remove_paper <id>
+ * with the strings quoted if they contain whitespace.
+ * Binary form - for the log and the cluster's messages (see ByteBuffer.h):
+ *   op type byte, zigzag id and, for add / update:
+ *   title, venue, zigzag year,
+ *   varint num_authors, (name, zigzag author id, institution)...,
+ *   varint num_fields, field..., varint num_refs, zigzag reference...
+ */
+typedef enum paper_op_type {
+  OP_ADD_PAPER,
+  OP_UPDATE_PAPER,
+  OP_REMOVE_PAPER
+} Paper_Op_Type;
+
+typedef struct paper_op {
+  Paper_Op_Type type;
+  int64_t id;
+
+  char *title;
+  char *venue;
+  int year;
+  char **author_names;
+  int64_t *author_ids;
+  char **institutions;
+  int num_authors;
+  char **fields;
+  int num_fields;
+  int64_t *references;
+  int num_refs;
+} Paper_Op;
+
+DEFINE_VECTOR(Op_Log, op_log, Paper_Op)
+
+/* Copies the arguments (unused by OP_REMOVE_PAPER, may be NULL / 0 then) */
+void init_paper_op(Paper_Op *op, Paper_Op_Type type, const char *title,
+                   const char *venue, const int year,
+                   const char **author_names, const int64_t *author_ids,
+                   const char **institutions, const int num_authors,
+                   const char **fields, const int num_fields,
+                   const int64_t id, const int64_t *references,
+                   const int num_refs);
+
+/* 0, or -1 if the line is not a valid op (op is then left empty) */
+int parse_paper_op(const char *line, Paper_Op *op);
+
+void encode_paper_op(Byte_Buffer *buf, const Paper_Op *op);
+
+/*
+ * 0, or -1 if the bytes are not a valid op (op is then left empty).
+ * Reads just the op - what comes after it is the caller's.
+ */
+int decode_paper_op(Byte_Reader *reader, Paper_Op *op);
+
+void apply_paper_op(PublData *data, Paper_Op *op);
+
+void free_paper_op(Paper_Op *op);
+
+#endif /* PAPER_OPS_H_ */
@@ -0,0 +1,143 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./QueryCache.h"
+#include "./publications.h"
+
+void init_query_cache(Query_Cache *cache, int capacity) {
+  if (cache == NULL) {
+    return;
+  }
+
+  cache_ht_init(&cache->index, 2 * capacity);
+
+  cache->entries = calloc(capacity, sizeof(cached_query));
+  DIE(cache->entries == NULL, "cache->entries calloc");
+
+  cache->capacity = capacity;
+  cache->size = 0;
+  cache->head = NO_ENTRY;
+  cache->tail = NO_ENTRY;
+  cache->hits = 0;
+  cache->misses = 0;
+}
+
+char *make_query_key(const char *format, ...) {
+  va_list args;
+
+  va_start(args, format);
+  int len = vsnprintf(NULL, 0, format, args);
+  va_end(args);
+
+  char *key = malloc(len + 1);
+  DIE(key == NULL, "make_query_key malloc");
+
+  va_start(args, format);
+  vsnprintf(key, len + 1, format, args);
+  va_end(args);
+
+  return key;
+}
+
+static void unlink_entry(Query_Cache *cache, int i) {
+  cached_query *entry = &cache->entries[i];
+
+  if (entry->prev != NO_ENTRY) {
+    cache->entries[entry->prev].next = entry->next;
+  } else {
+    cache->head = entry->next;
+  }
+
+  if (entry->next != NO_ENTRY) {
+    cache->entries[entry->next].prev = entry->prev;
+  } else {
+    cache->tail = entry->prev;
+  }
+}
+
+static void push_front(Query_Cache *cache, int i) {
+  cached_query *entry = &cache->entries[i];
+
+  entry->prev = NO_ENTRY;
+  entry->next = cache->head;
+  if (cache->head != NO_ENTRY) {
+    cache->entries[cache->head].prev = i;
+  }
+  cache->head = i;
+
+  if (cache->tail == NO_ENTRY) {
+    cache->tail = i;
+  }
+}
+
+cached_query *lookup_query(Query_Cache *cache, const char *key,
+                           uint64_t generation) {
+  int *i = cache_ht_get(&cache->index, key);
+
+  // Missing or computed from older data
+  if (i == NULL || cache->entries[*i].generation != generation) {
+    cache->misses++;
+    return NULL;
+  }
+
+  // Hit => most recently used
+  unlink_entry(cache, *i);
+  push_front(cache, *i);
+  cache->hits++;
+
+  return &cache->entries[*i];
+}
+
+cached_query *store_query(Query_Cache *cache, const char *key,
+                          uint64_t generation) {
+  int i;
+  int *existing = cache_ht_get(&cache->index, key);
+
+  if (existing) {
+    // Stale entry => overwritten in place
+    i = *existing;
+    unlink_entry(cache, i);
+  } else {
+    if (cache->size < cache->capacity) {
+      i = cache->size++;
+    } else {
+      // Full => evicting the least recently used entry
+      i = cache->tail;
+      unlink_entry(cache, i);
+      cache_ht_remove(&cache->index, cache->entries[i].key, NULL);
+      free(cache->entries[i].key);
+    }
+
+    cache->entries[i].key = copy_string(key);
+    *cache_ht_put(&cache->index, cache->entries[i].key) = i;
+  }
+
+  cached_query *entry = &cache->entries[i];
+  free(entry->histogram);
+  entry->histogram = NULL;
+  entry->title = NULL;
+  entry->generation = generation;
+
+  push_front(cache, i);
+  return entry;
+}
+
+void free_query_cache(Query_Cache *cache) {
+  int i;
+
+  if (cache == NULL) {
+    return;
+  }
+
+  for (i = 0; i < cache->size; i++) {
+    free(cache->entries[i].key);
+    free(cache->entries[i].histogram);
+  }
+  free(cache->entries);
+  cache_ht_destroy(&cache->index);
+}
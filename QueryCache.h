@@ -0,0 +1,63 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef QUERY_CACHE_H_
+#define QUERY_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "./GenericHT.h"
+
+#define QUERY_CACHE_SIZE 4096
+#define NO_ENTRY -1
+
+/*
+ * Query Cache - bounded LRU of query results
+ * Key - query type & arguments, serialized (see make_query_key)
+ * Value - the result, together with the generation of the data it was
+ * computed from. A lookup only hits if the generation is still the same.
+ */
+typedef struct cached_query {
+  char *key;
+  uint64_t generation;
+
+  // Result
+  int value;
+  float impact_factor;
+  char *title;  // Not owned - points inside a paper
+  int *histogram;  // Owned - the callers get copies
+
+  // LRU links (entry indices)
+  int prev;
+  int next;
+} cached_query;
+
+DEFINE_HT(Cache_HT, cache_ht, const char *, int, hash_string, equal_strings,
+          KEEP_KEY, NO_FREE, NO_FREE)
+
+typedef struct Query_Cache {
+  Cache_HT index;  // key -> entry
+  cached_query *entries;
+  int capacity;
+  int size;
+  int head;  // Most recently used
+  int tail;  // Least recently used
+
+  // Stats
+  int64_t hits;
+  int64_t misses;
+} Query_Cache;
+
+void init_query_cache(Query_Cache *cache, int capacity);
+
+char *make_query_key(const char *format, ...);
+
+cached_query *lookup_query(Query_Cache *cache, const char *key,
+                           uint64_t generation);
+
+cached_query *store_query(Query_Cache *cache, const char *key,
+                          uint64_t generation);
+
+void free_query_cache(Query_Cache *cache);
+
+#endif /* QUERY_CACHE_H_ */
@@ -0,0 +1,420 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./Hashtables.h"
+#include "./HubCounts.h"
+#include "./QueryCache.h"
+#include "./QueryExecutor.h"
+#include "./ThreadPool.h"
+#include "./publications.h"
+#include "./utils.h"
+
+/* ------------------------- Parsing ------------------------- */
+typedef struct query_syntax {
+  const char *name;
+  Query_Type type;
+  int has_id;
+  int num_numbers;
+  int num_strings;
+} query_syntax;
+
+static const query_syntax syntax[] = {
+    {"get_oldest_influence", QUERY_OLDEST_INFLUENCE, 1, 0, 0},
+    {"get_venue_impact_factor", QUERY_VENUE_IMPACT_FACTOR, 0, 0, 1},
+    {"get_venue_impact_factor_window", QUERY_VENUE_IMPACT_FACTOR_WINDOW, 0, 2,
+     1},
+    {"get_number_of_influenced_papers", QUERY_INFLUENCED_PAPERS, 1, 1, 0},
+    {"get_number_of_papers_between_dates", QUERY_PAPERS_BETWEEN_DATES, 0, 2,
+     0},
+    {"get_number_of_authors_with_field", QUERY_AUTHORS_WITH_FIELD, 0, 0, 2},
+    {"get_histogram_of_citations", QUERY_HISTOGRAM_OF_CITATIONS, 1, 0, 0}};
+
+int parse_query(const char *line, Query *query) {
+  const query_syntax *form = NULL;
+  int i, ok = 1;
+
+  memset(query, 0, sizeof(Query));
+
+  char *name = next_argument(&line);
+  for (i = 0; name && i < (int)(sizeof(syntax) / sizeof(syntax[0])); i++) {
+    if (strcmp(name, syntax[i].name) == 0) {
+      form = &syntax[i];
+    }
+  }
+  free(name);
+  if (form == NULL) {
+    return -1;
+  }
+
+  query->type = form->type;
+  if (form->has_id) {
+    char *token = next_argument(&line);
+    ok = token != NULL;
+    query->id = token ? strtoll(token, NULL, 10) : 0;
+    free(token);
+  }
+  for (i = 0; ok && i < form->num_numbers; i++) {
+    char *token = next_argument(&line);
+    ok = token != NULL;
+    query->numbers[i] = token ? atoi(token) : 0;
+    free(token);
+  }
+  for (i = 0; ok && i < form->num_strings; i++) {
+    query->strings[i] = next_argument(&line);
+    ok = query->strings[i] != NULL;
+  }
+
+  if (!ok) {
+    free_query(query);
+    return -1;
+  }
+
+  return 0;
+}
+
+void print_query_result(FILE *out, Query *query) {
+  int i;
+
+  switch (query->type) {
+    case QUERY_OLDEST_INFLUENCE:
+      fprintf(out, "%s", query->title);
+      break;
+    case QUERY_VENUE_IMPACT_FACTOR:
+    case QUERY_VENUE_IMPACT_FACTOR_WINDOW:
+      fprintf(out, "%f", query->impact_factor);
+      break;
+    case QUERY_HISTOGRAM_OF_CITATIONS:
+      for (i = 0; i < query->value; i++) {
+        fprintf(out, i ? " %d" : "%d", query->histogram[i]);
+      }
+      break;
+    default:
+      fprintf(out, "%d", query->value);
+  }
+
+  fprintf(out, query->partial ? " PARTIAL\n" : "\n");
+}
+
+void free_query(Query *query) {
+  int i;
+
+  for (i = 0; i < MAX_QUERY_ARGS; i++) {
+    free(query->strings[i]);
+    query->strings[i] = NULL;
+  }
+  free(query->histogram);
+  query->histogram = NULL;
+}
+
+/* ------------------------- Cost estimates ------------------------- */
+/* Papers reached by a search starting from `start` ones, `levels` deep */
+static int64_t search_cost(int64_t start, double fan_out, int levels,
+                           int num_papers) {
+  double level = start, cost = start;
+  int i;
+
+  for (i = 1; i < levels && level >= 1 && cost < num_papers; i++) {
+    level *= fan_out;
+    cost += level;
+  }
+
+  return cost < num_papers ? (int64_t)cost : num_papers;
+}
+
+static int64_t estimate_cost(PublData *data, Query *query, double fan_out) {
+  Paper *paper;
+  Paper_Postings *postings;
+  Author_Entry *author;
+
+  switch (query->type) {
+    case QUERY_OLDEST_INFLUENCE:
+      // Down the references, as deep as they go
+      paper = find_paper_with_id(data, query->id);
+      return paper ? search_cost(data->stats[paper->idx].out_degree, fan_out,
+                                 data->num_papers, data->num_papers)
+                   : 0;
+    case QUERY_INFLUENCED_PAPERS: {
+      paper = find_paper_with_id(data, query->id);
+      Idx_List *waiting =
+          paper ? NULL : pending_ht_get(data->pending_ht, query->id);
+      int64_t start = paper ? data->stats[paper->idx].in_degree
+                            : waiting ? waiting->size : 0;
+
+      // A hub's answer is looked up, while its counts are fresh
+      if (paper && data->hub_counts &&
+          query->numbers[0] <= data->hub_counts->max_dist &&
+          get_hub_entry(data, paper->idx)) {
+        return 1;
+      }
+      return search_cost(start, fan_out, query->numbers[0], data->num_papers);
+    }
+    case QUERY_VENUE_IMPACT_FACTOR:
+      postings = venue_ht_get(data->venue_ht, query->strings[0]);
+      return postings ? postings->papers.size : 0;
+    case QUERY_VENUE_IMPACT_FACTOR_WINDOW:
+      // Two prefix sums
+      return 1;
+    case QUERY_PAPERS_BETWEEN_DATES:
+      // A SIMD scan of the year column
+      return data->num_papers / 16;
+    case QUERY_AUTHORS_WITH_FIELD:
+      postings = field_ht_get(data->field_ht, query->strings[1]);
+      return postings ? postings->papers.size : 0;
+    case QUERY_HISTOGRAM_OF_CITATIONS:
+      author = find_author(data->authors, query->id);
+      return author ? author->papers.size : 0;
+  }
+
+  return 0;
+}
+
+/* ------------------------- Running ------------------------- */
+static void run_query(Query_Executor *executor, PublData *data,
+                      Query *query) {
+  Query_Limit limit = {0, &executor->cancelled};
+  int complete = 1;
+
+  if (executor->query_timeout_ms > 0) {
+    limit.deadline_ns = query_deadline(executor->query_timeout_ms);
+  }
+
+  switch (query->type) {
+    case QUERY_OLDEST_INFLUENCE:
+      query->title =
+          get_oldest_influence_limited(data, query->id, &limit, &complete);
+      break;
+    case QUERY_VENUE_IMPACT_FACTOR:
+      query->impact_factor = get_venue_impact_factor(data, query->strings[0]);
+      break;
+    case QUERY_VENUE_IMPACT_FACTOR_WINDOW:
+      query->impact_factor = get_venue_impact_factor_window(
+          data, query->strings[0], query->numbers[0], query->numbers[1]);
+      break;
+    case QUERY_INFLUENCED_PAPERS:
+      query->value = get_number_of_influenced_papers_limited(
+          data, query->id, query->numbers[0], &limit, &complete);
+      break;
+    case QUERY_PAPERS_BETWEEN_DATES:
+      query->value = get_number_of_papers_between_dates(
+          data, query->numbers[0], query->numbers[1]);
+      break;
+    case QUERY_AUTHORS_WITH_FIELD:
+      query->value = get_number_of_authors_with_field(data, query->strings[0],
+                                                      query->strings[1]);
+      break;
+    case QUERY_HISTOGRAM_OF_CITATIONS:
+      free(query->histogram);
+      query->histogram =
+          get_histogram_of_citations(data, query->id, &query->value);
+      break;
+  }
+
+  query->partial = !complete;
+}
+
+/* The owner takes the most expensive query it has left, -1 if none */
+static int pop_query(Query_Deque *deque) {
+  int q = -1;
+
+  pthread_mutex_lock(&deque->lock);
+  if (deque->head < deque->tail) {
+    q = deque->items[deque->head++];
+  }
+  pthread_mutex_unlock(&deque->lock);
+
+  return q;
+}
+
+/* A thief takes the cheapest one, -1 if none */
+static int steal_query(Query_Deque *deque) {
+  int q = -1;
+
+  pthread_mutex_lock(&deque->lock);
+  if (deque->head < deque->tail) {
+    q = deque->items[--deque->tail];
+  }
+  pthread_mutex_unlock(&deque->lock);
+
+  return q;
+}
+
+static int take_query(Query_Executor *executor, int worker) {
+  int i;
+
+  int q = pop_query(&executor->workers[worker].deque);
+  for (i = 1; q < 0 && i < executor->num_workers; i++) {
+    q = steal_query(
+        &executor->workers[(worker + i) % executor->num_workers].deque);
+  }
+
+  return q;
+}
+
+/* Worker 0 only - the results that are next in line */
+static void print_ready(Query_Executor *executor) {
+  while (executor->printed < executor->num_queries &&
+         atomic_load(&executor->done[executor->printed])) {
+    if (executor->out) {
+      print_query_result(executor->out,
+                         &executor->queries[executor->printed]);
+    }
+    executor->printed++;
+  }
+}
+
+static void run_worker(void *arg, int worker) {
+  Query_Executor *executor = arg;
+  Executor_Worker *self = &executor->workers[worker];
+  int q;
+
+  while ((q = take_query(executor, worker)) >= 0) {
+    run_query(executor, &self->view, &executor->queries[q]);
+    atomic_store(&executor->done[q], 1);
+
+    if (worker == 0) {
+      print_ready(executor);
+    }
+  }
+}
+
+Query_Executor *init_query_executor(int num_workers) {
+  int i;
+
+  Query_Executor *executor = calloc(1, sizeof(Query_Executor));
+  DIE(executor == NULL, "executor calloc");
+
+  executor->pool = calloc(1, sizeof(Thread_Pool));
+  DIE(executor->pool == NULL, "executor->pool calloc");
+  init_thread_pool(executor->pool, num_workers);
+  executor->num_workers = executor->pool->num_workers;
+
+  executor->workers =
+      calloc(executor->num_workers, sizeof(Executor_Worker));
+  DIE(executor->workers == NULL, "executor->workers calloc");
+  for (i = 0; i < executor->num_workers; i++) {
+    Executor_Worker *worker = &executor->workers[i];
+    worker->scratch = calloc(1, sizeof(Traversal_Scratch));
+    DIE(worker->scratch == NULL, "worker->scratch calloc");
+    worker->cache = calloc(1, sizeof(Query_Cache));
+    DIE(worker->cache == NULL, "worker->cache calloc");
+    init_query_cache(worker->cache, QUERY_CACHE_SIZE);
+    pthread_mutex_init(&worker->deque.lock, NULL);
+  }
+
+  return executor;
+}
+
+static int compare_costs(const void *a, const void *b) {
+  const int64_t *x = a;
+  const int64_t *y = b;
+
+  // Most expensive first, then in the original order
+  if (x[0] != y[0]) {
+    return (x[0] < y[0]) - (x[0] > y[0]);
+  }
+  return (x[1] > y[1]) - (x[1] < y[1]);
+}
+
+void run_query_batch(Query_Executor *executor, PublData *data, Query *queries,
+                     int num_queries, FILE *out) {
+  int i, w;
+
+  if (executor == NULL || data == NULL || num_queries <= 0) {
+    return;
+  }
+
+  // Average number of citations per paper - how fast searches fan out
+  int64_t edges = 0;
+  int live = 0;
+  for (i = 0; i < data->num_papers; i++) {
+    edges += data->stats[i].in_degree;
+    live += data->papers[i] != NULL;
+  }
+  double fan_out = live ? (double)edges / live : 0;
+
+  // order[i] = {cost, query}
+  int64_t(*order)[2] = malloc(num_queries * sizeof(*order));
+  DIE(order == NULL, "order malloc");
+  for (i = 0; i < num_queries; i++) {
+    queries[i].cost = estimate_cost(data, &queries[i], fan_out) + 1;
+    order[i][0] = queries[i].cost;
+    order[i][1] = i;
+  }
+  qsort(order, num_queries, sizeof(*order), compare_costs);
+
+  // Dealt like cards - every deque stays sorted by cost
+  for (w = 0; w < executor->num_workers; w++) {
+    Executor_Worker *worker = &executor->workers[w];
+
+    int needed = num_queries / executor->num_workers + 1;
+    if (needed > worker->deque.cap) {
+      worker->deque.items =
+          realloc(worker->deque.items, needed * sizeof(int));
+      DIE(worker->deque.items == NULL, "deque.items realloc");
+      worker->deque.cap = needed;
+    }
+    worker->deque.head = 0;
+    worker->deque.tail = 0;
+
+    /*
+     * A view of its own. The cache stays warm across batches on the same
+     * data (its generations catch the changes), but entries from other data
+     * may point inside papers that are gone (another snapshot, say)
+     */
+    worker->view = *data;
+    if (data != executor->data) {
+      free_query_cache(worker->cache);
+      init_query_cache(worker->cache, QUERY_CACHE_SIZE);
+    }
+    worker->view.query_cache = worker->cache;
+    worker->view.scratch = worker->scratch;
+    worker->view.bfs_pool = NULL;
+    worker->view.serial_bfs = 1;
+  }
+  for (i = 0; i < num_queries; i++) {
+    Query_Deque *deque = &executor->workers[i % executor->num_workers].deque;
+    deque->items[deque->tail++] = (int)order[i][1];
+  }
+  free(order);
+
+  executor->data = data;
+  executor->queries = queries;
+  executor->num_queries = num_queries;
+  executor->out = out;
+  executor->printed = 0;
+  executor->done = calloc(num_queries, sizeof(atomic_char));
+  DIE(executor->done == NULL, "executor->done calloc");
+
+  run_on_pool(executor->pool, run_worker, executor);
+  print_ready(executor);
+
+  free(executor->done);
+  executor->done = NULL;
+}
+
+void free_query_executor(Query_Executor *executor) {
+  int i;
+
+  if (executor == NULL) {
+    return;
+  }
+
+  free_thread_pool(executor->pool);
+  free(executor->pool);
+  for (i = 0; i < executor->num_workers; i++) {
+    Executor_Worker *worker = &executor->workers[i];
+    free_query_cache(worker->cache);
+    free(worker->cache);
+    free_traversal_scratch(worker->scratch);
+    free(worker->deque.items);
+    pthread_mutex_destroy(&worker->deque.lock);
+  }
+  free(executor->workers);
+  free(executor);
+}
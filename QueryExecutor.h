@@ -0,0 +1,115 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef QUERY_EXECUTOR_H_
+#define QUERY_EXECUTOR_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "./publications.h"
+
+#define MAX_QUERY_ARGS 2
+
+typedef enum query_type {
+  QUERY_OLDEST_INFLUENCE,
+  QUERY_VENUE_IMPACT_FACTOR,
+  QUERY_VENUE_IMPACT_FACTOR_WINDOW,
+  QUERY_INFLUENCED_PAPERS,
+  QUERY_PAPERS_BETWEEN_DATES,
+  QUERY_AUTHORS_WITH_FIELD,
+  QUERY_HISTOGRAM_OF_CITATIONS
+} Query_Type;
+
+/*
+ * A parsed command, e.g.
+ *   get_number_of_influenced_papers 42 3
+ *   get_number_of_authors_with_field "Some University" "Computer science"
+ *   get_venue_impact_factor_window 2019 2 VLDB
+ * Arguments are separated by whitespace; quoted ones may contain it.
+ */
+typedef struct query {
+  Query_Type type;
+  int64_t id;  // Paper / author
+  int numbers[MAX_QUERY_ARGS];  // max_dist, the two dates, or year & window
+  char *strings[MAX_QUERY_ARGS];  // Venue, or institution & field
+
+  // Filled in by run_query_batch
+  int64_t cost;  // Estimated
+  int value;
+  float impact_factor;
+  char *title;  // Not owned - points inside the data
+  int *histogram;  // Owned
+  int partial;  // Stopped by the executor's limit (see Query_Limit)
+} Query;
+
+/* 0, or -1 if the line is not a known query (query is then left empty) */
+int parse_query(const char *line, Query *query);
+
+/* Prints the result on a line of its own, partial ones ending in " PARTIAL" */
+void print_query_result(FILE *out, Query *query);
+
+void free_query(Query *query);
+
+/*
+ * Query Executor - runs batches of queries on a thread pool
+ * Every query gets a cost estimate from cheap signals (degrees, posting
+ * list lengths) and the batch is dealt, most expensive first, to per-worker
+ * deques. A worker takes its own queries from the expensive end and, once
+ * out of work, steals from the cheap end of the others' deques - the big
+ * queries start first and the small ones fill the gaps.
+ * Queries write (visited marks, the cache), so every worker queries through
+ * its own view of the data (as the snapshot readers do, see Snapshots.h),
+ * and the parallel BFS stays off inside - the parallelism is across queries.
+ * The traversal queries (tasks 1 and 3) run under a limit: query_timeout_ms
+ * from when each one starts, and the cancelled flag - a query stopped by it
+ * gets the partial answer (see Query_Limit).
+ */
+typedef struct query_deque {
+  pthread_mutex_t lock;
+  int *items;  // Query indices, most expensive first
+  int cap;  // Kept across batches, grows as needed
+  int head;  // Next one for the owner
+  int tail;  // One past the next one for thieves
+} Query_Deque;
+
+typedef struct executor_worker {
+  PublData view;
+  struct Query_Cache *cache;
+  struct Traversal_Scratch *scratch;
+  Query_Deque deque;
+} Executor_Worker;
+
+typedef struct Query_Executor {
+  struct Thread_Pool *pool;
+  Executor_Worker *workers;
+  int num_workers;
+
+  // The current batch (data - also the last one the caches saw)
+  PublData *data;
+  Query *queries;
+  int num_queries;
+  atomic_char *done;  // By query
+  FILE *out;
+  int printed;  // Results printed so far (by worker 0, in order)
+
+  int64_t query_timeout_ms;  // 0 - none
+  atomic_int cancelled;  // Set to stop the queries running (until cleared)
+} Query_Executor;
+
+/* num_workers <= 0 => one per online CPU (see init_thread_pool) */
+Query_Executor *init_query_executor(int num_workers);
+
+/*
+ * Runs the queries on data, which must not change meanwhile (a snapshot -
+ * see enter_snapshot - is fine). If out is not NULL, the results are printed
+ * there in the order of the queries, as soon as all the ones before are done.
+ */
+void run_query_batch(Query_Executor *executor, PublData *data, Query *queries,
+                     int num_queries, FILE *out);
+
+void free_query_executor(Query_Executor *executor);
+
+#endif /* QUERY_EXECUTOR_H_ */
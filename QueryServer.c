@@ -0,0 +1,445 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "./GenericHT.h"
+#include "./PaperOps.h"
+#include "./QueryExecutor.h"
+#include "./QueryServer.h"
+#include "./WriteAheadLog.h"
+#include "./publications.h"
+
+int init_query_server(Query_Server *server, PublData *data, const char *path,
+                      int num_workers) {
+  struct sockaddr_un addr;
+
+  memset(server, 0, sizeof(Query_Server));
+  server->data = data;
+  server->listen_fd = -1;
+
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path, strlen(path) + 1);
+
+  server->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server->listen_fd < 0) {
+    return -1;
+  }
+
+  unlink(path);
+  if (bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      listen(server->listen_fd, SERVER_BACKLOG) < 0) {
+    int err = errno;
+    close(server->listen_fd);
+    server->listen_fd = -1;
+    errno = err;
+    return -1;
+  }
+  fcntl(server->listen_fd, F_SETFL, O_NONBLOCK);
+
+  server->path = copy_string(path);
+  server->executor = init_query_executor(num_workers);
+
+  return 0;
+}
+
+/* ------------------------- Commands ------------------------- */
+static void run_queries(Query_Server *server, Query *queries, int *num_queries,
+                        FILE *out) {
+  int i;
+
+  // Writer side - what the changes made stale is redone before the workers
+  // read it (queries never change the data)
+  if (server->changed) {
+    refresh_hub_counts(server->data);
+    refresh_influence_sketches(server->data);
+    server->changed = 0;
+  }
+
+  server->executor->query_timeout_ms = server->query_timeout_ms;
+  run_query_batch(server->executor, server->data, queries, *num_queries, out);
+  for (i = 0; i < *num_queries; i++) {
+    free_query(&queries[i]);
+  }
+  *num_queries = 0;
+}
+
+void run_commands(Query_Server *server, char **lines, int num_lines,
+                  FILE *out) {
+  Paper_Op op;
+  int i, num_queries = 0;
+
+  Query *queries = malloc((num_lines ? num_lines : 1) * sizeof(Query));
+  DIE(queries == NULL, "queries malloc");
+
+  for (i = 0; i < num_lines; i++) {
+    if (parse_query(lines[i], &queries[num_queries]) == 0) {
+      num_queries++;
+      continue;
+    }
+
+    // A change - the queries before it see the data as it was
+    if (num_queries) {
+      run_queries(server, queries, &num_queries, out);
+    }
+
+    if (parse_paper_op(lines[i], &op) < 0) {
+      if (out) {
+        fprintf(out, "ERROR unknown command\n");
+      }
+      continue;
+    }
+
+    if (server->read_only) {
+      if (out) {
+        fprintf(out, "ERROR read-only\n");
+      }
+    } else {
+      if (server->wal) {
+        wal_apply(server->wal, server->data, &op);
+      } else {
+        apply_paper_op(server->data, &op);
+      }
+      server->changed = 1;
+      if (out) {
+        fprintf(out, "OK\n");
+      }
+    }
+    free_paper_op(&op);
+  }
+
+  if (num_queries) {
+    run_queries(server, queries, &num_queries, out);
+  }
+  free(queries);
+}
+
+/* Splits buf[0..len) in lines (in place), without the empty ones */
+static int split_lines(char *buf, size_t len, char ***lines, int *cap) {
+  int n = 0;
+  size_t start = 0, i;
+
+  for (i = 0; i < len; i++) {
+    if (buf[i] != '\n') {
+      continue;
+    }
+
+    buf[i] = '\0';
+    if (i > start && buf[i - 1] == '\r') {
+      buf[i - 1] = '\0';
+    }
+    if (buf[start] != '\0') {
+      if (n == *cap) {
+        *cap = *cap ? 2 * *cap : VECTOR_MIN_CAPACITY;
+        *lines = realloc(*lines, *cap * sizeof(char *));
+        DIE(*lines == NULL, "lines realloc");
+      }
+      (*lines)[n++] = buf + start;
+    }
+    start = i + 1;
+  }
+
+  return n;
+}
+
+void load_commands(Query_Server *server, FILE *in) {
+  char *line = NULL;
+  size_t len = 0;
+  ssize_t read;
+
+  // Line by line - a whole file of changes does not need to be in memory
+  while ((read = getline(&line, &len, in)) >= 0) {
+    if (read && line[read - 1] == '\n') {
+      line[read - 1] = '\0';
+    }
+    if (line[0] != '\0') {
+      run_commands(server, &line, 1, NULL);
+    }
+  }
+
+  free(line);
+  if (server->wal) {
+    wal_sync(server->wal);
+  }
+}
+
+/* ------------------------- Clients ------------------------- */
+static void add_client(Query_Server *server, int fd) {
+  if (server->num_clients == server->cap_clients) {
+    server->cap_clients =
+        server->cap_clients ? 2 * server->cap_clients : VECTOR_MIN_CAPACITY;
+    server->clients = realloc(server->clients,
+                              server->cap_clients * sizeof(Server_Client));
+    DIE(server->clients == NULL, "server->clients realloc");
+  }
+
+  Server_Client *client = &server->clients[server->num_clients++];
+  memset(client, 0, sizeof(Server_Client));
+  client->fd = fd;
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+}
+
+static void close_client(Query_Server *server, int i) {
+  Server_Client *client = &server->clients[i];
+
+  close(client->fd);
+  free(client->in);
+  free(client->out);
+  server->clients[i] = server->clients[--server->num_clients];
+}
+
+/* Sends what it can; -1 if the client is gone */
+static int flush_client(Server_Client *client) {
+  while (client->out_sent < client->out_len) {
+    ssize_t sent = send(client->fd, client->out + client->out_sent,
+                        client->out_len - client->out_sent, MSG_NOSIGNAL);
+    if (sent < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    }
+    client->out_sent += sent;
+  }
+
+  free(client->out);
+  client->out = NULL;
+  client->out_len = 0;
+  client->out_sent = 0;
+
+  return 0;
+}
+
+/* Appends the answers of a batch to what the client still has to get */
+static void queue_answers(Server_Client *client, char *answers, size_t len) {
+  if (client->out == NULL) {
+    client->out = answers;
+    client->out_len = len;
+    return;
+  }
+
+  client->out = realloc(client->out, client->out_len + len);
+  DIE(client->out == NULL, "client->out realloc");
+  memcpy(client->out + client->out_len, answers, len);
+  client->out_len += len;
+  free(answers);
+}
+
+/* Everything that arrived - one batch, one answer; -1 if the client is gone */
+static int serve_client(Query_Server *server, Server_Client *client,
+                        char ***lines, int *cap_lines) {
+  int i, n;
+
+  if (client->in_cap - client->in_len < SERVER_READ_SIZE) {
+    client->in_cap = client->in_len + SERVER_READ_SIZE;
+    client->in = realloc(client->in, client->in_cap);
+    DIE(client->in == NULL, "client->in realloc");
+  }
+
+  ssize_t got = recv(client->fd, client->in + client->in_len,
+                     client->in_cap - client->in_len, 0);
+  if (got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+    return -1;
+  }
+  if (got < 0) {
+    return 0;
+  }
+  client->in_len += got;
+
+  // Only complete lines; the last one may still be on its way
+  size_t complete = client->in_len;
+  while (complete && client->in[complete - 1] != '\n') {
+    complete--;
+  }
+  if (complete == 0) {
+    return client->in_len > MAX_SERVER_LINE ? -1 : 0;
+  }
+
+  n = split_lines(client->in, complete, lines, cap_lines);
+  for (i = 0; i < n; i++) {
+    if (strcmp((*lines)[i], "quit") == 0) {
+      client->closing = 1;
+      n = i;
+    }
+  }
+
+  char *answers = NULL;
+  size_t len = 0;
+  FILE *out = open_memstream(&answers, &len);
+  DIE(out == NULL, "open_memstream");
+  run_commands(server, *lines, n, out);
+  fclose(out);
+
+  // One sync for all the changes of the batch (a no-op without any)
+  if (server->wal) {
+    wal_sync(server->wal);
+  }
+  queue_answers(client, answers, len);
+
+  memmove(client->in, client->in + complete, client->in_len - complete);
+  client->in_len -= complete;
+
+  return flush_client(client);
+}
+
+void serve_queries(Query_Server *server) {
+  struct pollfd *fds = NULL;
+  char **lines = NULL;
+  int i, cap_fds = 0, cap_lines = 0;
+
+  while (!server->stop) {
+    if (cap_fds < server->num_clients + 1) {
+      cap_fds = 2 * (server->num_clients + 1);
+      fds = realloc(fds, cap_fds * sizeof(struct pollfd));
+      DIE(fds == NULL, "fds realloc");
+    }
+
+    fds[0].fd = server->listen_fd;
+    fds[0].events = POLLIN;
+    for (i = 0; i < server->num_clients; i++) {
+      Server_Client *client = &server->clients[i];
+      fds[i + 1].fd = client->fd;
+      fds[i + 1].events = client->out_len ? POLLOUT : POLLIN;
+    }
+
+    int num_fds = server->num_clients + 1;
+    if (poll(fds, num_fds, SERVER_POLL_MS) <= 0) {
+      continue;
+    }
+
+    // Backwards - closing a client moves the last one in its place
+    for (i = num_fds - 2; i >= 0; i--) {
+      Server_Client *client = &server->clients[i];
+      short events = fds[i + 1].revents;
+      int gone = 0;
+
+      if (events & POLLOUT) {
+        gone = flush_client(client) < 0;
+      } else if (events & POLLIN) {
+        gone = serve_client(server, client, &lines, &cap_lines) < 0;
+      } else if (events & (POLLERR | POLLHUP | POLLNVAL)) {
+        gone = 1;
+      }
+
+      if (gone || (client->closing && client->out_len == 0)) {
+        close_client(server, i);
+      }
+    }
+
+    if (fds[0].revents & POLLIN) {
+      int fd;
+      while ((fd = accept(server->listen_fd, NULL, NULL)) >= 0) {
+        add_client(server, fd);
+      }
+    }
+  }
+
+  free(fds);
+  free(lines);
+}
+
+/* ------------------------- Pre-fork ------------------------- */
+static void close_clients(Query_Server *server) {
+  while (server->num_clients) {
+    close_client(server, server->num_clients - 1);
+  }
+  free(server->clients);
+  server->clients = NULL;
+  server->cap_clients = 0;
+}
+
+static pid_t fork_worker(Query_Server *server) {
+  pid_t pid = fork();
+  DIE(pid < 0, "fork");
+  if (pid) {
+    return pid;
+  }
+
+  // The parent's threads (log flusher etc.) do not exist in here
+  server->wal = NULL;
+  server->read_only = 1;
+  server->executor = init_query_executor(1);
+
+  serve_queries(server);
+
+  // The socket and the data stay the parent's
+  close_clients(server);
+  close(server->listen_fd);
+  free_query_executor(server->executor);
+  _exit(EXIT_SUCCESS);
+}
+
+void serve_queries_forked(Query_Server *server, int num_processes) {
+  pid_t pid;
+  int i, status;
+
+  pid_t *workers = calloc(num_processes, sizeof(pid_t));
+  DIE(workers == NULL, "workers calloc");
+
+  // Its threads would not survive the fork - every worker makes its own
+  free_query_executor(server->executor);
+  server->executor = NULL;
+
+  for (i = 0; i < num_processes; i++) {
+    workers[i] = fork_worker(server);
+  }
+
+  while (!server->stop) {
+    poll(NULL, 0, SERVER_POLL_MS);
+
+    // A worker that died is replaced - the data is still the same
+    while (!server->stop && (pid = waitpid(-1, &status, WNOHANG)) > 0) {
+      for (i = 0; i < num_processes; i++) {
+        if (workers[i] == pid) {
+          workers[i] = fork_worker(server);
+        }
+      }
+    }
+  }
+
+  for (i = 0; i < num_processes; i++) {
+    kill(workers[i], SIGTERM);
+  }
+  for (i = 0; i < num_processes; i++) {
+    waitpid(workers[i], &status, 0);
+  }
+  free(workers);
+}
+
+void stop_query_server(Query_Server *server) {
+  server->stop = 1;
+
+  // The queries running are cut short (atomic_int is lock-free)
+  if (server->executor) {
+    atomic_store(&server->executor->cancelled, 1);
+  }
+}
+
+void free_query_server(Query_Server *server) {
+  if (server == NULL) {
+    return;
+  }
+
+  close_clients(server);
+
+  if (server->listen_fd >= 0) {
+    close(server->listen_fd);
+    unlink(server->path);
+  }
+  free(server->path);
+  free_query_executor(server->executor);
+}
@@ -0,0 +1,99 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef QUERY_SERVER_H_
+#define QUERY_SERVER_H_
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "./publications.h"
+
+#define SERVER_BACKLOG 64
+#define SERVER_READ_SIZE (1 << 16)
+#define MAX_SERVER_LINE (1 << 24)  // A client sending more without '\n' is cut
+#define SERVER_POLL_MS 200  // How often a stop request is noticed
+
+/*
+ * Query Server - keeps the data loaded and answers over a Unix socket
+ * Line protocol, same syntax as the command files: every non-empty line is a
+ * query (see parse_query) or a change (see parse_paper_op), and gets exactly
+ * one line back - the result, "OK" for a change, or "ERROR ..." - in order.
+ * "quit" closes the connection.
+ * Clients may pipeline: everything that arrived in one read is run as one
+ * batch (the queries between two changes go to the Query_Executor together)
+ * and answered with a single write.
+ * With a Write_Ahead_Log, the changes are logged as they are applied and
+ * the answers of a batch only go out once its changes are on disk.
+ * With query_timeout_ms, a traversal query running longer stops at the end
+ * of a level and answers what it found so far, followed by " PARTIAL"
+ * (see Query_Limit); stopping the server cuts the running ones short too.
+ *
+ * Pre-fork mode (serve_queries_forked): the data is loaded once, then
+ * worker processes are forked and all of them accept on the socket. A fork
+ * shares the loaded data (copy-on-write, at the same addresses, so every
+ * pointer in it stays valid) and queries only read it - each worker goes
+ * through a view with its own traversal scratch and cache, like the
+ * Query_Executor threads - so the data is in memory once, however many
+ * workers there are. The workers are read-only: changes get an error.
+ */
+typedef struct server_client {
+  int fd;
+  char *in;  // Bytes read, up to a partial last line
+  size_t in_len;
+  size_t in_cap;
+  char *out;  // Answers not sent yet
+  size_t out_len;
+  size_t out_sent;
+  int closing;  // Closed once out is sent
+} Server_Client;
+
+typedef struct Query_Server {
+  PublData *data;
+  struct Query_Executor *executor;
+  struct Write_Ahead_Log *wal;  // NULL unless the changes are logged
+  int read_only;  // Changes are refused (pre-fork workers)
+  int changed;  // Changes applied since the last batch of queries
+  int64_t query_timeout_ms;  // 0 - none
+  int listen_fd;
+  char *path;
+
+  Server_Client *clients;
+  int num_clients;
+  int cap_clients;
+
+  volatile sig_atomic_t stop;
+} Query_Server;
+
+/*
+ * Binds the socket (replacing a stale one at path)
+ * Returns 0, or -1 with errno set
+ */
+int init_query_server(Query_Server *server, PublData *data, const char *path,
+                      int num_workers);
+
+/* Runs the command lines, writing the answers to out (if not NULL) */
+void run_commands(Query_Server *server, char **lines, int num_lines,
+                  FILE *out);
+
+/* Runs a whole command file (e.g. the initial load), answers dropped */
+void load_commands(Query_Server *server, FILE *in);
+
+/* Serves the clients until stop_query_server */
+void serve_queries(Query_Server *server);
+
+/*
+ * Serves the clients from num_processes forked workers (restarting any that
+ * dies) until stop_query_server, then stops them. The data must not change
+ * meanwhile.
+ */
+void serve_queries_forked(Query_Server *server, int num_processes);
+
+/* Safe to call from a signal handler */
+void stop_query_server(Query_Server *server);
+
+/* Closes the clients and removes the socket (the data stays) */
+void free_query_server(Query_Server *server);
+
+#endif /* QUERY_SERVER_H_ */
@@ -0,0 +1,588 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./EdgeList.h"
+#include "./Hashtables.h"
+#include "./PaperOps.h"
+#include "./Shards.h"
+#include "./ThreadPool.h"
+#include "./publications.h"
+#include "./utils.h"
+
+/* Allocated by the owning thread - its memory is local to it */
+static void init_shard(void *arg, int s) {
+  Publ_Shards *shards = arg;
+
+  shards->shards[s] = init_publ_data();
+}
+
+Publ_Shards *init_publ_shards(int num_shards) {
+  Publ_Shards *shards = calloc(1, sizeof(Publ_Shards));
+  DIE(shards == NULL, "shards calloc");
+
+  shards->pool = calloc(1, sizeof(Thread_Pool));
+  DIE(shards->pool == NULL, "shards->pool calloc");
+  init_thread_pool(shards->pool, num_shards);
+  shards->num_shards = shards->pool->num_workers;
+  int n = shards->num_shards;
+
+  shards->shards = calloc(n, sizeof(PublData *));
+  DIE(shards->shards == NULL, "shards->shards calloc");
+  run_on_pool(shards->pool, init_shard, shards);
+
+  // One cache line each - the threads write them side by side
+  shards->results = aligned_alloc(CACHE_LINE, n * sizeof(Shard_Result));
+  DIE(shards->results == NULL, "shards->results aligned_alloc");
+  memset(shards->results, 0, n * sizeof(Shard_Result));
+
+  shards->mail[0] = calloc(n * n, sizeof(Id_List));
+  shards->mail[1] = calloc(n * n, sizeof(Id_List));
+  shards->notes = calloc(n * n, sizeof(Citation_Notes));
+  DIE(shards->mail[0] == NULL || shards->mail[1] == NULL ||
+          shards->notes == NULL,
+      "shards mailboxes calloc");
+
+  return shards;
+}
+
+void destroy_publ_shards(Publ_Shards *shards) {
+  int i;
+
+  if (shards == NULL) {
+    return;
+  }
+
+  free_thread_pool(shards->pool);
+  free(shards->pool);
+
+  for (i = 0; i < shards->num_shards; i++) {
+    destroy_publ_data(shards->shards[i]);
+    id_list_free(&shards->results[i].found);
+    free(shards->results[i].histogram);
+  }
+  for (i = 0; i < shards->num_shards * shards->num_shards; i++) {
+    id_list_free(&shards->mail[0][i]);
+    id_list_free(&shards->mail[1][i]);
+    citation_notes_free(&shards->notes[i]);
+  }
+
+  free(shards->shards);
+  free(shards->results);
+  free(shards->mail[0]);
+  free(shards->mail[1]);
+  free(shards->notes);
+  id_list_free(&shards->frontier);
+  free(shards);
+}
+
+/* ------------------------- Changes ------------------------- */
+static void send_note(Citation_Notes *notes, int from, int num_shards,
+                      int64_t cited_id, int delta) {
+  int to = owner_shard(cited_id, num_shards);
+
+  // Citations inside the shard are counted by add_paper / remove_paper
+  if (to != from) {
+    Citation_Note note = {cited_id, delta};
+    citation_notes_push(&notes[to], note);
+  }
+}
+
+static void remove_own_paper(PublData *data, int s, int num_shards,
+                             Paper *publication, Citation_Notes *notes) {
+  int64_t id = publication->id;
+  Edge_Iter it;
+  uint64_t cited_id;
+
+  // Citations from the other shards (not in its list of imitators)
+  int remote = data->columns->citations[publication->idx] -
+               data->stats[publication->idx].in_degree;
+
+  edge_iter_init(&it, &publication->info->references);
+  while (edge_iter_next(&it, &cited_id)) {
+    send_note(notes, s, num_shards, (int64_t)cited_id, -1);
+  }
+
+  remove_paper(data, id);
+
+  // ... wait for it again, like the local ones
+  for (; remote > 0; remote--) {
+    add_citation(data->citations_ht, id);
+  }
+}
+
+void shard_apply_ops(PublData *data, int s, int num_shards,
+                     const Paper_Op *ops, int num_ops,
+                     Citation_Notes *notes) {
+  int i, j;
+
+  for (i = 0; i < num_ops; i++) {
+    const Paper_Op *op = &ops[i];
+    if (owner_shard(op->id, num_shards) != s) {
+      continue;
+    }
+
+    // IDs are unique - a paper is only added once
+    Paper *old = find_paper_with_id(data, op->id);
+    if (old && op->type == OP_ADD_PAPER) {
+      continue;
+    }
+    if (old) {
+      remove_own_paper(data, s, num_shards, old, notes);
+    }
+    if (op->type == OP_REMOVE_PAPER) {
+      continue;
+    }
+
+    add_paper(data, op->title, op->venue, op->year,
+              (const char **)op->author_names, op->author_ids,
+              (const char **)op->institutions, op->num_authors,
+              (const char **)op->fields, op->num_fields, op->id,
+              op->references, op->num_refs);
+    for (j = 0; j < op->num_refs; j++) {
+      send_note(notes, s, num_shards, op->references[j], +1);
+    }
+  }
+}
+
+void shard_apply_notes(PublData *data, Citation_Notes *notes) {
+  int i;
+
+  for (i = 0; i < notes->size; i++) {
+    Citation_Note *note = &notes->items[i];
+    Paper *cited = find_paper_with_id(data, note->id);
+
+    if (cited) {
+      data->columns->citations[cited->idx] += note->delta;
+      touch_cited_paper(data, cited);
+    } else if (note->delta > 0) {
+      // Carried over when the paper gets added (see register_paper)
+      add_citation(data->citations_ht, note->id);
+    } else {
+      remove_citation(data->citations_ht, note->id);
+    }
+  }
+  notes->size = 0;
+}
+
+/* Phase 1 - every shard applies its own changes, in order */
+static void apply_own_ops(void *arg, int s) {
+  Publ_Shards *shards = arg;
+  int n = shards->num_shards;
+
+  shard_apply_ops(shards->shards[s], s, n, shards->ops, shards->num_ops,
+                  &shards->notes[s * n]);
+}
+
+/* Phase 2 - every shard counts the citations its papers got from the others */
+static void apply_citation_notes(void *arg, int s) {
+  Publ_Shards *shards = arg;
+  int from;
+
+  for (from = 0; from < shards->num_shards; from++) {
+    shard_apply_notes(shards->shards[s],
+                      &shards->notes[from * shards->num_shards + s]);
+  }
+}
+
+void shards_apply(Publ_Shards *shards, Paper_Op *ops, int num_ops) {
+  if (shards == NULL || num_ops <= 0) {
+    return;
+  }
+
+  shards->ops = ops;
+  shards->num_ops = num_ops;
+  run_on_pool(shards->pool, apply_own_ops, shards);
+  run_on_pool(shards->pool, apply_citation_notes, shards);
+  shards->ops = NULL;
+}
+
+void shards_add_paper(Publ_Shards *shards, const char *title,
+                      const char *venue, const int year,
+                      const char **author_names, const int64_t *author_ids,
+                      const char **institutions, const int num_authors,
+                      const char **fields, const int num_fields,
+                      const int64_t id, const int64_t *references,
+                      const int num_refs) {
+  // The arguments are only read - no need for copies
+  Paper_Op op = {.type = OP_ADD_PAPER,
+                 .id = id,
+                 .title = (char *)title,
+                 .venue = (char *)venue,
+                 .year = year,
+                 .author_names = (char **)author_names,
+                 .author_ids = (int64_t *)author_ids,
+                 .institutions = (char **)institutions,
+                 .num_authors = num_authors,
+                 .fields = (char **)fields,
+                 .num_fields = num_fields,
+                 .references = (int64_t *)references,
+                 .num_refs = num_refs};
+
+  shards_apply(shards, &op, 1);
+}
+
+void shards_update_paper(Publ_Shards *shards, const char *title,
+                         const char *venue, const int year,
+                         const char **author_names, const int64_t *author_ids,
+                         const char **institutions, const int num_authors,
+                         const char **fields, const int num_fields,
+                         const int64_t id, const int64_t *references,
+                         const int num_refs) {
+  Paper_Op op = {.type = OP_UPDATE_PAPER,
+                 .id = id,
+                 .title = (char *)title,
+                 .venue = (char *)venue,
+                 .year = year,
+                 .author_names = (char **)author_names,
+                 .author_ids = (int64_t *)author_ids,
+                 .institutions = (char **)institutions,
+                 .num_authors = num_authors,
+                 .fields = (char **)fields,
+                 .num_fields = num_fields,
+                 .references = (int64_t *)references,
+                 .num_refs = num_refs};
+
+  shards_apply(shards, &op, 1);
+}
+
+void shards_remove_paper(Publ_Shards *shards, const int64_t id) {
+  Paper_Op op = {.type = OP_REMOVE_PAPER, .id = id};
+
+  shards_apply(shards, &op, 1);
+}
+
+/* ------------------------- Searches ------------------------- */
+static int mail_pending(Publ_Shards *shards) {
+  int i;
+  Id_List *mail = shards->mail[shards->turn];
+
+  for (i = 0; i < shards->num_shards * shards->num_shards; i++) {
+    if (mail[i].size) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+void shard_begin_search(PublData *data, int64_t id) {
+  Traversal_Scratch *scratch = begin_traversal(data);
+
+  Paper *starting_paper = find_paper_with_id(data, id);
+  if (starting_paper) {
+    visit_paper(scratch, starting_paper->idx);
+  }
+}
+
+/* New round of visited marks in every shard, the starting paper marked */
+static void begin_search(void *arg, int s) {
+  Publ_Shards *shards = arg;
+
+  shard_begin_search(shards->shards[s], shards->id);
+  shards->results[s].best = NULL;
+  shards->results[s].found.size = 0;
+}
+
+/* ---------------- Task 1 ---------------- */
+static void send_references(Paper *vertex, int num_shards, Id_List *out) {
+  Edge_Iter it;
+  uint64_t cited_id;
+
+  edge_iter_init(&it, &vertex->info->references);
+  while (edge_iter_next(&it, &cited_id)) {
+    id_list_push(&out[owner_shard((int64_t)cited_id, num_shards)],
+                 (int64_t)cited_id);
+  }
+}
+
+int shard_start_references(PublData *data, int num_shards, int64_t id,
+                           Id_List *out) {
+  Paper *starting_paper = find_paper_with_id(data, id);
+  if (starting_paper == NULL) {
+    return 0;
+  }
+
+  send_references(starting_paper, num_shards, out);
+
+  return 1;
+}
+
+void shard_expand_references(PublData *data, int num_shards, Id_List *in,
+                             Id_List *out, Paper **best) {
+  int i;
+
+  for (i = 0; i < in->size; i++) {
+    Paper *vertex = find_paper_with_id(data, in->items[i]);
+    if (vertex == NULL || !visit_paper(data->scratch, vertex->idx)) {
+      continue;
+    }
+
+    // Citation counts are whole in the owner => compare_task1 holds
+    if (*best == NULL || compare_task1(data, vertex, *best) > 0) {
+      *best = vertex;
+    }
+
+    send_references(vertex, num_shards, out);
+  }
+  in->size = 0;
+}
+
+/*
+ * One level: the papers sent to this shard that it has (and did not visit
+ * yet) are candidates, and their references go to their owners
+ */
+static void expand_references(void *arg, int s) {
+  Publ_Shards *shards = arg;
+  int n = shards->num_shards;
+  int from;
+
+  for (from = 0; from < n; from++) {
+    shard_expand_references(shards->shards[s], n,
+                            &shards->mail[shards->turn][from * n + s],
+                            &shards->mail[!shards->turn][s * n],
+                            &shards->results[s].best);
+  }
+}
+
+/* Same order as compare_task1, for papers of different shards */
+int is_older_influence(const Influence_Candidate *challenger,
+                       const Influence_Candidate *titleholder) {
+  if (challenger->year != titleholder->year) {
+    return challenger->year < titleholder->year;
+  }
+
+  if (challenger->citations != titleholder->citations) {
+    return challenger->citations > titleholder->citations;
+  }
+
+  return challenger->id < titleholder->id;
+}
+
+char *shards_get_oldest_influence(Publ_Shards *shards,
+                                  const int64_t id_paper) {
+  Influence_Candidate oldest_influence = {0}, candidate;
+  int s;
+
+  int owner = shard_of(shards, id_paper);
+  if (find_paper_with_id(shards->shards[owner], id_paper) == NULL) {
+    return "None";
+  }
+
+  shards->id = id_paper;
+  run_on_pool(shards->pool, begin_search, shards);
+
+  // The first level - its references, sent to their owners
+  shards->turn = 0;
+  shard_start_references(shards->shards[owner], shards->num_shards, id_paper,
+                         &shards->mail[0][owner * shards->num_shards]);
+
+  while (mail_pending(shards)) {
+    run_on_pool(shards->pool, expand_references, shards);
+    shards->turn = !shards->turn;
+  }
+
+  for (s = 0; s < shards->num_shards; s++) {
+    Paper *best = shards->results[s].best;
+    if (best == NULL) {
+      continue;
+    }
+
+    candidate.id = best->id;
+    candidate.year = best->year;
+    candidate.citations = get_paper_citations(shards->shards[s], best);
+    candidate.title = best->info->title;
+    if (oldest_influence.title == NULL ||
+        is_older_influence(&candidate, &oldest_influence)) {
+      oldest_influence = candidate;
+    }
+  }
+
+  return oldest_influence.title ? (char *)oldest_influence.title : "None";
+}
+
+/* ---------------- Task 3 ---------------- */
+static inline void reach_citing(PublData *data, int idx, Id_List *found) {
+  if (data->papers[idx] && visit_paper(data->scratch, idx)) {
+    id_list_push(found, data->papers[idx]->id);
+  }
+}
+
+void shard_expand_citations(PublData *data, int s, int num_shards,
+                            const Id_List *frontier, Id_List *found) {
+  Edge_Iter it;
+  int i, j;
+
+  for (i = 0; i < frontier->size; i++) {
+    int64_t id = frontier->items[i];
+    Paper *cited = owner_shard(id, num_shards) == s
+                       ? find_paper_with_id(data, id)
+                       : NULL;
+
+    if (cited) {
+      edge_iter_init(&it, &cited->influenced);
+      while (edge_iter_next_idx(&it, &j)) {
+        reach_citing(data, j, found);
+      }
+      continue;
+    }
+
+    Idx_List *waiting = pending_ht_get(data->pending_ht, id);
+    for (j = 0; waiting && j < waiting->size; j++) {
+      reach_citing(data, waiting->items[j], found);
+    }
+  }
+}
+
+/* One level: every shard gets the whole frontier */
+static void expand_citations(void *arg, int s) {
+  Publ_Shards *shards = arg;
+  Id_List *found = &shards->results[s].found;
+
+  found->size = 0;
+  shard_expand_citations(shards->shards[s], s, shards->num_shards,
+                         &shards->frontier, found);
+}
+
+int shards_get_number_of_influenced_papers(Publ_Shards *shards,
+                                           const int64_t id_paper,
+                                           const int max_dist) {
+  int i, s, distance, cnt = 0;
+
+  if (max_dist <= 0) {
+    return 0;
+  }
+
+  shards->id = id_paper;
+  run_on_pool(shards->pool, begin_search, shards);
+
+  /*
+   * The first level are the papers citing it - whether it was added or not
+   * (then they are all pending)
+   */
+  shards->frontier.size = 0;
+  id_list_push(&shards->frontier, id_paper);
+  for (distance = 0; distance < max_dist && shards->frontier.size;
+       distance++) {
+    run_on_pool(shards->pool, expand_citations, shards);
+
+    shards->frontier.size = 0;
+    for (s = 0; s < shards->num_shards; s++) {
+      Id_List *found = &shards->results[s].found;
+      for (i = 0; i < found->size; i++) {
+        id_list_push(&shards->frontier, found->items[i]);
+      }
+    }
+    cnt += shards->frontier.size;
+  }
+
+  return cnt;
+}
+
+/* ------------------------- Aggregates ------------------------- */
+void shard_sum_venue_citations(PublData *data, const char *venue,
+                               int64_t *sum, int *count) {
+  int i;
+
+  Paper_Postings *venue_papers = venue_ht_get(data->venue_ht, venue);
+  *sum = 0;
+  *count = 0;
+  if (venue_papers) {
+    // Removed papers have their citations zeroed
+    for (i = 0; i < venue_papers->papers.size; i++) {
+      *sum += data->columns->citations[venue_papers->papers.items[i]];
+    }
+    *count = venue_papers->papers.size - venue_papers->removed;
+  }
+}
+
+static void sum_venue_citations(void *arg, int s) {
+  Publ_Shards *shards = arg;
+  Shard_Result *result = &shards->results[s];
+
+  shard_sum_venue_citations(shards->shards[s], shards->venue, &result->sum,
+                            &result->count);
+}
+
+float shards_get_venue_impact_factor(Publ_Shards *shards, const char *venue) {
+  int64_t x = 0;
+  int s, cnt = 0;
+
+  shards->venue = venue;
+  run_on_pool(shards->pool, sum_venue_citations, shards);
+  for (s = 0; s < shards->num_shards; s++) {
+    x += shards->results[s].sum;
+    cnt += shards->results[s].count;
+  }
+
+  if (cnt) {
+    return (float)x / cnt;
+  }
+
+  return 0.f;
+}
+
+static void count_shard_papers(void *arg, int s) {
+  Publ_Shards *shards = arg;
+
+  shards->results[s].count = get_number_of_papers_between_dates(
+      shards->shards[s], shards->numbers[0], shards->numbers[1]);
+}
+
+int shards_get_number_of_papers_between_dates(Publ_Shards *shards,
+                                              const int early_date,
+                                              const int late_date) {
+  int s, cnt = 0;
+
+  shards->numbers[0] = early_date;
+  shards->numbers[1] = late_date;
+  run_on_pool(shards->pool, count_shard_papers, shards);
+  for (s = 0; s < shards->num_shards; s++) {
+    cnt += shards->results[s].count;
+  }
+
+  return cnt;
+}
+
+static void shard_histogram(void *arg, int s) {
+  Publ_Shards *shards = arg;
+  Shard_Result *result = &shards->results[s];
+
+  free(result->histogram);
+  result->histogram = get_histogram_of_citations(shards->shards[s],
+                                                 shards->id,
+                                                 &result->num_years);
+}
+
+int *shards_get_histogram_of_citations(Publ_Shards *shards,
+                                       const int64_t id_author,
+                                       int *num_years) {
+  int s, i;
+
+  shards->id = id_author;
+  run_on_pool(shards->pool, shard_histogram, shards);
+
+  // Bins count back from CURR_YEAR - the longest one covers them all
+  *num_years = 0;
+  for (s = 0; s < shards->num_shards; s++) {
+    if (shards->results[s].num_years > *num_years) {
+      *num_years = shards->results[s].num_years;
+    }
+  }
+
+  int *histogram = calloc(*num_years, sizeof(int));
+  DIE(histogram == NULL, "histogram calloc");
+  for (s = 0; s < shards->num_shards; s++) {
+    Shard_Result *result = &shards->results[s];
+    for (i = 0; i < result->num_years; i++) {
+      histogram[i] += result->histogram[i];
+    }
+    free(result->histogram);
+    result->histogram = NULL;
+  }
+
+  return histogram;
+}
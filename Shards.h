@@ -0,0 +1,173 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef SHARDS_H_
+#define SHARDS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "./GenericHT.h"
+#include "./Hashtables.h"
+#include "./PaperOps.h"
+#include "./publications.h"
+
+/*
+ * Shards - the papers partitioned by ID (hash) over N PublData, each one
+ * owned by one thread of a pool: changes and searches run on all the shards
+ * at once, every shard touched only by its own thread.
+ * A shard is an ordinary PublData holding its own papers; the papers of the
+ * other shards are "not added" there, so a citation across shards is kept
+ * by the citing paper's shard as a pending edge (see Pending_HT). On top of
+ * that, the cited paper's shard is told about it (a citation note), so
+ * citation counts - and everything built on them - are whole in the shard
+ * owning the paper.
+ * Searches go level by level, the shards handing each other the papers
+ * reached (the frontier) in between:
+ *   - task 1 follows references: a shard sends the references of its papers
+ *     to the shards owning them
+ *   - task 3 follows citations: every shard gets the whole frontier and adds
+ *     its own papers citing it (resolved or pending edges)
+ * Aggregates (tasks 2, 6, 8) are computed by every shard on its own papers
+ * and merged.
+ * One caller at a time.
+ * The shard's part of each phase is below (shard_*), apart from how the
+ * shards reach each other - here it is memory, in Cluster.h other processes.
+ */
+typedef struct citation_note {
+  int64_t id;  // Cited paper
+  int delta;  // +1 / -1
+} Citation_Note;
+
+DEFINE_VECTOR(Citation_Notes, citation_notes, Citation_Note)
+
+/* The shard owning the paper */
+static inline int owner_shard(int64_t id, int num_shards) {
+  return (int)(hash_int64(id) % (uint64_t)num_shards);
+}
+
+/*
+ * One shard's part of each phase - data is shard s of num_shards; notes and
+ * out are its outboxes, one per shard (indexed by owner_shard)
+ */
+/* Applies the ops the shard owns, noting the citations across shards */
+void shard_apply_ops(PublData *data, int s, int num_shards,
+                     const Paper_Op *ops, int num_ops, Citation_Notes *notes);
+
+/* Counts the citations noted by one other shard (and empties notes) */
+void shard_apply_notes(PublData *data, Citation_Notes *notes);
+
+/* New round of visited marks, the starting paper marked if it is here */
+void shard_begin_search(PublData *data, int64_t id);
+
+/* Task 1, first level: 0 if the shard does not have the starting paper */
+int shard_start_references(PublData *data, int num_shards, int64_t id,
+                           Id_List *out);
+
+/*
+ * Task 1, one level: the papers in `in` (emptied) are candidates for *best,
+ * their references go to out
+ */
+void shard_expand_references(PublData *data, int num_shards, Id_List *in,
+                             Id_List *out, Paper **best);
+
+/* Task 3, one level: the shard's papers citing the frontier, to found */
+void shard_expand_citations(PublData *data, int s, int num_shards,
+                            const Id_List *frontier, Id_List *found);
+
+/* Task 2, the shard's part */
+void shard_sum_venue_citations(PublData *data, const char *venue,
+                               int64_t *sum, int *count);
+
+/* A shard's answer to task 1, as compared with the others' */
+typedef struct influence_candidate {
+  int64_t id;
+  int year;
+  int citations;
+  const char *title;
+} Influence_Candidate;
+
+/* Same order as compare_task1 */
+int is_older_influence(const Influence_Candidate *challenger,
+                       const Influence_Candidate *titleholder);
+
+/* What a shard's thread produced in the last phase */
+typedef struct shard_result {
+  _Alignas(CACHE_LINE) Id_List found;  // Papers reached (task 3)
+  Paper *best;  // Oldest influence so far (task 1)
+  int64_t sum;
+  int count;
+  int *histogram;
+  int num_years;
+} Shard_Result;
+
+typedef struct Publ_Shards {
+  int num_shards;
+  PublData **shards;
+  struct Thread_Pool *pool;  // Worker s owns shards[s]
+  Shard_Result *results;
+
+  /*
+   * Mailboxes, [from * num_shards + to]: filled by `from` in one phase,
+   * emptied by `to` in the next one (two sets, used in turns)
+   */
+  Id_List *mail[2];
+  int turn;  // The set being read
+  Citation_Notes *notes;
+
+  // Arguments of the current phase
+  Paper_Op *ops;
+  int num_ops;
+  Id_List frontier;
+  int64_t id;
+  const char *venue;
+  int numbers[2];
+} Publ_Shards;
+
+/* num_shards <= 0 => one per online CPU (see init_thread_pool) */
+Publ_Shards *init_publ_shards(int num_shards);
+
+void destroy_publ_shards(Publ_Shards *shards);
+
+static inline int shard_of(Publ_Shards *shards, int64_t id) {
+  return owner_shard(id, shards->num_shards);
+}
+
+/* Applies the changes in order (each shard its own, all shards at once) */
+void shards_apply(Publ_Shards *shards, Paper_Op *ops, int num_ops);
+
+/* Same as the PublData functions */
+void shards_add_paper(Publ_Shards *shards, const char *title,
+                      const char *venue, const int year,
+                      const char **author_names, const int64_t *author_ids,
+                      const char **institutions, const int num_authors,
+                      const char **fields, const int num_fields,
+                      const int64_t id, const int64_t *references,
+                      const int num_refs);
+
+void shards_update_paper(Publ_Shards *shards, const char *title,
+                         const char *venue, const int year,
+                         const char **author_names, const int64_t *author_ids,
+                         const char **institutions, const int num_authors,
+                         const char **fields, const int num_fields,
+                         const int64_t id, const int64_t *references,
+                         const int num_refs);
+
+void shards_remove_paper(Publ_Shards *shards, const int64_t id);
+
+char *shards_get_oldest_influence(Publ_Shards *shards, const int64_t id_paper);
+
+float shards_get_venue_impact_factor(Publ_Shards *shards, const char *venue);
+
+int shards_get_number_of_influenced_papers(Publ_Shards *shards,
+                                           const int64_t id_paper,
+                                           const int max_dist);
+
+int shards_get_number_of_papers_between_dates(Publ_Shards *shards,
+                                              const int early_date,
+                                              const int late_date);
+
+int *shards_get_histogram_of_citations(Publ_Shards *shards,
+                                       const int64_t id_author,
+                                       int *num_years);
+
+#endif /* SHARDS_H_ */
@@ -0,0 +1,234 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./PaperOps.h"
+#include "./QueryCache.h"
+#include "./Snapshots.h"
+#include "./ThreadPool.h"
+#include "./publications.h"
+#include "./utils.h"
+
+Publ_Snapshots *init_publ_snapshots(void) {
+  // The readers' epochs each get a cache line
+  Publ_Snapshots *snapshots =
+      aligned_alloc(CACHE_LINE, sizeof(Publ_Snapshots));
+  DIE(snapshots == NULL, "snapshots aligned_alloc");
+  memset(snapshots, 0, sizeof(Publ_Snapshots));
+
+  snapshots->replicas[0] = init_publ_data();
+  snapshots->replicas[1] = init_publ_data();
+  atomic_init(&snapshots->current, 0);
+
+  pthread_mutex_init(&snapshots->writer_lock, NULL);
+  pthread_mutex_init(&snapshots->readers_lock, NULL);
+
+  return snapshots;
+}
+
+/* ------------------------- Writer side ------------------------- */
+/* Kept to be replayed on the other replica after the next flip */
+static void log_op(Publ_Snapshots *snapshots, Paper_Op_Type type,
+                   const char *title, const char *venue, const int year,
+                   const char **author_names, const int64_t *author_ids,
+                   const char **institutions, const int num_authors,
+                   const char **fields, const int num_fields,
+                   const int64_t id, const int64_t *references,
+                   const int num_refs) {
+  Paper_Op op;
+
+  init_paper_op(&op, type, title, venue, year, author_names, author_ids,
+                institutions, num_authors, fields, num_fields, id, references,
+                num_refs);
+  op_log_push(&snapshots->log, op);
+}
+
+/* The replica nobody can be reading - the writer's own */
+static PublData *writer_replica(Publ_Snapshots *snapshots) {
+  return snapshots->replicas[!atomic_load(&snapshots->current)];
+}
+
+void snapshot_add_paper(Publ_Snapshots *snapshots, const char *title,
+                        const char *venue, const int year,
+                        const char **author_names, const int64_t *author_ids,
+                        const char **institutions, const int num_authors,
+                        const char **fields, const int num_fields,
+                        const int64_t id, const int64_t *references,
+                        const int num_refs) {
+  pthread_mutex_lock(&snapshots->writer_lock);
+  add_paper(writer_replica(snapshots), title, venue, year, author_names,
+            author_ids, institutions, num_authors, fields, num_fields, id,
+            references, num_refs);
+  log_op(snapshots, OP_ADD_PAPER, title, venue, year, author_names, author_ids,
+         institutions, num_authors, fields, num_fields, id, references,
+         num_refs);
+  pthread_mutex_unlock(&snapshots->writer_lock);
+}
+
+void snapshot_update_paper(Publ_Snapshots *snapshots, const char *title,
+                           const char *venue, const int year,
+                           const char **author_names,
+                           const int64_t *author_ids,
+                           const char **institutions, const int num_authors,
+                           const char **fields, const int num_fields,
+                           const int64_t id, const int64_t *references,
+                           const int num_refs) {
+  pthread_mutex_lock(&snapshots->writer_lock);
+  update_paper(writer_replica(snapshots), title, venue, year, author_names,
+               author_ids, institutions, num_authors, fields, num_fields, id,
+               references, num_refs);
+  log_op(snapshots, OP_UPDATE_PAPER, title, venue, year, author_names,
+         author_ids, institutions, num_authors, fields, num_fields, id,
+         references, num_refs);
+  pthread_mutex_unlock(&snapshots->writer_lock);
+}
+
+void snapshot_remove_paper(Publ_Snapshots *snapshots, const int64_t id) {
+  pthread_mutex_lock(&snapshots->writer_lock);
+  remove_paper(writer_replica(snapshots), id);
+  log_op(snapshots, OP_REMOVE_PAPER, NULL, NULL, 0, NULL, NULL, NULL, 0, NULL,
+         0, id, NULL, 0);
+  pthread_mutex_unlock(&snapshots->writer_lock);
+}
+
+/*
+ * Grace period - returns once every reader that was inside a snapshot has
+ * left it at least once (those entering from now on see the new replica)
+ */
+static void wait_for_readers(Publ_Snapshots *snapshots) {
+  int i;
+
+  for (i = 0; i < MAX_SNAPSHOT_READERS; i++) {
+    _Atomic uint64_t *epoch = &snapshots->readers[i].epoch;
+    uint64_t seen = atomic_load(epoch);
+
+    while ((seen & 1) && atomic_load(epoch) == seen) {
+      sched_yield();
+    }
+  }
+}
+
+void publish_snapshot(Publ_Snapshots *snapshots) {
+  int i;
+
+  pthread_mutex_lock(&snapshots->writer_lock);
+  if (snapshots->log.size == 0) {
+    pthread_mutex_unlock(&snapshots->writer_lock);
+    return;
+  }
+
+  // The writer's replica becomes the current one
+  int next = !atomic_load(&snapshots->current);
+  refresh_influence_sketches(snapshots->replicas[next]);
+  refresh_hub_counts(snapshots->replicas[next]);
+  atomic_store(&snapshots->current, next);
+  wait_for_readers(snapshots);
+
+  // Nobody is left in the old one => it catches up
+  for (i = 0; i < snapshots->log.size; i++) {
+    apply_paper_op(snapshots->replicas[!next], &snapshots->log.items[i]);
+    free_paper_op(&snapshots->log.items[i]);
+  }
+  snapshots->log.size = 0;
+  refresh_influence_sketches(snapshots->replicas[!next]);
+  refresh_hub_counts(snapshots->replicas[!next]);
+
+  pthread_mutex_unlock(&snapshots->writer_lock);
+}
+
+/* ------------------------- Reader side ------------------------- */
+Snapshot_Reader *open_snapshot_reader(Publ_Snapshots *snapshots) {
+  Snapshot_Reader *reader = NULL;
+  int i;
+
+  pthread_mutex_lock(&snapshots->readers_lock);
+  for (i = 0; i < MAX_SNAPSHOT_READERS && reader == NULL; i++) {
+    if (!snapshots->readers[i].in_use) {
+      reader = &snapshots->readers[i];
+      reader->in_use = 1;
+    }
+  }
+  pthread_mutex_unlock(&snapshots->readers_lock);
+
+  if (reader == NULL) {
+    return NULL;
+  }
+
+  reader->snapshots = snapshots;
+  for (i = 0; i < 2; i++) {
+    reader->caches[i] = calloc(1, sizeof(Query_Cache));
+    DIE(reader->caches[i] == NULL, "reader->caches[i] calloc");
+    init_query_cache(reader->caches[i], QUERY_CACHE_SIZE);
+  }
+
+  reader->scratch = calloc(1, sizeof(Traversal_Scratch));
+  DIE(reader->scratch == NULL, "reader->scratch calloc");
+  reader->bfs_pool = NULL;
+
+  return reader;
+}
+
+void close_snapshot_reader(Snapshot_Reader *reader) {
+  int i;
+
+  if (reader == NULL) {
+    return;
+  }
+
+  for (i = 0; i < 2; i++) {
+    free_query_cache(reader->caches[i]);
+    free(reader->caches[i]);
+  }
+  free_traversal_scratch(reader->scratch);
+  free_thread_pool(reader->bfs_pool);
+  free(reader->bfs_pool);
+
+  pthread_mutex_lock(&reader->snapshots->readers_lock);
+  reader->in_use = 0;
+  pthread_mutex_unlock(&reader->snapshots->readers_lock);
+}
+
+PublData *enter_snapshot(Snapshot_Reader *reader) {
+  // Announced first, so a writer flipping from now on waits for it
+  atomic_fetch_add(&reader->epoch, 1);
+  int replica = atomic_load(&reader->snapshots->current);
+
+  reader->view = *reader->snapshots->replicas[replica];
+  reader->view.query_cache = reader->caches[replica];
+  reader->view.scratch = reader->scratch;
+  reader->view.bfs_pool = reader->bfs_pool;
+
+  return &reader->view;
+}
+
+void leave_snapshot(Snapshot_Reader *reader) {
+  // Started by a query, if it needed one
+  reader->bfs_pool = reader->view.bfs_pool;
+  atomic_fetch_add(&reader->epoch, 1);
+}
+
+void destroy_publ_snapshots(Publ_Snapshots *snapshots) {
+  int i;
+
+  if (snapshots == NULL) {
+    return;
+  }
+
+  for (i = 0; i < snapshots->log.size; i++) {
+    free_paper_op(&snapshots->log.items[i]);
+  }
+  op_log_free(&snapshots->log);
+
+  destroy_publ_data(snapshots->replicas[0]);
+  destroy_publ_data(snapshots->replicas[1]);
+  pthread_mutex_destroy(&snapshots->writer_lock);
+  pthread_mutex_destroy(&snapshots->readers_lock);
+
+  free(snapshots);
+}
@@ -0,0 +1,104 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef SNAPSHOTS_H_
+#define SNAPSHOTS_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "./GenericHT.h"
+#include "./PaperOps.h"
+#include "./publications.h"
+
+#define MAX_SNAPSHOT_READERS 64
+
+/*
+ * Snapshots - concurrent ingestion and querying (left-right)
+ * Two replicas of the data: readers only ever enter the current one, the
+ * writer only ever changes the other one. Publishing flips them with one
+ * atomic store, waits for the readers still inside the old replica to leave
+ * (a grace period, tracked through per-reader epochs) and replays the same
+ * changes on it. Readers never wait and never take a lock; they see every
+ * change published before they entered, and nothing else.
+ * The price is the memory of a second replica and the writer doing every
+ * change twice.
+ */
+
+struct Publ_Snapshots;
+
+/*
+ * One per reading thread
+ * Queries write too (visited marks, cached results, the parallel BFS pool),
+ * so each reader has its own, and sees the replica through its own view:
+ * a copy of the replica's PublData pointing to them.
+ */
+typedef struct Snapshot_Reader {
+  _Alignas(CACHE_LINE) _Atomic uint64_t epoch;  // Odd while inside
+  struct Publ_Snapshots *snapshots;
+  int in_use;
+
+  PublData view;
+  struct Query_Cache *caches[2];  // One per replica - results point inside
+  struct Traversal_Scratch *scratch;
+  struct Thread_Pool *bfs_pool;
+} Snapshot_Reader;
+
+typedef struct Publ_Snapshots {
+  PublData *replicas[2];
+  _Atomic int current;  // The replica readers enter
+
+  pthread_mutex_t writer_lock;  // One writer at a time
+  Op_Log log;  // Applied to the writer's replica, not published yet
+
+  pthread_mutex_t readers_lock;  // Opening / closing readers only
+  Snapshot_Reader readers[MAX_SNAPSHOT_READERS];
+} Publ_Snapshots;
+
+Publ_Snapshots *init_publ_snapshots(void);
+
+/* No reader may be inside anymore */
+void destroy_publ_snapshots(Publ_Snapshots *snapshots);
+
+/*
+ * Writer side - same as the PublData functions, only visible to the readers
+ * after the next publish_snapshot
+ */
+void snapshot_add_paper(Publ_Snapshots *snapshots, const char *title,
+                        const char *venue, const int year,
+                        const char **author_names, const int64_t *author_ids,
+                        const char **institutions, const int num_authors,
+                        const char **fields, const int num_fields,
+                        const int64_t id, const int64_t *references,
+                        const int num_refs);
+
+void snapshot_update_paper(Publ_Snapshots *snapshots, const char *title,
+                           const char *venue, const int year,
+                           const char **author_names,
+                           const int64_t *author_ids,
+                           const char **institutions, const int num_authors,
+                           const char **fields, const int num_fields,
+                           const int64_t id, const int64_t *references,
+                           const int num_refs);
+
+void snapshot_remove_paper(Publ_Snapshots *snapshots, const int64_t id);
+
+/* Makes all the changes so far visible, at once */
+void publish_snapshot(Publ_Snapshots *snapshots);
+
+/* Reader side - NULL if MAX_SNAPSHOT_READERS are already open */
+Snapshot_Reader *open_snapshot_reader(Publ_Snapshots *snapshots);
+
+void close_snapshot_reader(Snapshot_Reader *reader);
+
+/*
+ * The current snapshot, to be queried with the usual functions until
+ * leave_snapshot (the results pointing inside it - titles - stay valid until
+ * then, too). Must not be changed through.
+ */
+PublData *enter_snapshot(Snapshot_Reader *reader);
+
+void leave_snapshot(Snapshot_Reader *reader);
+
+#endif /* SNAPSHOTS_H_ */
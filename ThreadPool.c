@@ -0,0 +1,132 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "./ThreadPool.h"
+#include "./publications.h"
+
+typedef struct worker_info {
+  Thread_Pool *pool;
+  int worker;
+} worker_info;
+
+static void *worker_loop(void *arg) {
+  worker_info *info = arg;
+  Thread_Pool *pool = info->pool;
+  int worker = info->worker;
+  uint64_t seen = 0;
+
+  free(info);
+
+  pthread_mutex_lock(&pool->lock);
+  while (1) {
+    // Waiting for a round it did not run yet
+    while (!pool->stop && pool->round == seen) {
+      pthread_cond_wait(&pool->start, &pool->lock);
+    }
+    if (pool->stop) {
+      break;
+    }
+    seen = pool->round;
+
+    pool_task task = pool->task;
+    void *task_arg = pool->arg;
+    pthread_mutex_unlock(&pool->lock);
+
+    task(task_arg, worker);
+
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->busy == 0) {
+      pthread_cond_signal(&pool->done);
+    }
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  return NULL;
+}
+
+void init_thread_pool(Thread_Pool *pool, int num_workers) {
+  int i;
+
+  if (pool == NULL) {
+    return;
+  }
+
+  if (num_workers <= 0) {
+    num_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if (num_workers > MAX_POOL_THREADS) {
+    num_workers = MAX_POOL_THREADS;
+  }
+  if (num_workers < 1) {
+    num_workers = 1;
+  }
+
+  pool->num_workers = num_workers;
+  pool->task = NULL;
+  pool->arg = NULL;
+  pool->round = 0;
+  pool->busy = 0;
+  pool->stop = 0;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  pool->threads = calloc(num_workers, sizeof(pthread_t));
+  DIE(pool->threads == NULL, "pool->threads calloc");
+
+  // Worker 0 is whoever calls run_on_pool
+  for (i = 1; i < num_workers; i++) {
+    worker_info *info = malloc(sizeof(worker_info));
+    DIE(info == NULL, "worker_info malloc");
+    info->pool = pool;
+    info->worker = i;
+
+    int err = pthread_create(&pool->threads[i], NULL, worker_loop, info);
+    DIE(err != 0, "pthread_create");
+  }
+}
+
+void run_on_pool(Thread_Pool *pool, pool_task task, void *arg) {
+  pthread_mutex_lock(&pool->lock);
+  pool->task = task;
+  pool->arg = arg;
+  pool->busy = pool->num_workers - 1;
+  pool->round++;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  task(arg, 0);
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->busy) {
+    pthread_cond_wait(&pool->done, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void free_thread_pool(Thread_Pool *pool) {
+  int i;
+
+  if (pool == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = 1;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (i = 1; i < pool->num_workers; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+  free(pool->threads);
+
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->start);
+  pthread_cond_destroy(&pool->done);
+}
@@ -0,0 +1,42 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MAX_POOL_THREADS 64
+
+typedef void (*pool_task)(void *arg, int worker);
+
+/*
+ * Thread Pool - a fixed team of workers, started once and reused
+ * run_on_pool hands the same task to every worker (the calling thread
+ * included, as worker 0) and returns when all of them are done - the tasks
+ * split the work among themselves (see parallel BFS in publications.c).
+ */
+typedef struct Thread_Pool {
+  pthread_t *threads;  // Workers 1 .. num_workers - 1
+  int num_workers;
+
+  pthread_mutex_t lock;
+  pthread_cond_t start;  // A new round was posted
+  pthread_cond_t done;  // A worker finished the current round
+
+  pool_task task;
+  void *arg;
+  uint64_t round;
+  int busy;  // Workers still running the current round
+  int stop;
+} Thread_Pool;
+
+/* num_workers <= 0 => one worker per online CPU (at most MAX_POOL_THREADS) */
+void init_thread_pool(Thread_Pool *pool, int num_workers);
+
+void run_on_pool(Thread_Pool *pool, pool_task task, void *arg);
+
+void free_thread_pool(Thread_Pool *pool);
+
+#endif /* THREAD_POOL_H_ */
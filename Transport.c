@@ -0,0 +1,128 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "./ByteBuffer.h"
+#include "./Transport.h"
+#include "./publications.h"
+
+typedef struct socket_transport {
+  Transport base;
+  int *fds;
+} Socket_Transport;
+
+/* A peer gone away is an error here, not a signal */
+static int send_all(int fd, const uint8_t *bytes, size_t len) {
+  while (len) {
+    ssize_t sent = send(fd, bytes, len, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    bytes += sent;
+    len -= sent;
+  }
+
+  return 0;
+}
+
+static int recv_all(int fd, uint8_t *bytes, size_t len) {
+  while (len) {
+    ssize_t received = recv(fd, bytes, len, 0);
+    if (received < 0 && errno == EINTR) {
+      continue;
+    }
+    if (received <= 0) {
+      if (received == 0) {
+        errno = 0;
+      }
+      return -1;
+    }
+    bytes += received;
+    len -= received;
+  }
+
+  return 0;
+}
+
+static int socket_send(Transport *transport, int peer,
+                       const Byte_Buffer *msg) {
+  Socket_Transport *sockets = (Socket_Transport *)transport;
+  uint8_t header[4];
+  int i;
+
+  if (msg->len > TRANSPORT_MAX_MESSAGE) {
+    errno = EMSGSIZE;
+    return -1;
+  }
+
+  for (i = 0; i < 4; i++) {
+    header[i] = (uint8_t)(msg->len >> (8 * i));
+  }
+
+  if (send_all(sockets->fds[peer], header, sizeof(header)) < 0) {
+    return -1;
+  }
+
+  return send_all(sockets->fds[peer], msg->bytes, msg->len);
+}
+
+static int socket_recv(Transport *transport, int peer, Byte_Buffer *msg) {
+  Socket_Transport *sockets = (Socket_Transport *)transport;
+  uint8_t header[4];
+
+  if (recv_all(sockets->fds[peer], header, sizeof(header)) < 0) {
+    return -1;
+  }
+
+  size_t len = (size_t)header[0] | (size_t)header[1] << 8 |
+               (size_t)header[2] << 16 | (size_t)header[3] << 24;
+  if (len > TRANSPORT_MAX_MESSAGE) {
+    errno = EMSGSIZE;
+    return -1;
+  }
+
+  msg->len = 0;
+  byte_buffer_reserve(msg, len);
+  if (recv_all(sockets->fds[peer], msg->bytes, len) < 0) {
+    return -1;
+  }
+  msg->len = len;
+
+  return 0;
+}
+
+static void socket_close(Transport *transport) {
+  Socket_Transport *sockets = (Socket_Transport *)transport;
+  int i;
+
+  for (i = 0; i < transport->num_peers; i++) {
+    close(sockets->fds[i]);
+  }
+  free(sockets->fds);
+  free(sockets);
+}
+
+Transport *init_socket_transport(const int *fds, int num_peers) {
+  Socket_Transport *sockets = calloc(1, sizeof(Socket_Transport));
+  DIE(sockets == NULL, "socket transport calloc");
+
+  sockets->fds = malloc(num_peers * sizeof(int));
+  DIE(sockets->fds == NULL, "sockets->fds malloc");
+  memcpy(sockets->fds, fds, num_peers * sizeof(int));
+
+  sockets->base.num_peers = num_peers;
+  sockets->base.send = socket_send;
+  sockets->base.recv = socket_recv;
+  sockets->base.close = socket_close;
+
+  return &sockets->base;
+}
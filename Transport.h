@@ -0,0 +1,43 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef TRANSPORT_H_
+#define TRANSPORT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "./ByteBuffer.h"
+
+#define TRANSPORT_MAX_MESSAGE (1U << 30)
+
+/*
+ * Transport - messages between the processes of a cluster (see Cluster.h),
+ * each one to / from a peer (0 .. num_peers - 1), in order.
+ * Any way of moving bytes can carry them - a transport is its functions.
+ */
+typedef struct Transport Transport;
+
+struct Transport {
+  int num_peers;
+
+  /* Returns 0, or -1 with errno set */
+  int (*send)(Transport *transport, int peer, const Byte_Buffer *msg);
+
+  /*
+   * Replaces msg with the next message from peer.
+   * Returns 0, or -1 with errno set (0 if the peer is gone)
+   */
+  int (*recv)(Transport *transport, int peer, Byte_Buffer *msg);
+
+  /* Closes the connections and frees the transport */
+  void (*close)(Transport *transport);
+};
+
+/*
+ * The local transport - a stream socket per peer (one end of a socketpair,
+ * or a connected AF_UNIX socket), each message sent as its length (4 bytes
+ * LE) and its bytes. Takes the sockets over.
+ */
+Transport *init_socket_transport(const int *fds, int num_peers);
+
+#endif /* TRANSPORT_H_ */
@@ -0,0 +1,559 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "./AuthorRegistry.h"
+#include "./ByteBuffer.h"
+#include "./EdgeList.h"
+#include "./GenericHT.h"
+#include "./PaperOps.h"
+#include "./WriteAheadLog.h"
+#include "./publications.h"
+
+/*
+ * Files: an 8-byte magic (the snapshot also has the sequence number of the
+ * last record it includes, 8 bytes LE), then records:
+ *   <payload length: 4 bytes LE> <CRC-32 of the payload: 4 bytes LE>
+ *   <payload>
+ * Payload: varint sequence number (0 in the snapshot), then the op in its
+ * binary form (see PaperOps.h).
+ */
+#define WAL_MAGIC "PUBLWAL1"
+#define SNAPSHOT_MAGIC "PUBLSNP1"
+#define MAGIC_SIZE 8
+#define RECORD_HEADER 8
+
+/* ------------------------- Encoding ------------------------- */
+static void put_u32(uint8_t *pos, uint32_t value) {
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    pos[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+static uint32_t crc_table[256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void init_crc_table(void) {
+  uint32_t i, bit;
+
+  for (i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xedb88320u & -(crc & 1u));
+    }
+    crc_table[i] = crc;
+  }
+}
+
+static uint32_t crc32(const uint8_t *bytes, size_t len) {
+  uint32_t crc = 0xffffffffu;
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    crc = (crc >> 8) ^ crc_table[(crc ^ bytes[i]) & 0xffu];
+  }
+
+  return ~crc;
+}
+
+static void encode_record(Byte_Buffer *buf, uint64_t lsn,
+                          const Paper_Op *op) {
+  byte_buffer_reserve(buf, RECORD_HEADER);
+  size_t start = buf->len;
+  buf->len += RECORD_HEADER;
+
+  byte_buffer_put_varint(buf, lsn);
+  encode_paper_op(buf, op);
+
+  size_t payload = buf->len - start - RECORD_HEADER;
+  put_u32(buf->bytes + start, (uint32_t)payload);
+  put_u32(buf->bytes + start + 4,
+          crc32(buf->bytes + start + RECORD_HEADER, payload));
+}
+
+/* ------------------------- Decoding ------------------------- */
+static uint32_t get_u32(const uint8_t *pos) {
+  return (uint32_t)pos[0] | (uint32_t)pos[1] << 8 | (uint32_t)pos[2] << 16 |
+         (uint32_t)pos[3] << 24;
+}
+
+/* 0, or -1 if the payload is not a valid record (op is then left empty) */
+static int decode_record(Byte_Reader *reader, uint64_t *lsn, Paper_Op *op) {
+  *lsn = byte_reader_varint(reader);
+  if (decode_paper_op(reader, op) < 0) {
+    return -1;
+  }
+
+  if (reader->pos != reader->end) {
+    free_paper_op(op);
+    return -1;
+  }
+
+  return 0;
+}
+
+/*
+ * Applies the records of bytes[0..len) that come after skip_lsn, up to the
+ * first one that is cut short or does not match its checksum.
+ * Returns how many bytes were valid; *last_lsn is raised to the sequence
+ * number of the last valid record.
+ */
+static size_t replay_records(PublData *data, const uint8_t *bytes, size_t len,
+                             uint64_t skip_lsn, uint64_t *last_lsn) {
+  size_t offset = 0;
+  uint64_t lsn;
+  Paper_Op op;
+
+  while (len - offset >= RECORD_HEADER) {
+    const uint8_t *record = bytes + offset;
+    uint32_t payload = get_u32(record);
+    if (payload > len - offset - RECORD_HEADER ||
+        crc32(record + RECORD_HEADER, payload) != get_u32(record + 4)) {
+      break;
+    }
+
+    Byte_Reader reader;
+    byte_reader_init(&reader, record + RECORD_HEADER, payload);
+    if (decode_record(&reader, &lsn, &op) < 0) {
+      break;
+    }
+    if (lsn == 0 || lsn > skip_lsn) {
+      apply_paper_op(data, &op);
+    }
+    free_paper_op(&op);
+
+    if (lsn > *last_lsn) {
+      *last_lsn = lsn;
+    }
+    offset += RECORD_HEADER + payload;
+  }
+
+  return offset;
+}
+
+/* ------------------------- Files ------------------------- */
+static char *wal_path(const char *dir, const char *name) {
+  size_t len = strlen(dir) + strlen(name) + 6;
+
+  char *path = malloc(len);
+  DIE(path == NULL, "wal path malloc");
+  snprintf(path, len, "%s/%s", dir, name);
+
+  return path;
+}
+
+static int write_all(int fd, const uint8_t *bytes, size_t len) {
+  while (len) {
+    ssize_t written = write(fd, bytes, len);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    bytes += written;
+    len -= written;
+  }
+
+  return 0;
+}
+
+/* Makes the renames in dir durable */
+static int sync_dir(const char *dir) {
+  int fd = open(dir, O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    return -1;
+  }
+
+  int ret = fsync(fd);
+  close(fd);
+
+  return ret;
+}
+
+/* Writes buf to path, through a temporary file - all of it or nothing */
+static int replace_file(const char *dir, const char *name, Byte_Buffer *buf,
+                        int (*fill)(int fd, Byte_Buffer *buf, void *arg),
+                        void *arg) {
+  char *path = wal_path(dir, name);
+  char *tmp_path = wal_path(dir, "tmp");
+  int ret = -1;
+
+  int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (fd >= 0) {
+    if ((fill == NULL || fill(fd, buf, arg) == 0) &&
+        write_all(fd, buf->bytes, buf->len) == 0 && fsync(fd) == 0 &&
+        rename(tmp_path, path) == 0) {
+      ret = sync_dir(dir);
+    }
+    int err = errno;
+    close(fd);
+    if (ret < 0) {
+      unlink(tmp_path);
+    }
+    errno = err;
+  }
+
+  free(tmp_path);
+  free(path);
+
+  return ret;
+}
+
+/*
+ * The whole file, mapped read-only - *bytes is NULL for a missing or empty
+ * one. Returns 0, or -1 with errno set.
+ */
+static int map_file(const char *path, uint8_t **bytes, size_t *len) {
+  struct stat st;
+
+  *bytes = NULL;
+  *len = 0;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return errno == ENOENT ? 0 : -1;
+  }
+
+  if (fstat(fd, &st) < 0) {
+    int err = errno;
+    close(fd);
+    errno = err;
+    return -1;
+  }
+
+  if (st.st_size) {
+    *bytes = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (*bytes == MAP_FAILED) {
+      int err = errno;
+      *bytes = NULL;
+      close(fd);
+      errno = err;
+      return -1;
+    }
+    *len = st.st_size;
+  }
+  close(fd);
+
+  return 0;
+}
+
+/* ------------------------- Recovery ------------------------- */
+static int recover_snapshot(Write_Ahead_Log *wal, PublData *data) {
+  uint8_t *bytes;
+  size_t len;
+
+  char *path = wal_path(wal->dir, WAL_SNAPSHOT_FILE);
+  int ret = map_file(path, &bytes, &len);
+  free(path);
+  if (ret < 0 || bytes == NULL) {
+    return ret;
+  }
+
+  // Written through a rename - it is either whole or missing
+  size_t header = MAGIC_SIZE + 8;
+  if (len < header || memcmp(bytes, SNAPSHOT_MAGIC, MAGIC_SIZE) != 0) {
+    munmap(bytes, len);
+    errno = EBADMSG;
+    return -1;
+  }
+  wal->snapshot_lsn = (uint64_t)get_u32(bytes + MAGIC_SIZE) |
+                      (uint64_t)get_u32(bytes + MAGIC_SIZE + 4) << 32;
+  wal->last_lsn = wal->snapshot_lsn;
+
+  uint64_t last_lsn = 0;
+  size_t valid = replay_records(data, bytes + header, len - header, 0,
+                                &last_lsn);
+  munmap(bytes, len);
+  if (valid != len - header) {
+    errno = EBADMSG;
+    return -1;
+  }
+
+  return 0;
+}
+
+/* A new, empty log */
+static int start_log(Write_Ahead_Log *wal) {
+  Byte_Buffer header = {0};
+
+  byte_buffer_put(&header, WAL_MAGIC, MAGIC_SIZE);
+  int ret = replace_file(wal->dir, WAL_FILE, &header, NULL, NULL);
+  free(header.bytes);
+  wal->log_bytes = MAGIC_SIZE;
+
+  return ret;
+}
+
+/*
+ * Replays the log after the snapshot and cuts off a torn tail, so the new
+ * records go right after the last valid one
+ */
+static int recover_log(Write_Ahead_Log *wal, PublData *data) {
+  uint8_t *bytes;
+  size_t len;
+
+  char *path = wal_path(wal->dir, WAL_FILE);
+  int ret = map_file(path, &bytes, &len);
+  if (ret == 0 &&
+      (len < MAGIC_SIZE || memcmp(bytes, WAL_MAGIC, MAGIC_SIZE) != 0)) {
+    // Missing, or never got its header - nothing was logged to it
+    if (bytes) {
+      munmap(bytes, len);
+    }
+    ret = start_log(wal);
+  } else if (ret == 0) {
+    size_t valid = MAGIC_SIZE +
+                   replay_records(data, bytes + MAGIC_SIZE, len - MAGIC_SIZE,
+                                  wal->snapshot_lsn, &wal->last_lsn);
+    munmap(bytes, len);
+    wal->log_bytes = valid;
+    if (valid != len) {
+      ret = truncate(path, valid);
+    }
+  }
+
+  if (ret == 0) {
+    wal->fd = open(path, O_WRONLY | O_APPEND);
+    ret = wal->fd < 0 ? -1 : 0;
+  }
+  free(path);
+
+  return ret;
+}
+
+/* ------------------------- Group commit ------------------------- */
+static void *flush_log(void *arg) {
+  Write_Ahead_Log *wal = arg;
+
+  pthread_mutex_lock(&wal->lock);
+  while (1) {
+    while (wal->pending.len == 0 && !wal->stop) {
+      pthread_cond_wait(&wal->wake, &wal->lock);
+    }
+    if (wal->pending.len == 0) {
+      break;
+    }
+
+    // Everything appended while the last group was on its way - one group
+    Byte_Buffer group = wal->pending;
+    wal->pending = wal->writing;
+    wal->writing = group;
+    uint64_t lsn = wal->last_lsn;
+    int fd = wal->fd;
+    pthread_mutex_unlock(&wal->lock);
+
+    DIE(write_all(fd, group.bytes, group.len) < 0, "wal write");
+    DIE(fdatasync(fd) < 0, "wal fdatasync");
+
+    pthread_mutex_lock(&wal->lock);
+    wal->writing.len = 0;
+    wal->durable_lsn = lsn;
+    pthread_cond_broadcast(&wal->synced);
+  }
+  pthread_mutex_unlock(&wal->lock);
+
+  return NULL;
+}
+
+Write_Ahead_Log *open_write_ahead_log(const char *dir, PublData *data) {
+  if (mkdir(dir, 0700) < 0 && errno != EEXIST) {
+    return NULL;
+  }
+
+  pthread_once(&crc_once, init_crc_table);
+
+  Write_Ahead_Log *wal = calloc(1, sizeof(Write_Ahead_Log));
+  DIE(wal == NULL, "wal calloc");
+  wal->dir = copy_string(dir);
+  wal->fd = -1;
+
+  if (recover_snapshot(wal, data) < 0 || recover_log(wal, data) < 0) {
+    int err = errno;
+    free(wal->dir);
+    free(wal);
+    errno = err;
+    return NULL;
+  }
+  wal->durable_lsn = wal->last_lsn;
+
+  pthread_mutex_init(&wal->lock, NULL);
+  pthread_cond_init(&wal->wake, NULL);
+  pthread_cond_init(&wal->synced, NULL);
+  DIE(pthread_create(&wal->flusher, NULL, flush_log, wal) != 0,
+      "wal pthread_create");
+
+  return wal;
+}
+
+void wal_apply(Write_Ahead_Log *wal, PublData *data, Paper_Op *op) {
+  pthread_mutex_lock(&wal->lock);
+
+  // The disk is behind by too much - wait for it (bounded memory)
+  while (wal->pending.len > WAL_MAX_PENDING) {
+    pthread_cond_wait(&wal->synced, &wal->lock);
+  }
+
+  size_t len = wal->pending.len;
+  encode_record(&wal->pending, ++wal->last_lsn, op);
+  wal->log_bytes += wal->pending.len - len;
+  int compact = wal->log_bytes > WAL_COMPACT_BYTES;
+
+  pthread_cond_signal(&wal->wake);
+  pthread_mutex_unlock(&wal->lock);
+
+  apply_paper_op(data, op);
+
+  // Best effort - on failure the log just keeps growing
+  if (compact) {
+    wal_compact(wal, data);
+  }
+}
+
+void wal_sync(Write_Ahead_Log *wal) {
+  pthread_mutex_lock(&wal->lock);
+  while (wal->durable_lsn < wal->last_lsn) {
+    pthread_cond_wait(&wal->synced, &wal->lock);
+  }
+  pthread_mutex_unlock(&wal->lock);
+}
+
+/* ------------------------- Compaction ------------------------- */
+DEFINE_VECTOR(Name_List, name_list, const char *)
+
+/* The live papers, in dense ID order, as add_paper records */
+static int fill_snapshot(int fd, Byte_Buffer *buf, void *arg) {
+  PublData *data = arg;
+  String_Pool *pool = &data->authors->strings;
+  Name_List names = {0}, institutions = {0};
+  Id_List author_ids = {0}, references = {0};
+  Edge_Iter it;
+  uint64_t ref;
+  int i, j, ret = 0;
+
+  for (i = 0; i < data->num_papers && ret == 0; i++) {
+    Paper *publication = data->papers[i];
+    if (publication == NULL) {
+      continue;
+    }
+    Paper_Info *info = publication->info;
+
+    // The names as the paper listed them, not the registry's canonical ones
+    names.size = institutions.size = author_ids.size = 0;
+    for (j = 0; j < info->num_authors; j++) {
+      Author_Entry *entry = &data->authors->authors[info->authors[j].author];
+      name_list_push(&names, get_string(pool, info->authors[j].name));
+      name_list_push(&institutions, get_string(pool, info->authors[j].org));
+      id_list_push(&author_ids, entry->id);
+    }
+
+    references.size = 0;
+    edge_iter_init(&it, &info->references);
+    while (edge_iter_next(&it, &ref)) {
+      id_list_push(&references, (int64_t)ref);
+    }
+
+    Paper_Op op = {.type = OP_ADD_PAPER,
+                   .id = publication->id,
+                   .title = info->title,
+                   .venue = info->venue,
+                   .year = publication->year,
+                   .author_names = (char **)names.items,
+                   .author_ids = author_ids.items,
+                   .institutions = (char **)institutions.items,
+                   .num_authors = info->num_authors,
+                   .fields = info->fields,
+                   .num_fields = info->num_fields,
+                   .references = references.items,
+                   .num_refs = references.size};
+    encode_record(buf, 0, &op);
+
+    if (buf->len >= WAL_SNAPSHOT_BUFFER) {
+      ret = write_all(fd, buf->bytes, buf->len);
+      buf->len = 0;
+    }
+  }
+
+  name_list_free(&names);
+  name_list_free(&institutions);
+  id_list_free(&author_ids);
+  id_list_free(&references);
+
+  return ret;
+}
+
+int wal_compact(Write_Ahead_Log *wal, PublData *data) {
+  Byte_Buffer buf = {0};
+  uint8_t lsn[8];
+
+  // The old log stays valid until the snapshot replaces it
+  wal_sync(wal);
+
+  put_u32(lsn, (uint32_t)wal->last_lsn);
+  put_u32(lsn + 4, (uint32_t)(wal->last_lsn >> 32));
+  byte_buffer_put(&buf, SNAPSHOT_MAGIC, MAGIC_SIZE);
+  byte_buffer_put(&buf, lsn, sizeof(lsn));
+  int ret = replace_file(wal->dir, WAL_SNAPSHOT_FILE, &buf, fill_snapshot,
+                         data);
+  free(buf.bytes);
+  if (ret < 0) {
+    return -1;
+  }
+
+  /*
+   * A crash from here on leaves the snapshot with the old log, whose
+   * records it already includes - they are skipped by their numbers
+   */
+  char *path = wal_path(wal->dir, WAL_FILE);
+  int fd = -1;
+  if (start_log(wal) == 0) {
+    fd = open(path, O_WRONLY | O_APPEND);
+  }
+  free(path);
+  if (fd < 0) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&wal->lock);
+  int old_fd = wal->fd;
+  wal->fd = fd;
+  wal->snapshot_lsn = wal->last_lsn;
+  pthread_mutex_unlock(&wal->lock);
+  close(old_fd);
+
+  return 0;
+}
+
+void close_write_ahead_log(Write_Ahead_Log *wal) {
+  if (wal == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&wal->lock);
+  wal->stop = 1;
+  pthread_cond_signal(&wal->wake);
+  pthread_mutex_unlock(&wal->lock);
+
+  // The flusher writes what is left before it stops
+  pthread_join(wal->flusher, NULL);
+
+  close(wal->fd);
+  pthread_mutex_destroy(&wal->lock);
+  pthread_cond_destroy(&wal->wake);
+  pthread_cond_destroy(&wal->synced);
+  free(wal->pending.bytes);
+  free(wal->writing.bytes);
+  free(wal->dir);
+  free(wal);
+}
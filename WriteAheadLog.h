@@ -0,0 +1,79 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#ifndef WRITE_AHEAD_LOG_H_
+#define WRITE_AHEAD_LOG_H_
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "./ByteBuffer.h"
+#include "./PaperOps.h"
+#include "./publications.h"
+
+#define WAL_FILE "wal.log"
+#define WAL_SNAPSHOT_FILE "snapshot"
+#define WAL_MAX_PENDING (1 << 24)  // Appends wait for the disk past it
+#ifndef WAL_COMPACT_BYTES
+#define WAL_COMPACT_BYTES (1ULL << 28)  // Log size that triggers a snapshot
+#endif
+#define WAL_SNAPSHOT_BUFFER (1 << 20)
+
+/*
+ * Write-Ahead Log - the changes survive the process
+ * Every change is appended to <dir>/wal.log as a binary record (varints,
+ * checksummed) before it is applied. Appending only encodes the record in
+ * memory: a background thread writes what has piled up and syncs it to disk,
+ * so one fsync covers all the changes appended while the previous one ran
+ * (group commit) and ingestion does not wait for the disk.
+ * When the log grows past WAL_COMPACT_BYTES, the live papers are written to
+ * <dir>/snapshot (as add_paper records) and the log starts over. Recovery
+ * replays the snapshot, then the log records that came after it; a record
+ * torn by a crash ends the log.
+ * One writer: appends, applying and compaction come from the same thread.
+ */
+typedef struct Write_Ahead_Log {
+  char *dir;
+  int fd;
+
+  pthread_mutex_t lock;
+  pthread_cond_t wake;  // The flusher - records to write, or stop
+  pthread_cond_t synced;  // The writer - a group reached the disk
+  pthread_t flusher;
+  int stop;
+
+  Byte_Buffer pending;  // Appended, not written yet
+  Byte_Buffer writing;  // The group being written (the flusher's)
+  uint64_t last_lsn;  // Sequence number of the last appended record
+  uint64_t durable_lsn;  // ... of the last one on disk
+  uint64_t snapshot_lsn;  // ... of the last one in the snapshot
+  size_t log_bytes;  // Size of the log, pending records included
+} Write_Ahead_Log;
+
+/*
+ * Recovers the changes logged in dir (created if missing) into data, which
+ * must be empty, and opens the log for appending.
+ * Settings that are not changes (enable_cold_store etc.) are not logged -
+ * they have to be made on data before.
+ * Returns NULL with errno set if the files cannot be read / created
+ * (EBADMSG for a damaged snapshot).
+ */
+Write_Ahead_Log *open_write_ahead_log(const char *dir, PublData *data);
+
+/* Logs the change, then applies it to data (compacting, if it is time) */
+void wal_apply(Write_Ahead_Log *wal, PublData *data, Paper_Op *op);
+
+/* Waits until every change applied so far is on disk */
+void wal_sync(Write_Ahead_Log *wal);
+
+/*
+ * Writes data (which must have every logged change applied) as the new
+ * snapshot and starts an empty log.
+ * Returns 0, or -1 with errno set (the old snapshot and log are kept then)
+ */
+int wal_compact(Write_Ahead_Log *wal, PublData *data);
+
+/* Syncs, stops the flusher and frees the log (the files stay) */
+void close_write_ahead_log(Write_Ahead_Log *wal);
+
+#endif /* WRITE_AHEAD_LOG_H_ */
@@ -4,9 +4,30 @@
 ARCHIVE=SD_T3
 PUBL=publications
 HT=Hashtables
+GENERIC=GenericHT
 LIST=LinkedList
 Q=Queue
 UTILS=utils
+CACHE=QueryCache
+COLUMNS=Columns
+EDGES=EdgeList
+POOL=ThreadPool
+SKETCH=InfluenceSketch
+REGISTRY=AuthorRegistry
+COLD=ColdStore
+FILTER=PaperFilter
+SNAPSHOTS=Snapshots
+EXECUTOR=QueryExecutor
+OPS=PaperOps
+SERVER=QueryServer
+WAL=WriteAheadLog
+SHARDS=Shards
+BYTES=ByteBuffer
+TRANSPORT=Transport
+CLUSTER=Cluster
+HUBS=HubCounts
+YEARS=CitationYears
+RANK=InfluenceRank
 MAKE=Makefile
 EXPORT=../AN_Checking # Replace with your testing zone
 
@@ -16,7 +37,7 @@ make -f Makefile_tema3 clean
 
 # Zipping
 rm $ARCHIVE.zip
-zip $ARCHIVE.zip $PUBL.* $HT.* $LIST.* $Q.* $UTILS.* $MAKE README
+zip $ARCHIVE.zip $PUBL.* $HT.* $GENERIC.h $LIST.* $Q.* $UTILS.* $CACHE.* $COLUMNS.* $EDGES.* $POOL.* $SKETCH.* $REGISTRY.* $COLD.* $FILTER.* $SNAPSHOTS.* $EXECUTOR.* $OPS.* $SERVER.* $WAL.* $SHARDS.* $BYTES.* $TRANSPORT.* $CLUSTER.* $HUBS.* $YEARS.* $RANK.* server_main.c $MAKE README
 
 # Exporting
 unzip $ARCHIVE.zip -d $EXPORT
@@ -1,88 +1,212 @@
 // Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
 
+#include <inttypes.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
+#include "./CitationYears.h"
+#include "./ColdStore.h"
+#include "./Columns.h"
+#include "./EdgeList.h"
 #include "./Hashtables.h"
+#include "./HubCounts.h"
+#include "./InfluenceRank.h"
+#include "./InfluenceSketch.h"
 #include "./LinkedList.h"
+#include "./PaperFilter.h"
 #include "./Queue.h"
+#include "./QueryCache.h"
+#include "./ThreadPool.h"
 #include "./publications.h"
 #include "./utils.h"
 
-void init_info(Paper *publication, const char *title, const char *venue,
-               const int year, const char **author_names,
-               const int64_t *author_ids, const char **institutions,
-               const int num_authors, const char **fields, const int num_fields,
-               int64_t id, const int64_t *references, const int num_refs) {
+void init_info(Paper *publication, const int num_authors,
+               const int num_fields, const int64_t *references,
+               const int num_refs) {
   int i;
 
-  // Title
-  publication->title = calloc(strlen(title) + 1, sizeof(char));
-  DIE(publication->title == NULL, "publication->title");
+  // The cold part - only needed for output & removal
+  Paper_Info *info = calloc(1, sizeof(Paper_Info));
+  DIE(info == NULL, "info calloc");
+  publication->info = info;
+
+  // Title, venue & field strings are copied in by add_paper (store_string)
+
+  // Authors (filled in from the registry by add_paper)
+  info->authors = calloc(num_authors, sizeof(Paper_Author));
+  DIE(info->authors == NULL, "info->authors");
+
+  // Fields
+  info->fields = calloc(num_fields, sizeof(char *));
+  DIE(info->fields == NULL, "info->fields");
+
+  // References
+  uint64_t *ids = malloc((num_refs ? num_refs : 1) * sizeof(uint64_t));
+  DIE(ids == NULL, "ids malloc");
+  for (i = 0; i < num_refs; i++) {
+    ids[i] = (uint64_t)references[i];
+  }
+  edge_list_build(&info->references, ids, num_refs);
+  free(ids);
+}
 
-  // Venue
-  publication->venue = calloc(strlen(venue) + 1, sizeof(char));
-  DIE(publication->venue == NULL, "publication->venue");
+/* Copy of a cold string - on the heap, or in the cold store if enabled */
+static char *store_string(PublData *data, const char *string) {
+  if (data->cold_store) {
+    return cold_store_string(data->cold_store, string);
+  }
 
-  // Authors
-  publication->authors = calloc(num_authors, sizeof(Author *));
-  DIE(publication->authors == NULL, "publication->authors");
+  char *copy = calloc(strlen(string) + 1, sizeof(char));
+  DIE(copy == NULL, "store_string calloc");
+  memcpy(copy, string, (strlen(string) + 1) * sizeof(char));
 
-  for (i = 0; i < num_authors; i++) {
-    publication->authors[i] = calloc(1, sizeof(Author));
-    DIE(publication->authors[i] == NULL, "publications->authors[i]");
+  return copy;
+}
 
-    Author *author = publication->authors[i];
+/* Resized along with the papers - dropping the removed IDs, too */
+static void rebuild_paper_filter(PublData *data) {
+  Paper_Filter *filter = data->paper_filter;
+  int i;
 
-    // Name
-    author->name = calloc(strlen(author_names[i]) + 1, sizeof(char));
-    DIE(author->name == NULL, "author->name");
+  free(filter->blocks);
+  init_paper_filter(filter, data->cap_papers);
+  for (i = 0; i < data->num_papers; i++) {
+    if (data->papers[i]) {
+      paper_filter_add(filter, data->papers[i]->id);
+    }
+  }
+}
 
-    // Institution
-    author->org = calloc(strlen(institutions[i]) + 1, sizeof(char));
-    DIE(author->org == NULL, "author->org");
+/*
+ * Hot record for the next dense ID - records are carved out of slabs, so
+ * papers with neighbouring dense IDs are neighbours in memory too, and a
+ * record's address never changes
+ */
+static Paper *new_paper_record(PublData *data) {
+  int slab = data->num_papers / PAPER_SLAB_SIZE;
+
+  if (slab == data->num_slabs) {
+    data->paper_slabs =
+        realloc(data->paper_slabs, (slab + 1) * sizeof(Paper *));
+    DIE(data->paper_slabs == NULL, "data->paper_slabs realloc");
+
+    data->paper_slabs[slab] =
+        aligned_alloc(CACHE_LINE, PAPER_SLAB_SIZE * sizeof(Paper));
+    DIE(data->paper_slabs[slab] == NULL, "paper slab aligned_alloc");
+    data->num_slabs++;
   }
 
-  // Fields
-  publication->fields = calloc(num_fields, sizeof(char *));
-  DIE(publication->fields == NULL, "publication->fields");
+  Paper *publication =
+      &data->paper_slabs[slab][data->num_papers % PAPER_SLAB_SIZE];
+  memset(publication, 0, sizeof(Paper));
+
+  return publication;
+}
+
+/*
+ * Gives the paper the next dense ID, its stats & column slots, carrying over
+ * the
+ * citations it got before being added and resolving the edges that were
+ * waiting for it
+ */
+static void register_paper(PublData *data, Paper *publication) {
+  int i;
 
-  for (i = 0; i < num_fields; i++) {
-    publication->fields[i] = calloc(strlen(fields[i]) + 1, sizeof(char));
-    DIE(publication->fields[i] == NULL, "publication->fields[i]");
+  if (data->num_papers == data->cap_papers) {
+    data->cap_papers = data->cap_papers ? 2 * data->cap_papers : HMAX_BIG;
+
+    data->papers = realloc(data->papers, data->cap_papers * sizeof(Paper *));
+    DIE(data->papers == NULL, "data->papers realloc");
+
+    data->stats =
+        realloc(data->stats, data->cap_papers * sizeof(Paper_Stats));
+    DIE(data->stats == NULL, "data->stats realloc");
+
+    data->region_parent =
+        realloc(data->region_parent, data->cap_papers * sizeof(int));
+    DIE(data->region_parent == NULL, "data->region_parent realloc");
+
+    data->region_generation = realloc(data->region_generation,
+                                      data->cap_papers * sizeof(uint64_t));
+    DIE(data->region_generation == NULL, "data->region_generation realloc");
+
+    grow_columns(data->columns, data->cap_papers);
+    grow_influence_sketches(data->sketches, data->cap_papers);
+    grow_hub_counts(data->hub_counts, data->cap_papers);
+    if (data->cap_papers > data->paper_filter->cap) {
+      rebuild_paper_filter(data);
+    }
   }
 
-  // References
-  publication->references = calloc(num_refs, sizeof(int64_t));
-  DIE(publication->references == NULL, "publication->references");
+  publication->idx = data->num_papers++;
+  data->papers[publication->idx] = publication;
+  *papers_ht_put(data->papers_ht, publication->id) = publication;
+  paper_filter_add(data->paper_filter, publication->id);
+
+  // A region of its own, for now
+  data->region_parent[publication->idx] = publication->idx;
+  data->region_generation[publication->idx] = next_generation(data);
+  data->papers_generation = next_generation(data);
+
+  Paper_Stats *stats = &data->stats[publication->idx];
+  stats->in_degree = 0;
+  stats->out_degree = 0;
+
+  Paper_Columns *columns = data->columns;
+  columns->year[publication->idx] = publication->year;
+  columns->venue[publication->idx] = NO_VENUE;
+  columns->citations[publication->idx] =
+      take_citations(data->citations_ht, publication->id);
+  columns->num_authors[publication->idx] = publication->info->num_authors;
+
+  if (data->sketches) {
+    clear_paper_sketches(data->sketches, publication->idx);
+  }
+
+  // Papers that were already waiting for this one
+  Idx_List imitators = take_pending(data->pending_ht, publication->id);
+  compact_idx_list(&imitators, data->papers);
+
+  uint64_t *imitator_idx =
+      malloc((imitators.size ? imitators.size : 1) * sizeof(uint64_t));
+  DIE(imitator_idx == NULL, "imitator_idx malloc");
+
+  for (i = 0; i < imitators.size; i++) {
+    Paper *imitator = data->papers[imitators.items[i]];
+    // Its biggest dense ID yet => appended in order
+    edge_list_push(&imitator->info->refs, publication->idx);
+    data->stats[imitator->idx].out_degree++;
+    merge_regions(data, imitator->idx, publication->idx);
+    sketch_add_edge(data, publication->idx, imitator->idx);
+    imitator_idx[i] = imitator->idx;
+  }
+  stats->in_degree = imitators.size;
+  if (data->hub_counts) {
+    check_hub_degree(data, publication->idx);
+  }
 
-  // Auxiliary fields
-  publication->ok = UNVISITED;
-  publication->distance = -1;
-  publication->citations = 0;
+  // The waiting list becomes the paper's own list of imitators
+  edge_list_build(&publication->influenced, imitator_idx, imitators.size);
+  free(imitator_idx);
+  idx_list_free(&imitators);
 }
 
 PublData *init_publ_data(void) {
   PublData *data = calloc(1, sizeof(PublData));
   DIE(data == NULL, "malloc - data");
-  int i;
 
   // Initialising data hashtable
-  data->buckets = calloc(HMAX_BIG, sizeof(struct LinkedList *));
-  DIE(data->buckets == NULL, "data->buckets malloc");
+  data->papers_ht = calloc(1, sizeof(Papers_HT));
+  DIE(data->papers_ht == NULL, "data->papers_ht calloc");
+  papers_ht_init(data->papers_ht, HMAX_BIG);
 
-  data->hmax = HMAX_BIG;
-  data->hash_function = hash_function_int;
-  data->compare_function = compare_function_ints;
-
-  for (i = 0; i < data->hmax; i++) {
-    data->buckets[i] = calloc(1, sizeof(struct LinkedList));
-    DIE(data->buckets[i] == NULL, "data->buckets[i] malloc");
-
-    init_list(data->buckets[i]);
-  }
+  data->paper_filter = calloc(1, sizeof(Paper_Filter));
+  DIE(data->paper_filter == NULL, "data->paper_filter calloc");
+  init_paper_filter(data->paper_filter, HMAX_BIG);
 
   // Initializing auxiliary hashtables
   data->citations_ht = calloc(1, sizeof(Citations_HT));
@@ -97,42 +221,56 @@ PublData *init_publ_data(void) {
   DIE(data->field_ht == NULL, "data->field_ht calloc");
   init_field_ht(data->field_ht);
 
-  data->authors_ht = calloc(1, sizeof(Authors_HT));
-  DIE(data->authors_ht == NULL, "data->authors_ht calloc");
-  init_authors_ht(data->authors_ht);
+  data->authors = calloc(1, sizeof(Author_Registry));
+  DIE(data->authors == NULL, "data->authors calloc");
+  init_author_registry(data->authors);
+
+  data->pending_ht = calloc(1, sizeof(Pending_HT));
+  DIE(data->pending_ht == NULL, "data->pending_ht calloc");
+  init_pending_ht(data->pending_ht);
+
+  data->columns = calloc(1, sizeof(Paper_Columns));
+  DIE(data->columns == NULL, "data->columns calloc");
+  init_columns(data->columns);
+
+  data->query_cache = calloc(1, sizeof(Query_Cache));
+  DIE(data->query_cache == NULL, "data->query_cache calloc");
+  init_query_cache(data->query_cache, QUERY_CACHE_SIZE);
 
-  data->influence_ht = calloc(1, sizeof(Influence_HT));
-  DIE(data->influence_ht == NULL, "data->influence_ht calloc");
-  init_influence_ht(data->influence_ht);
+  data->scratch = calloc(1, sizeof(Traversal_Scratch));
+  DIE(data->scratch == NULL, "data->scratch calloc");
+
+  data->citation_years = calloc(1, sizeof(Citation_Years));
+  DIE(data->citation_years == NULL, "data->citation_years calloc");
 
   return data;
 }
 
 void destroy_paper(Paper *publication) {
+  Paper_Info *info = publication->info;
   int i;
 
-  // Title
-  free(publication->title);
-  free(publication->venue);
-
-  // Authors
-  for (i = 0; i < publication->num_authors; i++) {
-    Author *author = publication->authors[i];
-    free(author->name);
-    free(author->org);
-    free(author);
+  // Strings (the cold store keeps its own, for good)
+  if (!info->spilled) {
+    free(info->title);
+    free(info->venue);
+    for (i = 0; i < info->num_fields; i++) {
+      free(info->fields[i]);
+    }
   }
-  free(publication->authors);
+  free(info->fields);
 
-  // Fields
-  for (i = 0; i < publication->num_fields; i++) {
-    free(publication->fields[i]);
-  }
-  free(publication->fields);
+  // Authors (the registry owns the names)
+  free(info->authors);
 
   // References
-  free(publication->references);
-  free(publication);
+  edge_list_free(&info->references);
+  edge_list_free(&info->refs);
+  edge_list_free(&publication->influenced);
+  free(info);
+
+  // The hot record itself stays in its slab (see new_paper_record)
+  publication->info = NULL;
 }
 
 void destroy_publ_data(PublData *data) {
@@ -140,19 +278,44 @@ void destroy_publ_data(PublData *data) {
     return;
   }
 
-  // Freeing info buckets
+  // Freeing the papers (removed ones are already gone)
   int i;
-  for (i = 0; i < data->hmax; i++) {
-    free_info_list(&data->buckets[i]);
+  for (i = 0; i < data->num_papers; i++) {
+    if (data->papers[i]) {
+      destroy_paper(data->papers[i]);
+    }
+  }
+  for (i = 0; i < data->num_slabs; i++) {
+    free(data->paper_slabs[i]);
   }
-  free(data->buckets);
+  free(data->paper_slabs);
+  free(data->papers);
+  free(data->stats);
+  free_columns(data->columns);
+  free(data->region_parent);
+  free(data->region_generation);
+  papers_ht_destroy(data->papers_ht);
+  free(data->papers_ht);
+  free_paper_filter(data->paper_filter);
 
   // Freeing MINI-hashtables :))
   free_cit_ht(data->citations_ht);
   free_venue_ht(data->venue_ht);
   free_field_ht(data->field_ht);
-  free_author_ht(data->authors_ht);
-  free_influence_ht(data->influence_ht);
+  free_author_registry(data->authors);
+  free(data->authors);
+  free_pending_ht(data->pending_ht);
+  free_query_cache(data->query_cache);
+  free(data->query_cache);
+  free_thread_pool(data->bfs_pool);
+  free(data->bfs_pool);
+  free_traversal_scratch(data->scratch);
+  free_influence_sketches(data->sketches);
+  free_hub_counts(data->hub_counts);
+  free_citation_years(data->citation_years);
+  free_influence_ranks(data->influence_ranks);
+  free_cold_store(data->cold_store);
+  free(data->cold_store);
 
   // Freeing PublData as a whole
   free(data);
@@ -163,73 +326,274 @@ void add_paper(PublData *data, const char *title, const char *venue,
                const int64_t *author_ids, const char **institutions,
                const int num_authors, const char **fields, const int num_fields,
                int64_t id, const int64_t *references, const int num_refs) {
-  unsigned int hash = data->hash_function(&id) % data->hmax;
   int i;
 
-  if (data == NULL) {
+  // IDs are unique - a paper is only added once
+  if (data == NULL || find_paper_with_id(data, id)) {
     return;
   }
 
   // Initializing data
-  Paper *publication = calloc(1, sizeof(Paper));
-  init_info(publication, title, venue, year, author_names, author_ids,
-            institutions, num_authors, fields, num_fields, id, references,
-            num_refs);
+  Paper *publication = new_paper_record(data);
+  init_info(publication, num_authors, num_fields, references, num_refs);
+
+  // Dense ID, stats & columns
+  Paper_Info *info = publication->info;
+  publication->id = id;
+  publication->year = year;
+  info->num_authors = num_authors;
+  register_paper(data, publication);
+  int idx = publication->idx;
 
   // Baisc info
-  memcpy(publication->title, title, (strlen(title) + 1) * sizeof(char));
+  info->spilled = data->cold_store != NULL;
+  info->title = store_string(data, title);
+
+  info->venue = store_string(data, venue);
+  data->columns->venue[idx] =
+      add_venue(data->venue_ht, info->venue, idx, &data->num_venues);
+  touch_venue(data, info->venue);
+
+  for (i = 0; i < info->num_authors; i++) {
+    register_author(data->authors, author_ids[i], author_names[i],
+                    institutions[i], idx, year, &info->authors[i]);
+    touch_author(data, info->authors[i].author);
+  }
+
+  // Fields
+  info->num_fields = num_fields;
+  for (i = 0; i < info->num_fields; i++) {
+    info->fields[i] = store_string(data, fields[i]);
+    add_field(data->field_ht, info->fields[i], idx);
+    touch_field(data, info->fields[i]);
+  }
 
-  memcpy(publication->venue, venue, (strlen(venue) + 1) * sizeof(char));
-  add_venue(data->venue_ht, publication->venue, id);
+  uint64_t *cited_idx = malloc((num_refs ? num_refs : 1) * sizeof(uint64_t));
+  DIE(cited_idx == NULL, "cited_idx malloc");
+  int num_cited = 0;
 
-  publication->year = year;
+  for (i = 0; i < num_refs; i++) {
+    Paper *cited = find_paper_with_id(data, references[i]);
+    if (cited) {
+      // Resolving the edge right away (idx is the biggest dense ID yet)
+      cited_idx[num_cited++] = cited->idx;
+      edge_list_push(&cited->influenced, idx);
+
+      data->columns->citations[cited->idx]++;
+      data->stats[cited->idx].in_degree++;
+      data->stats[idx].out_degree++;
+      if (data->hub_counts) {
+        check_hub_degree(data, cited->idx);
+      }
+
+      merge_regions(data, idx, cited->idx);
+      sketch_add_edge(data, cited->idx, idx);
+      touch_cited_paper(data, cited);
+    } else {
+      // Resolved / carried over when the cited paper gets added
+      add_pending(data->pending_ht, references[i], idx);
+      add_citation(data->citations_ht, references[i]);
+    }
+  }
 
-  // No. authors
-  publication->num_authors = num_authors;
+  edge_list_build(&publication->info->refs, cited_idx, num_cited);
+  free(cited_idx);
 
-  for (i = 0; i < publication->num_authors; i++) {
-    Author *author = publication->authors[i];
+  citation_years_add_paper(data, idx);
+}
 
-    // Author info
-    memcpy(author->name, author_names[i],
-           (strlen(author_names[i]) + 1) * sizeof(char));
+/*
+ * A cited paper is not known anymore => the edge goes back to waiting
+ */
+static void unresolve_edge(PublData *data, int64_t cited_id, Paper *citing) {
+  add_pending(data->pending_ht, cited_id, citing->idx);
+  add_citation(data->citations_ht, cited_id);
+
+  Paper_Stats *stats = &data->stats[citing->idx];
+  stats->out_degree--;
+  if (citing->info->refs.size > 2 * stats->out_degree) {
+    edge_list_compact(&citing->info->refs, data->papers);
+  }
+}
 
-    author->id = author_ids[i];
-    add_author(data->authors_ht, author_ids[i], id, year);
+/*
+ * A citing paper was removed => dropping a waiting edge
+ */
+static void drop_pending_edge(PublData *data, int64_t cited_id) {
+  int citations = remove_citation(data->citations_ht, cited_id);
 
-    memcpy(author->org, institutions[i],
-           (strlen(institutions[i]) + 1) * sizeof(char));
+  if (citations == 0) {
+    Idx_List dead = take_pending(data->pending_ht, cited_id);
+    idx_list_free(&dead);
+    return;
   }
 
-  // Fields
-  publication->num_fields = num_fields;
-  for (i = 0; i < publication->num_fields; i++) {
-    memcpy(publication->fields[i], fields[i],
-           (strlen(fields[i]) + 1) * sizeof(char));
-    add_field(data->field_ht, publication->fields[i], id);
+  Idx_List *waiting = pending_ht_get(data->pending_ht, cited_id);
+  if (waiting && waiting->size > 2 * citations) {
+    compact_idx_list(waiting, data->papers);
   }
+}
 
-  publication->id = id;
-  publication->num_refs = num_refs;
+void remove_paper(PublData *data, const int64_t id) {
+  Edge_Iter it;
+  uint64_t cited_id;
+  int i, cited, citing;
 
-  for (i = 0; i < num_refs; i++) {
-    publication->references[i] = references[i];
-    add_citation(data->citations_ht, references[i]);
-    add_influence(data->influence_ht, references[i], id);
+  Paper *publication = data ? find_paper_with_id(data, id) : NULL;
+  if (publication == NULL) {
+    return;
+  }
+
+  // Everything cached about it or around it is stale
+  int idx = publication->idx;
+  data->region_generation[find_region(data, idx)] = next_generation(data);
+  data->papers_generation = next_generation(data);
+  touch_cited_paper(data, publication);
+  if (data->sketches) {
+    // HyperLogLog cannot forget a paper => rebuilt by the next refresh
+    data->sketches->dirty = 1;
+  }
+  for (i = 0; i < publication->info->num_fields; i++) {
+    touch_field(data, publication->info->fields[i]);
+  }
+
+  citation_years_remove_paper(data, idx);
+
+  // From now on, its dense ID is dead everywhere it is still listed
+  data->papers[idx] = NULL;
+  papers_ht_remove(data->papers_ht, id, NULL);
+
+  // Venue, authors & fields
+  int venue = remove_venue(data->venue_ht, publication->info->venue,
+                           data->papers);
+  citation_years_remove_venue(data->citation_years, venue);
+  for (i = 0; i < publication->info->num_authors; i++) {
+    unregister_author(data->authors, publication->info->authors[i].author,
+                      data->papers);
+  }
+  for (i = 0; i < publication->info->num_fields; i++) {
+    remove_field(data->field_ht, publication->info->fields[i], data->papers);
+  }
+
+  // Papers it cites - one citation less
+  edge_iter_init(&it, &publication->info->refs);
+  while (edge_iter_next_idx(&it, &cited)) {
+    if (data->papers[cited]) {
+      Paper_Stats *stats = &data->stats[cited];
+      touch_cited_paper(data, data->papers[cited]);
+      data->columns->citations[cited]--;
+      stats->in_degree--;
+      if (data->papers[cited]->influenced.size > 2 * stats->in_degree) {
+        edge_list_compact(&data->papers[cited]->influenced, data->papers);
+      }
+    }
+  }
+
+  // Papers it was still waiting for
+  edge_iter_init(&it, &publication->info->references);
+  while (edge_iter_next(&it, &cited_id)) {
+    if ((int64_t)cited_id != id && !find_paper_with_id(data, cited_id)) {
+      drop_pending_edge(data, cited_id);
+    }
+  }
+
+  // Papers citing it - waiting for it again
+  edge_iter_init(&it, &publication->influenced);
+  while (edge_iter_next_idx(&it, &citing)) {
+    if (data->papers[citing]) {
+      unresolve_edge(data, id, data->papers[citing]);
+    }
+  }
+
+  // Dead slots are skipped by the scans (see Columns.h)
+  memset(&data->stats[idx], 0, sizeof(Paper_Stats));
+  data->columns->year[idx] = DEAD_YEAR;
+  data->columns->venue[idx] = NO_VENUE;
+  data->columns->citations[idx] = 0;
+  data->columns->num_authors[idx] = 0;
+  destroy_paper(publication);
+}
+
+void update_paper(PublData *data, const char *title, const char *venue,
+                  const int year, const char **author_names,
+                  const int64_t *author_ids, const char **institutions,
+                  const int num_authors, const char **fields,
+                  const int num_fields, const int64_t id,
+                  const int64_t *references, const int num_refs) {
+  /*
+   * The new version gets a new dense ID; the edges of the papers citing
+   * the old one wait in Pending_HT in between and get resolved again
+   */
+  remove_paper(data, id);
+  add_paper(data, title, venue, year, author_names, author_ids, institutions,
+            num_authors, fields, num_fields, id, references, num_refs);
+}
+
+/* ------------------  Column scans  ---------------------------*/
+int64_t count_papers_in_range(PublData *data, Paper_Column column,
+                              int32_t low, int32_t high) {
+  if (data == NULL) {
+    return 0;
+  }
+
+  return count_in_range(get_column(data->columns, column),
+                        data->columns->year, data->num_papers, low, high);
+}
+
+int64_t sum_papers_in_range(PublData *data, Paper_Column summed,
+                            Paper_Column filtered, int32_t low, int32_t high) {
+  if (data == NULL) {
+    return 0;
+  }
+
+  return sum_in_range(get_column(data->columns, summed),
+                      get_column(data->columns, filtered), data->columns->year,
+                      data->num_papers, low, high);
+}
+
+int32_t get_venue_column_id(PublData *data, const char *venue) {
+  Paper_Postings *venue_papers =
+      data ? venue_ht_get(data->venue_ht, venue) : NULL;
+
+  return venue_papers ? venue_papers->id : NO_VENUE;
+}
+
+/* ------------------  Query limits  ---------------------------*/
+int64_t query_deadline(int64_t timeout_ms) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec + timeout_ms * 1000000;
+}
+
+int query_limit_reached(const Query_Limit *limit) {
+  struct timespec now;
+
+  if (limit == NULL) {
+    return 0;
+  }
+  if (limit->cancelled && atomic_load_explicit(limit->cancelled,
+                                               memory_order_relaxed)) {
+    return 1;
+  }
+  if (limit->deadline_ns == 0) {
+    return 0;
   }
 
-  // Package & Send
-  add_last_node(data->buckets[hash], publication);
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec >= limit->deadline_ns;
 }
 
 /* ------------------  Task 1  ---------------------------------*/
-char *get_oldest_influence(PublData *data, const int64_t id_paper) {
+static char *find_oldest_influence(PublData *data, Paper *starting_paper,
+                                   const Query_Limit *limit, int *complete) {
   // Initializing variables
+  Edge_Iter it;
   int i;
-  unsigned int hash;
-  struct Node *curr;
   Paper *publication, *vertex;
   Paper *oldest_influence = NULL;
+  Traversal_Scratch *scratch = begin_traversal(data);
+  int64_t id_paper = starting_paper->id;
 
   struct Queue *q = malloc(sizeof(struct Queue));
   init_q(q);
@@ -238,12 +602,22 @@ char *get_oldest_influence(PublData *data, const int64_t id_paper) {
    * Enqueing the given paper
    * Marking it as visited
    */
-  Paper *starting_paper = find_paper_with_id(data, id_paper);
   enqueue(q, starting_paper);
-  starting_paper->ok = VISITED;
+  visit_paper(scratch, starting_paper->idx);
 
-  // BFS-style search
+  // BFS-style search - level_left papers of the current level are queued
+  int level_left = 1, next_level = 0;
   while (!is_empty_q(q)) {
+    if (level_left == 0) {
+      // A new level - the limit is checked in between levels
+      if (query_limit_reached(limit)) {
+        *complete = 0;
+        break;
+      }
+      level_left = next_level;
+      next_level = 0;
+    }
+
     vertex = (Paper *)front(q);
 
     // Checking if the vertex is an older influence
@@ -256,67 +630,86 @@ char *get_oldest_influence(PublData *data, const int64_t id_paper) {
     }
 
     // Searching for further references through the vertex's references
-    for (i = 0; i < vertex->num_refs; i++) {
-      hash = data->hash_function(&vertex->references[i]) % data->hmax;
-      curr = data->buckets[hash]->head;
-
-      while (curr) {
-        publication = (Paper *)curr->data;
-        if (publication->id == vertex->references[i]) {
-          if (!publication->ok) {
-            // Unvisited reference found
-            enqueue(q, publication);
-            publication->ok = VISITED;
-          }
-          break;
-        }
-        curr = curr->next;
+    edge_iter_init(&it, &vertex->info->refs);
+    while (edge_iter_next_idx(&it, &i)) {
+      publication = data->papers[i];
+
+      if (publication && visit_paper(scratch, i)) {
+        // Unvisited reference found
+        enqueue(q, publication);
+        next_level++;
       }
     }
 
     // Done with current vertex
     dequeue(q);
+    level_left--;
   }
 
   // Freeing allocated memory
-  clean_refs_aux_data(data, starting_paper);
   purge_q(q);
   free(q);
 
   if (oldest_influence) {
-    return oldest_influence->title;
+    return oldest_influence->info->title;
   }
 
   return "None";
 }
 
-/* ------------------  Task 2  ---------------------------------*/
-float get_venue_impact_factor(PublData *data, const char *venue) {
-  int64_t x = 0;
-  int cnt = 0;
-
-  char *copy_venue = calloc(strlen(venue) + 1, sizeof(char));
-  DIE(copy_venue == NULL, "copy_venue calloc");
-
-  memcpy(copy_venue, venue, (strlen(venue) + 1) * sizeof(char));
+char *get_oldest_influence(PublData *data, const int64_t id_paper) {
+  return get_oldest_influence_limited(data, id_paper, NULL, NULL);
+}
 
-  unsigned int hash =
-      data->venue_ht->hash_function(copy_venue) % data->venue_ht->hmax;
-  struct Node *curr = data->venue_ht->buckets[hash].head;
+char *get_oldest_influence_limited(PublData *data, const int64_t id_paper,
+                                   const Query_Limit *limit, int *complete) {
+  int whole = 1;
 
-  while (curr) {
-    venue_paper *publication = (venue_paper *)curr->data;
+  Paper *starting_paper = find_paper_with_id(data, id_paper);
+  if (starting_paper == NULL) {
+    if (complete) {
+      *complete = 1;
+    }
+    return "None";
+  }
 
-    if (!strcmp(publication->venue, venue)) {
-      int cits = get_no_citations(data->citations_ht, publication->id);
-      x += cits;
-      cnt++;
+  // The result depends only on the papers linked to the given one
+  uint64_t generation =
+      data->region_generation[get_region(data, starting_paper->idx)];
+  char *key = make_query_key("get_oldest_influence %" PRId64, id_paper);
+
+  // A search cut short is not the answer - it is not cached
+  char *title;
+  cached_query *cached = lookup_query(data->query_cache, key, generation);
+  if (cached) {
+    title = cached->title;
+  } else {
+    title = find_oldest_influence(data, starting_paper, limit, &whole);
+    if (whole) {
+      store_query(data->query_cache, key, generation)->title = title;
     }
+  }
 
-    curr = curr->next;
+  free(key);
+  if (complete) {
+    *complete = whole;
   }
+  return title;
+}
+
+/* ------------------  Task 2  ---------------------------------*/
+static float compute_impact_factor(PublData *data,
+                                   Paper_Postings *venue_papers) {
+  int64_t x = 0;
+  int i, cnt = 0;
 
-  free(copy_venue);
+  if (venue_papers) {
+    // Removed papers have their citations zeroed
+    for (i = 0; i < venue_papers->papers.size; i++) {
+      x += data->columns->citations[venue_papers->papers.items[i]];
+    }
+    cnt = venue_papers->papers.size - venue_papers->removed;
+  }
 
   if (cnt) {
     return (float)x / cnt;
@@ -325,93 +718,633 @@ float get_venue_impact_factor(PublData *data, const char *venue) {
   return 0.f;
 }
 
+float get_venue_impact_factor(PublData *data, const char *venue) {
+  Paper_Postings *venue_papers = venue_ht_get(data->venue_ht, venue);
+  uint64_t generation = venue_papers ? venue_papers->generation : 0;
+  char *key = make_query_key("get_venue_impact_factor %s", venue);
+
+  cached_query *cached = lookup_query(data->query_cache, key, generation);
+  if (cached == NULL) {
+    cached = store_query(data->query_cache, key, generation);
+    cached->impact_factor = compute_impact_factor(data, venue_papers);
+  }
+
+  free(key);
+  return cached->impact_factor;
+}
+
+float get_venue_impact_factor_window(PublData *data, const char *venue,
+                                     const int year, const int num_years) {
+  Paper_Postings *venue_papers = venue_ht_get(data->venue_ht, venue);
+
+  if (venue_papers == NULL || num_years <= 0) {
+    return 0.f;
+  }
+
+  // Two prefix sums over the venue's trees
+  int cnt = count_venue_papers(data->citation_years, venue_papers->id,
+                               year - num_years, year - 1);
+  int x = count_venue_citations(data->citation_years, venue_papers->id,
+                                year - num_years, year - 1, year, year);
+
+  return cnt ? (float)x / cnt : 0.f;
+}
+
 /* ------------------  Task 3  ---------------------------------*/
-int get_number_of_influenced_papers(PublData *data, const int64_t id_paper,
-                                    const int max_dist) {
-  // Initializing variables
-  unsigned int hash;
-  struct Node *curr;
-  int64_t influencer_id;
-  influenced_paper *imitator;
-  Influence_HT *ht = data->influence_ht;
-
-  // Initializing markings HT
-  data->markings_ht = calloc(1, sizeof(Markings_HT));
-  DIE(data->markings_ht == NULL, "data->markings_ht calloc");
-  init_markings_ht(data->markings_ht);
-
-  // Distance & count
-  int curr_dist = 0;
-  int cnt = 0;
+/*
+ * Parallel level-synchronous BFS, for the big frontiers
+ * Each level's frontier is split in chunks, taken by the pool's workers; a
+ * paper is claimed by whoever sets its bit in the (atomic) bitmap first, and
+ * goes in that worker's own list - merged into the next frontier in between
+ * levels. The papers themselves are only read.
+ */
+typedef struct parallel_bfs {
+  PublData *data;
+  _Atomic uint64_t *seen;  // Bitmap over dense IDs
+  int *frontier;
+  int frontier_size;
+  atomic_int next_chunk;
+  Idx_List next[MAX_POOL_THREADS];  // Per worker
+} Parallel_BFS;
+
+static inline int claim_paper(_Atomic uint64_t *seen, int idx) {
+  uint64_t bit = 1ULL << (idx & 63);
+  _Atomic uint64_t *word = &seen[idx >> 6];
+
+  // Cheap check first - most neighbours of a big frontier are already seen
+  if (atomic_load_explicit(word, memory_order_relaxed) & bit) {
+    return 0;
+  }
 
-  // Queue
-  struct Queue *q = malloc(sizeof(struct Queue));
-  init_q(q);
+  return !(atomic_fetch_or_explicit(word, bit, memory_order_relaxed) & bit);
+}
 
-  /*
-   * Queue - contains influencers' IDs
-   * First Influencer - starting paper
-   */
-  enqueue(q, &id_paper);
-  add_marking(data->markings_ht, id_paper, 0);
+static void expand_frontier(void *arg, int worker) {
+  Parallel_BFS *bfs = arg;
+  Paper **papers = bfs->data->papers;
+  Idx_List *next = &bfs->next[worker];
+  Edge_Iter it;
+  int i, j;
 
-  // BFS-style search
-  while (curr_dist <= max_dist && !is_empty_q(q)) {
-    influencer_id = *(int64_t *)front(q);
+  while (1) {
+    int from = atomic_fetch_add(&bfs->next_chunk, PARALLEL_BFS_CHUNK);
+    if (from >= bfs->frontier_size) {
+      break;
+    }
 
-    // Searching for further imitators through the influencer's list
-    hash = ht->hash_function(&influencer_id) % ht->hmax;
-    curr = ht->buckets[hash].head;
+    int to = from + PARALLEL_BFS_CHUNK;
+    if (to > bfs->frontier_size) {
+      to = bfs->frontier_size;
+    }
 
-    while (curr) {
-      imitator = (influenced_paper *)curr->data;
+    for (i = from; i < to; i++) {
+      edge_iter_init(&it, &papers[bfs->frontier[i]]->influenced);
+      while (edge_iter_next_idx(&it, &j)) {
+        if (papers[j] && claim_paper(bfs->seen, j)) {
+          idx_list_push(next, j);
+        }
+      }
+    }
+  }
+}
 
-      if (ht->compare_function(&influencer_id, imitator->key) == 0) {
-        marking *imitator_status =
-            get_markings(data->markings_ht, imitator->value);
+static Thread_Pool *get_bfs_pool(PublData *data) {
+  // Started on first use - most workloads never need it
+  if (data->bfs_pool == NULL) {
+    data->bfs_pool = calloc(1, sizeof(Thread_Pool));
+    DIE(data->bfs_pool == NULL, "data->bfs_pool calloc");
+    init_thread_pool(data->bfs_pool, 0);
+  }
 
-        // Unvisited imitator found
-        if (!imitator_status) {
-          enqueue(q, &imitator->value);
+  return data->bfs_pool;
+}
 
-          // Calculate_distance from imitator to origin
-          marking *influencer_status =
-              get_markings(data->markings_ht, influencer_id);
-          int imitator_dist = influencer_status->distance + 1;
+/*
+ * Takes over a sequential search: visited holds everything seen so far, the
+ * papers from level_start on being the current frontier (at `distance`)
+ * Returns how many more papers are found, up to max_dist
+ */
+static int count_influenced_parallel(PublData *data, Idx_List *visited,
+                                     int level_start, int distance,
+                                     const int max_dist,
+                                     const Query_Limit *limit, int *complete) {
+  Thread_Pool *pool = get_bfs_pool(data);
+  Parallel_BFS bfs = {0};
+  Idx_List frontier = {0};
+  int i, w, cnt = 0;
+
+  bfs.data = data;
+  bfs.seen = calloc((data->num_papers + 63) / 64, sizeof(uint64_t));
+  DIE(bfs.seen == NULL, "bfs.seen calloc");
+  for (i = 0; i < visited->size; i++) {
+    atomic_fetch_or_explicit(&bfs.seen[visited->items[i] >> 6],
+                             1ULL << (visited->items[i] & 63),
+                             memory_order_relaxed);
+  }
 
-          // Mark imitator as visited
-          add_marking(data->markings_ht, imitator->value, imitator_dist);
+  idx_list_reserve(&frontier, visited->size - level_start);
+  for (i = level_start; i < visited->size; i++) {
+    idx_list_push(&frontier, visited->items[i]);
+  }
 
-          // Updating overall distance from origin
-          if (imitator_dist > curr_dist) {
-            curr_dist = imitator_dist;
-          }
+  for (; frontier.size && distance < max_dist; distance++) {
+    if (query_limit_reached(limit)) {
+      *complete = 0;
+      break;
+    }
 
-          // Avoiding the increase of count if max_distance is surpassed
-          if (curr_dist > max_dist) {
-            break;
-          }
+    bfs.frontier = frontier.items;
+    bfs.frontier_size = frontier.size;
+    atomic_store(&bfs.next_chunk, 0);
+    run_on_pool(pool, expand_frontier, &bfs);
+
+    // Merging the workers' findings into the next frontier
+    frontier.size = 0;
+    for (w = 0; w < pool->num_workers; w++) {
+      for (i = 0; i < bfs.next[w].size; i++) {
+        idx_list_push(&frontier, bfs.next[w].items[i]);
+      }
+      bfs.next[w].size = 0;
+    }
+    cnt += frontier.size;
+  }
+
+  for (w = 0; w < pool->num_workers; w++) {
+    idx_list_free(&bfs.next[w]);
+  }
+  idx_list_free(&frontier);
+  free(bfs.seen);
+
+  return cnt;
+}
+
+static int count_influenced_papers(PublData *data, const int64_t id_paper,
+                                   const int max_dist,
+                                   const Query_Limit *limit, int *complete) {
+  // Initializing variables
+  Edge_Iter it;
+  int i, j;
+  Idx_List visited = {0};
+  int cnt = 0;
+
+  if (max_dist <= 0) {
+    return 0;
+  }
+
+  Traversal_Scratch *scratch = begin_traversal(data);
+
+  /*
+   * The search starts from the given paper or, if it was not added yet, from
+   * the papers waiting for it (at distance 1)
+   */
+  Paper *starting_paper = find_paper_with_id(data, id_paper);
+  if (starting_paper) {
+    visit_paper(scratch, starting_paper->idx);
+    idx_list_push(&visited, starting_paper->idx);
+  }
+
+  Idx_List *first_imitators =
+      starting_paper ? NULL : pending_ht_get(data->pending_ht, id_paper);
+  for (i = 0; first_imitators && i < first_imitators->size; i++) {
+    int imitator = first_imitators->items[i];
+    if (data->papers[imitator] && visit_paper(scratch, imitator)) {
+      idx_list_push(&visited, imitator);
+      cnt++;
+    }
+  }
+
+  /*
+   * BFS-style search, level by level
+   * visited doubles as the queue - the papers are in distance order, the
+   * current level being visited[level_start, level_end)
+   */
+  int distance = starting_paper ? 0 : 1;
+  int level_start = 0;
+  while (level_start < visited.size && distance < max_dist) {
+    int level_end = visited.size;
+
+    // Big frontiers go to the thread pool
+    if (!data->serial_bfs &&
+        level_end - level_start >= PARALLEL_BFS_THRESHOLD) {
+      cnt += count_influenced_parallel(data, &visited, level_start, distance,
+                                       max_dist, limit, complete);
+      break;
+    }
+
+    if (query_limit_reached(limit)) {
+      *complete = 0;
+      break;
+    }
+
+    for (i = level_start; i < level_end; i++) {
+      // Searching for further imitators through the influencer's list
+      edge_iter_init(&it, &data->papers[visited.items[i]]->influenced);
+      while (edge_iter_next_idx(&it, &j)) {
+        // Unvisited imitator found
+        if (data->papers[j] && visit_paper(scratch, j)) {
+          idx_list_push(&visited, j);
 
           // Increasing influence count
           cnt++;
         }
       }
-      // Going further down the influencer's list
-      curr = curr->next;
     }
 
-    // Done with current influencer
-    dequeue(q);
+    level_start = level_end;
+    distance++;
   }
 
   // Freeing allocated memory
-  free_markings_ht(data->markings_ht);
-  purge_q(q);
-  free(q);
+  idx_list_free(&visited);
 
   return cnt;
 }
 
+int get_number_of_influenced_papers(PublData *data, const int64_t id_paper,
+                                    const int max_dist) {
+  return get_number_of_influenced_papers_limited(data, id_paper, max_dist,
+                                                 NULL, NULL);
+}
+
+int get_number_of_influenced_papers_limited(PublData *data,
+                                            const int64_t id_paper,
+                                            const int max_dist,
+                                            const Query_Limit *limit,
+                                            int *complete) {
+  int whole = 1, cnt;
+
+  // Papers that were not added yet are not cached - they have no region
+  Paper *starting_paper = find_paper_with_id(data, id_paper);
+  if (starting_paper == NULL || max_dist <= 0) {
+    cnt = count_influenced_papers(data, id_paper, max_dist, limit, &whole);
+    if (complete) {
+      *complete = whole;
+    }
+    return cnt;
+  }
+
+  // Hubs - a lookup in their counts, if fresh (the writer recounts them)
+  Hub_Entry *hub = data->hub_counts && max_dist <= data->hub_counts->max_dist
+                       ? get_hub_entry(data, starting_paper->idx)
+                       : NULL;
+  if (hub) {
+    if (complete) {
+      *complete = 1;
+    }
+    return hub->counts[max_dist - 1];
+  }
+
+  uint64_t generation =
+      data->region_generation[get_region(data, starting_paper->idx)];
+  char *key = make_query_key("get_number_of_influenced_papers %" PRId64 " %d",
+                             id_paper, max_dist);
+
+  // A lower bound is not the answer - it is not cached
+  cached_query *cached = lookup_query(data->query_cache, key, generation);
+  if (cached) {
+    cnt = cached->value;
+  } else {
+    cnt = count_influenced_papers(data, id_paper, max_dist, limit, &whole);
+    if (whole) {
+      store_query(data->query_cache, key, generation)->value = cnt;
+    }
+  }
+
+  free(key);
+  if (complete) {
+    *complete = whole;
+  }
+  return cnt;
+}
+
+/*
+ * Multi-source BFS - up to 64 searches at once, one bit per search
+ * For paper v, seen / level[cur] / level[!cur] hold the searches that reached
+ * it / reach it on the current level / on the next one (kept side by side, so
+ * reaching a paper touches a single cache line). Expanding a paper once
+ * pushes all its searches along its edges in a single OR, so the papers
+ * shared by the searches are visited once per batch, not per query.
+ */
+typedef struct search_words {
+  uint64_t seen;
+  uint64_t level[2];
+} search_words;
+
+typedef struct multi_bfs {
+  search_words *words;
+  int cur;  // Current level's word
+  Idx_List active;  // Papers with a non-empty current level word
+  Idx_List next_active;
+  Idx_List touched;  // Papers with a non-empty seen word
+} Multi_BFS;
+
+static inline void reach_paper(Multi_BFS *bfs, int idx, uint64_t searches) {
+  search_words *w = &bfs->words[idx];
+  uint64_t found = searches & ~w->seen;
+  if (found == 0) {
+    return;
+  }
+
+  if (w->seen == 0) {
+    idx_list_push(&bfs->touched, idx);
+  }
+  if (w->level[!bfs->cur] == 0) {
+    idx_list_push(&bfs->next_active, idx);
+  }
+  w->seen |= found;
+  w->level[!bfs->cur] |= found;
+}
+
+static int compare_dense_ids(const void *a, const void *b) {
+  const int64_t *x = a;
+  const int64_t *y = b;
+
+  return (x[0] > y[0]) - (x[0] < y[0]);
+}
+
+/* Runs the searches of queries[0..n) (n <= 64) and fills in their results */
+static void count_influenced_group(PublData *data, Multi_BFS *bfs,
+                                   const int64_t *ids, const int *max_dists,
+                                   const int *queries, int n, int *results) {
+  Edge_Iter it;
+  int i, j, distance;
+  int max_level = 0;
+
+  // Level 0 - the given papers; level 1 - the ones waiting for absent papers
+  for (i = 0; i < n; i++) {
+    int q = queries[i];
+    uint64_t bit = 1ULL << i;
+    Paper *source = find_paper_with_id(data, ids[q]);
+
+    results[q] = source ? -1 : 0;  // The source itself does not count
+    if (max_dists[q] > max_level) {
+      max_level = max_dists[q];
+    }
+
+    if (source) {
+      search_words *w = &bfs->words[source->idx];
+      if (w->seen == 0) {
+        idx_list_push(&bfs->touched, source->idx);
+      }
+      if (w->level[bfs->cur] == 0) {
+        idx_list_push(&bfs->active, source->idx);
+      }
+      w->seen |= bit;
+      w->level[bfs->cur] |= bit;
+      continue;
+    }
+
+    Idx_List *waiting = pending_ht_get(data->pending_ht, ids[q]);
+    for (j = 0; waiting && j < waiting->size; j++) {
+      if (data->papers[waiting->items[j]]) {
+        reach_paper(bfs, waiting->items[j], bit);
+      }
+    }
+  }
+
+  for (distance = 0; distance < max_level; distance++) {
+    // Searches allowed to go one level further
+    uint64_t going = 0;
+    for (i = 0; i < n; i++) {
+      if (max_dists[queries[i]] > distance) {
+        going |= 1ULL << i;
+      }
+    }
+
+    for (i = 0; i < bfs->active.size; i++) {
+      int influencer = bfs->active.items[i];
+      uint64_t searches = bfs->words[influencer].level[bfs->cur] & going;
+      bfs->words[influencer].level[bfs->cur] = 0;
+      if (searches == 0) {
+        continue;
+      }
+
+      edge_iter_init(&it, &data->papers[influencer]->influenced);
+      while (edge_iter_next_idx(&it, &j)) {
+        if (data->papers[j]) {
+          reach_paper(bfs, j, searches);
+        }
+      }
+    }
+
+    // The next level becomes the current one
+    bfs->cur = !bfs->cur;
+    Idx_List active = bfs->active;
+    bfs->active = bfs->next_active;
+    bfs->next_active = active;
+    bfs->next_active.size = 0;
+
+    if (bfs->active.size == 0) {
+      break;
+    }
+  }
+
+  // Counting every search's papers & leaving the words zeroed
+  for (i = 0; i < bfs->active.size; i++) {
+    bfs->words[bfs->active.items[i]].level[bfs->cur] = 0;
+  }
+  bfs->active.size = 0;
+
+  for (i = 0; i < bfs->touched.size; i++) {
+    int idx = bfs->touched.items[i];
+    uint64_t searches = bfs->words[idx].seen;
+    while (searches) {
+      results[queries[__builtin_ctzll(searches)]]++;
+      searches &= searches - 1;
+    }
+    bfs->words[idx].seen = 0;
+  }
+  bfs->touched.size = 0;
+}
+
+void get_number_of_influenced_papers_batch(PublData *data, const int64_t *ids,
+                                           const int *max_dists,
+                                           int num_queries, int *results) {
+  Multi_BFS bfs = {0};
+  int group[MULTI_BFS_WIDTH];
+  int i, n = 0;
+
+  bfs.words = calloc(data->num_papers + 1, sizeof(search_words));
+  DIE(bfs.words == NULL, "bfs.words calloc");
+
+  /*
+   * Grouping the sources by dense ID - papers added close to each other tend
+   * to share their readers, so the searches of a group overlap more
+   * (order[i] = {dense ID or -1 if absent, query})
+   */
+  int64_t(*order)[2] = malloc((num_queries ? num_queries : 1) * sizeof(*order));
+  DIE(order == NULL, "order malloc");
+  for (i = 0; i < num_queries; i++) {
+    Paper *source = find_paper_with_id(data, ids[i]);
+    order[i][0] = source ? source->idx : -1;
+    order[i][1] = i;
+  }
+  qsort(order, num_queries, sizeof(*order), compare_dense_ids);
+
+  for (i = 0; i < num_queries; i++) {
+    int q = (int)order[i][1];
+    if (max_dists[q] <= 0) {
+      results[q] = 0;
+      continue;
+    }
+
+    group[n++] = q;
+    if (n == MULTI_BFS_WIDTH) {
+      count_influenced_group(data, &bfs, ids, max_dists, group, n, results);
+      n = 0;
+    }
+  }
+  if (n) {
+    count_influenced_group(data, &bfs, ids, max_dists, group, n, results);
+  }
+
+  free(order);
+  free(bfs.words);
+  idx_list_free(&bfs.active);
+  idx_list_free(&bfs.next_active);
+  idx_list_free(&bfs.touched);
+}
+
+/* Memory-bounded mode - see ColdStore.h */
+int enable_cold_store(PublData *data, const char *path) {
+  // Only before the first paper - the strings already on the heap stay there
+  if (data == NULL || data->cold_store || data->num_papers ||
+      data->authors->strings.strings.size) {
+    return -1;
+  }
+
+  Cold_Store *store = calloc(1, sizeof(Cold_Store));
+  DIE(store == NULL, "store calloc");
+  if (init_cold_store(store, path) < 0) {
+    free(store);
+    return -1;
+  }
+
+  data->cold_store = store;
+  data->authors->strings.store = store;
+  return 0;
+}
+
+/* Exact counts of the hubs - see HubCounts.h */
+void enable_hub_counts(PublData *data, const int max_dist,
+                       const int min_degree) {
+  int i;
+
+  if (data == NULL || max_dist <= 0) {
+    return;
+  }
+
+  free_hub_counts(data->hub_counts);
+  data->hub_counts = calloc(1, sizeof(Hub_Counts));
+  DIE(data->hub_counts == NULL, "data->hub_counts calloc");
+  init_hub_counts(data->hub_counts, max_dist, min_degree, data->cap_papers);
+
+  for (i = 0; i < data->num_papers; i++) {
+    if (data->papers[i]) {
+      check_hub_degree(data, i);
+    }
+  }
+  refresh_hubs(data);
+}
+
+void refresh_hub_counts(PublData *data) {
+  if (data) {
+    refresh_hubs(data);
+  }
+}
+
+/* Approximate mode - see InfluenceSketch.h */
+void enable_influence_sketches(PublData *data, const int max_dist,
+                               const int precision) {
+  if (data == NULL || max_dist <= 0) {
+    return;
+  }
+
+  free_influence_sketches(data->sketches);
+  data->sketches = calloc(1, sizeof(Influence_Sketches));
+  DIE(data->sketches == NULL, "data->sketches calloc");
+  init_influence_sketches(data->sketches, max_dist, precision,
+                          data->cap_papers);
+  rebuild_influence_sketches(data);
+}
+
+int get_approx_number_of_influenced_papers(PublData *data,
+                                           const int64_t id_paper,
+                                           const int max_dist) {
+  if (max_dist <= 0) {
+    return 0;
+  }
+
+  // Deeper than the sketches go => exact answer
+  if (data->sketches == NULL || max_dist > data->sketches->max_dist) {
+    return get_number_of_influenced_papers(data, id_paper, max_dist);
+  }
+
+  // A query only reads - stale sketches wait for refresh_influence_sketches
+  if (data->sketches->dirty) {
+    return get_number_of_influenced_papers(data, id_paper, max_dist);
+  }
+
+  return estimate_influence(data, id_paper, max_dist);
+}
+
+void refresh_influence_sketches(PublData *data) {
+  if (data && data->sketches && data->sketches->dirty) {
+    rebuild_influence_sketches(data);
+  }
+}
+
+float get_approx_influence_error(PublData *data) {
+  if (data == NULL || data->sketches == NULL) {
+    return 0.f;
+  }
+
+  return influence_sketch_error(data->sketches);
+}
+
+/* PageRank - see InfluenceRank.h */
+int rank_influence(PublData *data, const double damping,
+                   const double tolerance, const int max_iterations) {
+  if (data == NULL || damping < 0 || damping >= 1 || max_iterations <= 0) {
+    return -1;
+  }
+
+  if (data->influence_ranks == NULL) {
+    data->influence_ranks = calloc(1, sizeof(Influence_Ranks));
+    DIE(data->influence_ranks == NULL, "data->influence_ranks calloc");
+  }
+
+  // Small graphs stay on this thread, like the small searches
+  Thread_Pool *pool = NULL;
+  if (!data->serial_bfs && data->num_papers >= PARALLEL_BFS_THRESHOLD) {
+    pool = get_bfs_pool(data);
+  }
+
+  compute_influence_ranks(data, pool, data->influence_ranks, damping,
+                          tolerance, max_iterations);
+  return data->influence_ranks->iterations;
+}
+
+double get_influence_rank(PublData *data, const int64_t id_paper) {
+  Paper *publication = data ? find_paper_with_id(data, id_paper) : NULL;
+
+  if (publication == NULL || data->influence_ranks == NULL ||
+      publication->idx >= data->influence_ranks->num_papers) {
+    return 0;
+  }
+
+  return data->influence_ranks->scores[publication->idx];
+}
+
+int64_t *get_most_influential_papers(PublData *data, int *num_papers) {
+  if (data == NULL || data->influence_ranks == NULL) {
+    *num_papers = 0;
+    return NULL;
+  }
+
+  return top_influence_ranks(data, data->influence_ranks, num_papers);
+}
+
 int get_erdos_distance(PublData *data, const int64_t id1, const int64_t id2) {
   /* TODO: implement get_erdos_distance */
 
@@ -425,72 +1358,83 @@ char **get_most_cited_papers_by_field(PublData *data, const char *field,
 }
 
 /* ------------------  Task 6 ---------------------------------*/
+static int count_papers_between_dates(PublData *data, const int early_date,
+                                      const int late_date) {
+  // Scanning the year column (removed papers have DEAD_YEAR)
+  return count_in_range(data->columns->year, data->columns->year,
+                        data->num_papers, early_date, late_date);
+}
+
 int get_number_of_papers_between_dates(PublData *data, const int early_date,
                                        const int late_date) {
-  int i;
-  int cnt = 0;
-
-  /*
-   * Iterating through the whole hashtable looking for papers between
-   * the given dates
-   */
-  for (i = 0; i < data->hmax; i++) {
-    struct Node *curr = data->buckets[i]->head;
-    while (curr) {
-      Paper *publication = curr->data;
-      // Paper published between the given dates
-      if (publication->year >= early_date && publication->year <= late_date) {
-        cnt++;
-      }
-      // Going further down the LinkedList
-      curr = curr->next;
-    }
+  char *key = make_query_key("get_number_of_papers_between_dates %d %d",
+                             early_date, late_date);
+
+  cached_query *cached =
+      lookup_query(data->query_cache, key, data->papers_generation);
+  if (cached == NULL) {
+    cached = store_query(data->query_cache, key, data->papers_generation);
+    cached->value = count_papers_between_dates(data, early_date, late_date);
   }
 
-  return cnt;
+  free(key);
+  return cached->value;
 }
 
 /* ------------------  Task 7  ---------------------------------*/
-int get_number_of_authors_with_field(PublData *data, const char *institution,
-                                     const char *field) {
+static int count_authors_with_field(PublData *data, const char *institution,
+                                    Paper_Postings *postings) {
   int i, j;
-  int cnt = 0;
-
-  int64_t ids_with_field[NMAX];
-  int no_ids = no_papers_with_field(data->field_ht, field, ids_with_field);
-
-  char **author_names = calloc(MAX_AUTHORS, sizeof(char *));
-  DIE(author_names == NULL, "author_names malloc");
 
-  for (i = 0; i < MAX_AUTHORS; i++) {
-    author_names[i] = calloc(LEN_NAME, sizeof(char));
-    DIE(author_names[i] == NULL, "author_names[i] malloc");
+  // Nobody ever worked there => nothing to look for
+  int org = find_string(&data->authors->strings, institution);
+  if (postings == NULL || org == NO_STRING) {
+    return 0;
   }
 
-  for (i = 0; i < no_ids; i++) {
-    Paper *publication = find_paper_with_id(data, ids_with_field[i]);
-    for (j = 0; j < publication->num_authors; j++) {
-      Author *author = publication->authors[j];
-      if (!strcmp(author->org, institution) &&
-          !is_in_array(author->name, author_names, cnt + 1)) {
-        memcpy(author_names[cnt], author->name,
-               (strlen(author->name) + 1) * sizeof(char));
-        cnt++;
+  // Distinct names, as String_Pool IDs
+  Id_Set names;
+  id_set_init(&names, HMAX_SMALL);
+
+  for (i = 0; i < postings->papers.size; i++) {
+    Paper *publication = data->papers[postings->papers.items[i]];
+    if (publication == NULL) {
+      continue;
+    }
+    for (j = 0; j < publication->info->num_authors; j++) {
+      Paper_Author *author = &publication->info->authors[j];
+      if (author->org == org) {
+        id_set_put(&names, author->name);
       }
     }
   }
 
-  for (i = 0; i < MAX_AUTHORS; i++) {
-    free(author_names[i]);
-  }
-  free(author_names);
+  int cnt = names.size;
+  id_set_destroy(&names);
 
   return cnt;
 }
 
+int get_number_of_authors_with_field(PublData *data, const char *institution,
+                                     const char *field) {
+  Paper_Postings *postings = field_ht_get(data->field_ht, field);
+  uint64_t generation = postings ? postings->generation : 0;
+  char *key = make_query_key("get_number_of_authors_with_field %s\x1f%s",
+                             institution, field);
+
+  cached_query *cached = lookup_query(data->query_cache, key, generation);
+  if (cached == NULL) {
+    cached = store_query(data->query_cache, key, generation);
+    cached->value = count_authors_with_field(data, institution, postings);
+  }
+
+  free(key);
+  return cached->value;
+}
+
 /* ------------------  Task 8  ---------------------------------*/
-int *get_histogram_of_citations(PublData *data, const int64_t id_author,
-                                int *num_years) {
+static int *compute_histogram(PublData *data, Author_Entry *postings,
+                              int *num_years) {
   // Initializing variables
   int *histogram = calloc(INITIAL_HISTOGRAM_SIZE,
                           sizeof(int));  // realloc la nevoie cu smart memsert
@@ -499,40 +1443,59 @@ int *get_histogram_of_citations(PublData *data, const int64_t id_author,
   *num_years = INITIAL_HISTOGRAM_SIZE;
   int min_year = MAX_YEAR;
 
-  Authors_HT *ht = data->authors_ht;
-  unsigned int hash = ht->hash_function(&id_author) % ht->hmax;
-  struct Node *curr = ht->buckets[hash].head;
-
-  while (curr) {
-    authors_paper *publication = (authors_paper *)curr->data;
-    if (ht->compare_function(publication->author_id, &id_author) == 0) {
-      if (publication->paper_year < min_year) {
-        // Updating minimum year
-        min_year = publication->paper_year;
-        // Updating num_years (histogram size)
-        int prev_size = *num_years;
-        *num_years = CURR_YEAR - min_year + 1;
-
-        // Resizing histogram
-        histogram = realloc(histogram, *num_years * sizeof(int));
-        DIE(histogram == NULL, "histogram realloc");
-
-        // Memsetting new counts
-        memset(histogram + prev_size, 0,
-               (*num_years - prev_size) * sizeof(int));
-      }
-      // Adding current paper's citations in its bin
-      int bin = CURR_YEAR - publication->paper_year;
-      int no_citations =
-          get_no_citations(data->citations_ht, publication->paper_id);
-      histogram[bin] += no_citations;
+  int i;
+  Authored_List *author_papers = postings ? &postings->papers : NULL;
+
+  for (i = 0; author_papers && i < author_papers->size; i++) {
+    authors_paper *publication = &author_papers->items[i];
+    if (data->papers[publication->paper_idx] == NULL) {
+      continue;
+    }
+    if (publication->paper_year < min_year) {
+      // Updating minimum year
+      min_year = publication->paper_year;
+      // Updating num_years (histogram size)
+      int prev_size = *num_years;
+      *num_years = CURR_YEAR - min_year + 1;
+
+      // Resizing histogram
+      histogram = realloc(histogram, *num_years * sizeof(int));
+      DIE(histogram == NULL, "histogram realloc");
+
+      // Memsetting new counts
+      memset(histogram + prev_size, 0,
+             (*num_years - prev_size) * sizeof(int));
     }
-    curr = curr->next;
+    // Adding current paper's citations in its bin
+    int bin = CURR_YEAR - publication->paper_year;
+    histogram[bin] += data->columns->citations[publication->paper_idx];
   }
 
   return histogram;
 }
 
+int *get_histogram_of_citations(PublData *data, const int64_t id_author,
+                                int *num_years) {
+  Author_Entry *postings = find_author(data->authors, id_author);
+  uint64_t generation = postings ? postings->generation : 0;
+  char *key = make_query_key("get_histogram_of_citations %" PRId64, id_author);
+
+  cached_query *cached = lookup_query(data->query_cache, key, generation);
+  if (cached == NULL) {
+    cached = store_query(data->query_cache, key, generation);
+    cached->histogram = compute_histogram(data, postings, &cached->value);
+  }
+
+  // The caller owns (and frees) its copy
+  *num_years = cached->value;
+  int *histogram = malloc(*num_years * sizeof(int));
+  DIE(histogram == NULL, "histogram malloc");
+  memcpy(histogram, cached->histogram, *num_years * sizeof(int));
+
+  free(key);
+  return histogram;
+}
+
 char **get_reading_order(PublData *data, const int64_t id_paper,
                          const int distance, int *num_papers) {
   /* TODO: implement get_reading_order */
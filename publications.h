@@ -3,45 +3,116 @@
 #ifndef PUBLICATIONS_H_
 #define PUBLICATIONS_H_
 
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 
-typedef struct author {
-  char *name;
-  int64_t id;
-  char *org;
-} Author;
+#include "./AuthorRegistry.h"
+#include "./Columns.h"
+#include "./EdgeList.h"
+#include "./Hashtables.h"
 
-struct paper {
+#define PAPER_SLAB_SIZE 4096
+#define CACHE_LINE 64
+
+/* Cold part of a paper - only needed for output and on removal */
+typedef struct paper_info {
   char *title;
   char *venue;
-  int year;
-  Author **authors;
+  Paper_Author *authors;  // Entries of PublData->authors, with institutions
   int num_authors;
   char **fields;
   int num_fields;
+  int spilled;  // The strings live in PublData->cold_store
+  Edge_List references;  // IDs of the papers it references (sorted)
+  Edge_List refs;  // The added ones among them, as dense IDs (task 1)
+} Paper_Info;
+
+/*
+ * Hot part of a paper - what the traversals and comparisons touch, kept
+ * small and stored contiguously by dense ID (PublData->paper_slabs), one
+ * cache line per record
+ */
+struct paper {
+  _Alignas(CACHE_LINE) int year;
+  int idx;  // Dense ID - position in PublData->papers / PublData->stats
   int64_t id;
-  int64_t *references;
-  int num_refs;
 
-  int ok;  // "Visited" mark
-  int citations;
-  int distance;  // Distance to the origin :)
+  // Papers that reference it, as dense IDs (only the ones that were added)
+  Edge_List influenced;
+
+  Paper_Info *info;
 };
 
+_Static_assert(sizeof(struct paper) == CACHE_LINE,
+               "a hot paper record must fit in one cache line");
+
+/*
+ * Per-paper counters, kept up to date by add_paper
+ * (the citation count lives in PublData->columns)
+ */
+typedef struct paper_stats {
+  int in_degree;  // Added papers that reference it
+  int out_degree;  // Its references that were added
+} Paper_Stats;
+
 struct publications_data {
-  struct LinkedList **buckets;
-  int hmax;
-  unsigned int (*hash_function)(void *);
-  int (*compare_function)(void *, void *);
+  struct Papers_HT *papers_ht;
+
+  // Indexed by dense ID
+  struct paper **papers;  // NULL for removed papers
+  struct paper **paper_slabs;  // The hot records, PAPER_SLAB_SIZE per slab
+  int num_slabs;
+  Paper_Stats *stats;
+  struct Paper_Columns *columns;
+  int num_papers;
+  int cap_papers;
+  int num_venues;
 
   struct Citations_HT *citations_ht;
   struct Venue_HT *venue_ht;
   struct Field_HT *field_ht;
-  struct Authors_HT *authors_ht;
-  struct Influence_HT *influence_ht;
-  struct Markings_HT *markings_ht;
+  struct Author_Registry *authors;
+  struct Pending_HT *pending_ht;
+
+  /*
+   * Generations - a cached query result is valid only as long as the
+   * generation it was computed from did not change:
+   * venues / fields / authors - in their Venue_HT / Field_HT values and
+   * Author_Registry entries; papers linked by citations - per region
+   * (union-find)
+   */
+  uint64_t clock;
+  uint64_t papers_generation;
+  int *region_parent;
+  uint64_t *region_generation;
+  struct Query_Cache *query_cache;
+
+  // Workers of the parallel BFS (started on first use)
+  struct Thread_Pool *bfs_pool;
+  int serial_bfs;  // Set when the parallelism is across queries instead
+
+  // Visited marks of the searches (see Traversal_Scratch)
+  struct Traversal_Scratch *scratch;
+
+  // Bloom filter of the added IDs, checked before papers_ht
+  struct Paper_Filter *paper_filter;
+
+  // Approximate influence counts (NULL unless enabled)
+  struct Influence_Sketches *sketches;
+
+  // Exact influence counts of the hubs (NULL unless enabled)
+  struct Hub_Counts *hub_counts;
+
+  // Citations by venue & year, for the windowed impact factors
+  struct Citation_Years *citation_years;
+
+  // Scores of the last rank_influence (NULL before it)
+  struct Influence_Ranks *influence_ranks;
+
+  // File-backed cold strings (NULL unless enabled)
+  struct Cold_Store *cold_store;
 };
 
 /**
@@ -79,11 +150,9 @@ typedef struct publications_data PublData;
  * Initialising INFO element when added
  * All values MEMSETED
  */
-void init_info(Paper *publication, const char *title, const char *venue,
-               const int year, const char **author_names,
-               const int64_t *author_ids, const char **institutions,
-               const int num_authors, const char **fields, const int num_fields,
-               int64_t id, const int64_t *references, const int num_refs);
+void init_info(Paper *publication, const int num_authors,
+               const int num_fields, const int64_t *references,
+               const int num_refs);
 
 /**
  * Initialises all the fields contained in the PublData structure.
@@ -125,6 +194,60 @@ void add_paper(PublData *data, const char *title, const char *venue,
                const int num_authors, const char **fields, const int num_fields,
                const int64_t id, const int64_t *references, const int num_refs);
 
+/**
+ * Removes a paper from the collection of known publications.
+ * Every auxiliary structure is updated incrementally (in time proportional
+ * to the paper's number of authors, fields and citation edges); the papers
+ * citing it wait for it again, as if it was never added.
+ *
+ * @param data  the data structure implemented by you
+ * @param id    the id of the paper to remove; unknown ids are ignored
+ */
+void remove_paper(PublData *data, const int64_t id);
+
+/**
+ * Replaces the paper with the given id (or adds it, if it is unknown).
+ * Same parameters as add_paper.
+ */
+void update_paper(PublData *data, const char *title, const char *venue,
+                  const int year, const char **author_names,
+                  const int64_t *author_ids, const char **institutions,
+                  const int num_authors, const char **fields,
+                  const int num_fields, const int64_t id,
+                  const int64_t *references, const int num_refs);
+
+/**
+ * Counts the papers whose attribute in the given column lies in
+ * [low, high] (vectorized scan over all the papers; only the live ones -
+ * added and not removed - are counted, whatever the range).
+ *
+ * @param data    the data structure implemented by you
+ * @param column  COLUMN_YEAR, COLUMN_VENUE, COLUMN_CITATIONS or
+ *                COLUMN_NUM_AUTHORS
+ * @return        the number of matching papers
+ */
+int64_t count_papers_in_range(PublData *data, Paper_Column column,
+                              int32_t low, int32_t high);
+
+/**
+ * Sums a column over the live papers whose attribute in another column lies in
+ * [low, high] - e.g. the citations of the papers of a venue, or of the ones
+ * published between two years.
+ *
+ * @param data      the data structure implemented by you
+ * @param summed    the column being summed
+ * @param filtered  the column the range applies to
+ * @return          the sum
+ */
+int64_t sum_papers_in_range(PublData *data, Paper_Column summed,
+                            Paper_Column filtered, int32_t low, int32_t high);
+
+/**
+ * The dense ID of a venue, as stored in COLUMN_VENUE (NO_VENUE if it has no
+ * papers).
+ */
+int32_t get_venue_column_id(PublData *data, const char *venue);
+
 /**
  * Computes the title of the oldest paper that has influenced the one with the
  * given id.
@@ -135,6 +258,38 @@ void add_paper(PublData *data, const char *title, const char *venue,
  */
 char *get_oldest_influence(PublData *data, const int64_t id_paper);
 
+/**
+ * Limit for a traversal query (tasks 1 and 3): a deadline and / or a flag
+ * another thread sets to cancel it. The search checks it in between levels -
+ * a level in progress is finished first - and, once it is reached, stops
+ * and returns what it found so far.
+ */
+typedef struct query_limit {
+  int64_t deadline_ns;  // CLOCK_MONOTONIC (see query_deadline), 0 - none
+  atomic_int *cancelled;  // NULL - none
+} Query_Limit;
+
+/**
+ * The deadline timeout_ms from now, for Query_Limit->deadline_ns.
+ */
+int64_t query_deadline(int64_t timeout_ms);
+
+/**
+ * 1 if the query has to stop (NULL - never).
+ */
+int query_limit_reached(const Query_Limit *limit);
+
+/**
+ * get_oldest_influence under a limit.
+ *
+ * @param limit     NULL - none (same as get_oldest_influence)
+ * @param complete  set to 0 if the search was stopped - the answer is then
+ *                  the oldest influence among the papers reached so far
+ *                  (may be NULL)
+ */
+char *get_oldest_influence_limited(PublData *data, const int64_t id_paper,
+                                   const Query_Limit *limit, int *complete);
+
 /**
  * Calculates the impact factor of the given venue.
  * The impact factor is defined as the average number of citations per paper
@@ -146,6 +301,24 @@ char *get_oldest_influence(PublData *data, const int64_t id_paper);
  */
 float get_venue_impact_factor(PublData *data, const char *venue);
 
+/**
+ * The N-year impact factor of the given venue, in the given year: the
+ * citations made in `year` (by papers published that year) to the venue's
+ * papers published in [year - num_years, year - 1], divided by the number of
+ * those papers - e.g. num_years = 2 or 5 for the usual 2- / 5-year impact
+ * factors. Two prefix sums over the citation counts by year (see
+ * CitationYears.h).
+ *
+ * @param data          the data structure implemented by you
+ * @param venue         the name of the venue the query is performed on
+ * @param year          the year the citations are made in
+ * @param num_years     the publication years counted, before `year`
+ * @return              the desired impact factor, 0 if the venue published
+ *                      nothing in the window
+ */
+float get_venue_impact_factor_window(PublData *data, const char *venue,
+                                     const int year, const int num_years);
+
 /**
  * Calculates the number of papers that the given paper has influenced, up to
  * a certain distance.
@@ -159,6 +332,146 @@ float get_venue_impact_factor(PublData *data, const char *venue);
 int get_number_of_influenced_papers(PublData *data, const int64_t id_paper,
                                     const int max_dist);
 
+/**
+ * get_number_of_influenced_papers under a limit.
+ *
+ * @param limit     NULL - none (same as get_number_of_influenced_papers)
+ * @param complete  set to 0 if the search was stopped - the answer is then
+ *                  a lower bound, the papers found up to the last level
+ *                  searched (may be NULL)
+ */
+int get_number_of_influenced_papers_limited(PublData *data,
+                                            const int64_t id_paper,
+                                            const int max_dist,
+                                            const Query_Limit *limit,
+                                            int *complete);
+
+/**
+ * Batch version of get_number_of_influenced_papers, for many sources at once:
+ * results[i] = get_number_of_influenced_papers(data, ids[i], max_dists[i]).
+ * The searches run 64 at a time, one bit of a machine word each (multi-source
+ * BFS), so a paper reached by many of them is expanded once per 64 queries.
+ *
+ * @param data          the data structure implemented by you
+ * @param ids           the ids of the papers the queries are performed on
+ * @param max_dists     the maximum distance of influence, per query
+ * @param num_queries   the number of queries
+ * @param results       the function writes the answers here (num_queries)
+ */
+void get_number_of_influenced_papers_batch(PublData *data, const int64_t *ids,
+                                           const int *max_dists,
+                                           int num_queries, int *results);
+
+/**
+ * Turns on the memory-bounded mode: the cold strings (titles, venues, fields,
+ * author names & institutions) are appended to a memory-mapped file instead
+ * of the heap, and only the pages being read stay resident. IDs, years,
+ * counters and edges stay in memory. The file is deleted by destroy_publ_data.
+ * Must be called before the first add_paper.
+ *
+ * @param data  the data structure implemented by you
+ * @param path  the file to create (truncated if it exists)
+ * @return      0 on success, -1 if papers were already added or the file
+ *              cannot be created / mapped
+ */
+int enable_cold_store(PublData *data, const char *path);
+
+/**
+ * Turns on the materialized counts of get_number_of_influenced_papers for the
+ * hubs: papers cited by at least min_degree added papers keep their answers
+ * for every distance up to max_dist, so their queries are lookups. Once
+ * something in its region of the graph changes, a hub's queries search as
+ * usual until refresh_hub_counts recounts it (one BFS for all the distances).
+ *
+ * @param data          the data structure implemented by you
+ * @param max_dist      the biggest distance kept
+ * @param min_degree    the citers that make a paper a hub
+ */
+void enable_hub_counts(PublData *data, const int max_dist,
+                       const int min_degree);
+
+/**
+ * Writer side - recounts all the stale hubs at once, after a batch of
+ * changes (queries never do). publish_snapshot does it for both replicas,
+ * the query server before the queries that follow a change.
+ */
+void refresh_hub_counts(PublData *data);
+
+/**
+ * Turns on the approximate mode of get_number_of_influenced_papers: every
+ * paper gets a HyperLogLog sketch of the papers it influenced, for each
+ * distance up to max_dist, built now and kept up to date by add_paper.
+ * Memory: max_dist * 2^precision bytes per paper.
+ *
+ * @param data          the data structure implemented by you
+ * @param max_dist      the biggest distance answered approximately
+ * @param precision     log2 of the registers per sketch, in [4, 16]; the
+ *                      relative standard error is 1.04 / sqrt(2^precision)
+ *                      (e.g. 6 => 13%, 8 => 6.5%, 10 => 3.3%)
+ */
+void enable_influence_sketches(PublData *data, const int max_dist,
+                               const int precision);
+
+/**
+ * Estimate of get_number_of_influenced_papers, in O(2^precision) time.
+ * Falls back to the exact search if the sketches are not enabled or max_dist
+ * is bigger than the one they were enabled with, or if a paper was removed
+ * since the last refresh_influence_sketches. Never changes the data.
+ * Papers on a citation cycle may count themselves (+1).
+ */
+int get_approx_number_of_influenced_papers(PublData *data,
+                                           const int64_t id_paper,
+                                           const int max_dist);
+
+/**
+ * Writer side - rebuilds the sketches if a paper was removed since the last
+ * rebuild (HyperLogLog cannot forget one). Call it after a batch of
+ * changes; publish_snapshot does it for both replicas.
+ */
+void refresh_influence_sketches(PublData *data);
+
+/**
+ * Relative standard error of the approximate mode, 1.04 / sqrt(2^precision)
+ * (about 68% of the estimates are within it, 95% within twice it); 0 if the
+ * mode is not enabled.
+ */
+float get_approx_influence_error(PublData *data);
+
+/**
+ * Computes a PageRank-style influence score for every paper: each paper
+ * passes a `damping` part of its score on to the papers it references, in
+ * equal parts, the rest being spread evenly over all the papers. The
+ * iterations run on the BFS thread pool (for big graphs), until the scores
+ * change by less than `tolerance` in total (L1) or max_iterations are done.
+ * The scores are kept until the next call; papers added since have none.
+ * Writes into data - not for the readers of a snapshot / executor view.
+ *
+ * @param data              the data structure implemented by you
+ * @param damping           in [0, 1), usually 0.85
+ * @param tolerance         e.g. 1e-6 (the scores add up to 1)
+ * @param max_iterations    the most iterations to run
+ * @return                  the iterations done, -1 if the arguments are wrong
+ */
+int rank_influence(PublData *data, const double damping,
+                   const double tolerance, const int max_iterations);
+
+/**
+ * The score of a paper from the last rank_influence; 0 if it was not added
+ * back then (or not ranked at all).
+ */
+double get_influence_rank(PublData *data, const int64_t id_paper);
+
+/**
+ * The IDs of the papers with the best scores from the last rank_influence,
+ * best first (equal scores by ID).
+ *
+ * @param data          the data structure implemented by you
+ * @param num_papers    the number of papers wanted; the function writes the
+ *                      number of returned papers in this variable
+ * @return              a new array with their IDs (NULL if none)
+ */
+int64_t *get_most_influential_papers(PublData *data, int *num_papers);
+
 /**
  * Calculates the Erdős distance between two authors.
  *
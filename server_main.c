@@ -0,0 +1,100 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "./QueryServer.h"
+#include "./WriteAheadLog.h"
+#include "./publications.h"
+
+/*
+ * Daemon mode:
+ *   publications_server [-l <log dir>] [-p <processes>] [-t <timeout ms>]
+ *                       <socket> [command file]
+ * Recovers the changes logged in the log dir (if given), runs the command
+ * file (the initial load) once, then answers over the socket until
+ * SIGINT / SIGTERM - from the given number of read-only worker processes
+ * sharing the data, if any (see serve_queries_forked). Traversal queries
+ * running past the timeout answer partially (see Query_Server).
+ */
+static Query_Server server;
+
+static void on_signal(int signum) {
+  (void)signum;
+  stop_query_server(&server);
+}
+
+static int usage(const char *name) {
+  fprintf(stderr,
+          "Usage: %s [-l <log dir>] [-p <processes>] [-t <timeout ms>] "
+          "<socket> [command file]\n",
+          name);
+  return EXIT_FAILURE;
+}
+
+int main(int argc, char **argv) {
+  const char *log_dir = NULL;
+  int opt, num_processes = 0, timeout_ms = 0;
+
+  while ((opt = getopt(argc, argv, "l:p:t:")) != -1) {
+    if (opt == 'l') {
+      log_dir = optarg;
+    } else if (opt == 'p' && atoi(optarg) > 0) {
+      num_processes = atoi(optarg);
+    } else if (opt == 't' && atoi(optarg) > 0) {
+      timeout_ms = atoi(optarg);
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (optind >= argc) {
+    return usage(argv[0]);
+  }
+
+  PublData *data = init_publ_data();
+  if (init_query_server(&server, data, argv[optind], 0) < 0) {
+    perror(argv[optind]);
+    destroy_publ_data(data);
+    return EXIT_FAILURE;
+  }
+
+  server.query_timeout_ms = timeout_ms;
+
+  if (log_dir) {
+    server.wal = open_write_ahead_log(log_dir, data);
+    if (server.wal == NULL) {
+      perror(log_dir);
+      free_query_server(&server);
+      destroy_publ_data(data);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (optind + 1 < argc) {
+    FILE *in = fopen(argv[optind + 1], "r");
+    DIE(in == NULL, argv[optind + 1]);
+    load_commands(&server, in);
+    fclose(in);
+  }
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = on_signal;
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+
+  if (num_processes) {
+    serve_queries_forked(&server, num_processes);
+  } else {
+    serve_queries(&server);
+  }
+
+  close_write_ahead_log(server.wal);
+  free_query_server(&server);
+  destroy_publ_data(data);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+/*
+ * Randomized test of get_number_of_influenced_papers_batch (see
+ * publications.h)
+ * Random citation graphs (with some papers removed again) get batches of
+ * random sizes, many of them over the 64 searches of a group, mixing sources
+ * that were never added or were removed, max_dist 0 and the same source
+ * repeated (with the same or other distances). Every answer must be the one
+ * of a single get_number_of_influenced_papers call.
+ *
+ * Usage: batch_model [rounds] [seed]  - exits with 1 on the first mismatch
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../publications.h"
+
+#define MAX_BATCH 300
+#define MAX_REFS 5
+
+static unsigned int seed;
+
+static int rnd(int n) {
+  seed = seed * 1103515245u + 12345u;
+  return (seed >> 8) % n;
+}
+
+static PublData *random_graph(int num_papers) {
+  PublData *data = init_publ_data();
+  const char *names[1] = {"A"}, *institutions[1] = {"I"}, *fields[1] = {"F"};
+  int64_t author_ids[1] = {1}, references[MAX_REFS];
+  int i, j;
+
+  for (i = 0; i < num_papers; i++) {
+    // Mostly older papers, so the searches go a few levels deep
+    int num_refs = rnd(MAX_REFS + 1);
+    for (j = 0; j < num_refs; j++) {
+      references[j] = i ? rnd(i + 5) : rnd(5);
+    }
+    add_paper(data, "T", "V", 1950 + rnd(70), names, author_ids,
+              institutions, 1, fields, 1, i, references, num_refs);
+  }
+  for (i = 0; i < num_papers / 20; i++) {
+    remove_paper(data, rnd(num_papers));
+  }
+
+  return data;
+}
+
+/* Number of mismatches */
+static int check_batch(PublData *data, int num_papers, int num_queries) {
+  int64_t ids[MAX_BATCH] = {0};
+  int max_dists[MAX_BATCH] = {0}, results[MAX_BATCH];
+  int i, bad = 0;
+
+  for (i = 0; i < num_queries; i++) {
+    int kind = rnd(10);
+    if (kind == 0 && i) {
+      // Same source as an earlier query
+      ids[i] = ids[rnd(i)];
+    } else if (kind == 1) {
+      // Never added
+      ids[i] = num_papers + 100 + rnd(100);
+    } else {
+      ids[i] = rnd(num_papers);
+    }
+    max_dists[i] = rnd(8) ? rnd(7) : 0;
+  }
+
+  get_number_of_influenced_papers_batch(data, ids, max_dists, num_queries,
+                                        results);
+
+  for (i = 0; i < num_queries; i++) {
+    int expected = get_number_of_influenced_papers(data, ids[i], max_dists[i]);
+    if (results[i] != expected) {
+      fprintf(stderr, "query %d of %d (%" PRId64 ", %d): %d vs %d\n", i,
+              num_queries, ids[i], max_dists[i], results[i], expected);
+      bad++;
+    }
+  }
+
+  return bad;
+}
+
+int main(int argc, char **argv) {
+  int rounds = argc > 1 ? atoi(argv[1]) : 100;
+  unsigned int first_seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  int round, bad = 0;
+
+  seed = first_seed;
+  for (round = 0; round < rounds && bad == 0; round++) {
+    int num_papers = 50 + rnd(2000);
+    PublData *data = random_graph(num_papers);
+    int batch;
+
+    for (batch = 0; batch < 10 && bad == 0; batch++) {
+      // Half of them over 64 queries (several groups), some empty
+      int num_queries = rnd(2) ? 65 + rnd(MAX_BATCH - 64) : rnd(65);
+      bad = check_batch(data, num_papers, num_queries);
+    }
+
+    destroy_publ_data(data);
+  }
+
+  if (bad) {
+    printf("batch_model: seed %u, round %d - FAILED\n", first_seed, round);
+    return 1;
+  }
+  printf("batch_model: %d rounds - OK\n", rounds);
+  return 0;
+}
@@ -0,0 +1,178 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+/*
+ * Randomized test of the hub counts (see HubCounts.h)
+ * The same random stream of add / update / remove ops - most references
+ * going to a few papers, so they become hubs - goes to a PublData with hub
+ * counts and to a plain one (the model, always searching). After every
+ * batch of changes, before refresh_hub_counts, every task 3 answer must be
+ * the model's: the hubs near a change are stale and must search, not return
+ * their old counts (the test also checks that some old counts were wrong by
+ * then). After the refresh, every hub must be fresh again and its counts,
+ * for every distance, the model's.
+ *
+ * Usage: hubs_model [batches] [seed]  - exits with 1 on the first mismatch
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../HubCounts.h"
+#include "../publications.h"
+#include "../utils.h"
+
+#define NUM_IDS 600
+#define NUM_HOT_IDS 10
+#define OPS_PER_BATCH 30
+#define MAX_DIST 4
+#define MIN_DEGREE 8
+
+static unsigned int seed;
+
+static int rnd(int n) {
+  seed = seed * 1103515245u + 12345u;
+  return (seed >> 8) % n;
+}
+
+static void random_op(PublData *hubbed, PublData *model) {
+  const char *names[1] = {"A"}, *institutions[1] = {"I"}, *fields[1] = {"F"};
+  int64_t author_ids[1] = {1}, references[5];
+  int i;
+
+  int64_t id = rnd(NUM_IDS);
+  int type = rnd(10);
+  if (type == 9) {
+    remove_paper(hubbed, id);
+    remove_paper(model, id);
+    return;
+  }
+
+  int num_refs = rnd(6);
+  for (i = 0; i < num_refs; i++) {
+    references[i] = rnd(2) ? rnd(NUM_HOT_IDS) : rnd(NUM_IDS);
+  }
+
+  int year = 1950 + rnd(70);
+  if (type < 7) {
+    add_paper(hubbed, "T", "V", year, names, author_ids, institutions, 1,
+              fields, 1, id, references, num_refs);
+    add_paper(model, "T", "V", year, names, author_ids, institutions, 1,
+              fields, 1, id, references, num_refs);
+  } else {
+    update_paper(hubbed, "T", "V", year, names, author_ids, institutions, 1,
+                 fields, 1, id, references, num_refs);
+    update_paper(model, "T", "V", year, names, author_ids, institutions, 1,
+                 fields, 1, id, references, num_refs);
+  }
+}
+
+/* Every answer, up to a distance past the counted ones */
+static int compare_answers(PublData *hubbed, PublData *model) {
+  int id, distance, bad = 0;
+
+  for (id = 0; id < NUM_IDS; id++) {
+    for (distance = 1; distance <= MAX_DIST + 1; distance++) {
+      int expected = get_number_of_influenced_papers(model, id, distance);
+      int got = get_number_of_influenced_papers(hubbed, id, distance);
+      if (got != expected) {
+        fprintf(stderr, "paper %d, distance %d: %d vs %d\n", id, distance,
+                got, expected);
+        bad++;
+      }
+    }
+  }
+
+  return bad;
+}
+
+/* Stale hubs whose old counts are not the answers anymore */
+static int count_outdated_hubs(PublData *hubbed, PublData *model) {
+  Hub_Counts *hub_counts = hubbed->hub_counts;
+  int i, distance, outdated = 0;
+
+  for (i = 0; i < hub_counts->num_hubs; i++) {
+    Hub_Entry *hub = &hub_counts->hubs[i];
+    Paper *paper = hubbed->papers[hub->idx];
+    if (paper == NULL || get_hub_entry(hubbed, hub->idx) ||
+        hub->levels < MAX_DIST) {
+      continue;
+    }
+
+    for (distance = 1; distance <= MAX_DIST; distance++) {
+      if (hub->counts[distance - 1] !=
+          get_number_of_influenced_papers(model, paper->id, distance)) {
+        outdated++;
+        break;
+      }
+    }
+  }
+
+  return outdated;
+}
+
+/* After a refresh - every hub fresh, with the model's answers */
+static int check_hubs(PublData *hubbed, PublData *model) {
+  Hub_Counts *hub_counts = hubbed->hub_counts;
+  int i, distance, bad = 0;
+
+  for (i = 0; i < hub_counts->num_hubs; i++) {
+    Hub_Entry *hub = get_hub_entry(hubbed, hub_counts->hubs[i].idx);
+    if (hub == NULL) {
+      fprintf(stderr, "hub %d: stale after the refresh\n",
+              hub_counts->hubs[i].idx);
+      bad++;
+      continue;
+    }
+
+    int64_t id = hubbed->papers[hub->idx]->id;
+    for (distance = 1; distance <= MAX_DIST; distance++) {
+      int expected = get_number_of_influenced_papers(model, id, distance);
+      if (hub->counts[distance - 1] != expected) {
+        fprintf(stderr, "hub %" PRId64 ", distance %d: %d vs %d\n", id,
+                distance, hub->counts[distance - 1], expected);
+        bad++;
+      }
+    }
+  }
+
+  return bad;
+}
+
+int main(int argc, char **argv) {
+  int batches = argc > 1 ? atoi(argv[1]) : 40;
+  unsigned int first_seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  int batch, i, bad = 0, outdated = 0;
+
+  seed = first_seed;
+  PublData *hubbed = init_publ_data();
+  PublData *model = init_publ_data();
+  enable_hub_counts(hubbed, MAX_DIST, MIN_DEGREE);
+
+  for (batch = 0; batch < batches && bad == 0; batch++) {
+    // The first batch builds the graph up
+    for (i = 0; i < OPS_PER_BATCH * (batch ? 1 : 20); i++) {
+      random_op(hubbed, model);
+    }
+
+    outdated += count_outdated_hubs(hubbed, model);
+    bad += compare_answers(hubbed, model);
+
+    refresh_hub_counts(hubbed);
+    bad += check_hubs(hubbed, model);
+    bad += compare_answers(hubbed, model);
+  }
+
+  int num_hubs = hubbed->hub_counts->num_hubs;
+  destroy_publ_data(hubbed);
+  destroy_publ_data(model);
+
+  if (bad || outdated == 0 || num_hubs == 0) {
+    printf("hubs_model: seed %u, batch %d - FAILED (%d hubs, %d outdated)\n",
+           first_seed, batch, num_hubs, outdated);
+    return 1;
+  }
+  printf("hubs_model: %d batches, %d hubs, %d outdated - OK\n", batches,
+         num_hubs, outdated);
+  return 0;
+}
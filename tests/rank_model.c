@@ -0,0 +1,222 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+/*
+ * Randomized test of rank_influence (see InfluenceRank.h)
+ * Random citation graphs - many papers citing nothing (dangling), references
+ * to papers never added, papers removed again, sometimes none left - are
+ * ranked and checked against a plain power iteration over the same graph:
+ * every score must be the same (up to the tolerance), the scores must add up
+ * to 1 and get_most_influential_papers must list the papers in the order of
+ * a full sort of the scores (best first, equal ones by ID), for any k.
+ * One graph is big enough for several row chunks and citing blocks.
+ *
+ * Usage: rank_model [rounds] [seed]  - exits with 1 on the first mismatch
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../InfluenceRank.h"
+#include "../publications.h"
+
+#define MAX_REFS 4
+#define DAMPING 0.85
+#define TOLERANCE 1e-13
+#define MAX_ITERATIONS 1000
+#define MAX_ERROR 1e-9
+#define BIG_GRAPH (3 * RANK_BLOCK)
+
+static unsigned int seed;
+
+static int rnd(int n) {
+  seed = seed * 1103515245u + 12345u;
+  return (seed >> 8) % n;
+}
+
+typedef struct model_graph {
+  int n;
+  char *live;
+  int *num_refs;
+  int64_t (*refs)[MAX_REFS];
+} Model_Graph;
+
+static PublData *random_graph(Model_Graph *graph, int n) {
+  const char *names[1] = {"A"}, *institutions[1] = {"I"}, *fields[1] = {"F"};
+  int64_t author_ids[1] = {1};
+  int i, j;
+
+  graph->n = n;
+  graph->live = calloc(n + 1, sizeof(char));
+  graph->num_refs = calloc(n + 1, sizeof(int));
+  graph->refs = calloc(n + 1, sizeof(*graph->refs));
+
+  // In random order, so some references resolve only later (Pending_HT)
+  PublData *data = init_publ_data();
+  for (i = 0; i < n; i++) {
+    int64_t id = rnd(n);
+    if (graph->live[id]) {
+      continue;
+    }
+
+    graph->live[id] = 1;
+    graph->num_refs[id] = rnd(3) ? rnd(MAX_REFS + 1) : 0;
+    for (j = 0; j < graph->num_refs[id]; j++) {
+      graph->refs[id][j] = rnd(n + n / 10 + 1);
+    }
+    add_paper(data, "T", "V", 2000, names, author_ids, institutions, 1,
+              fields, 1, id, graph->refs[id], graph->num_refs[id]);
+  }
+
+  // Every tenth graph loses all of its papers
+  int remove_all = rnd(10) == 0;
+  for (i = 0; i < (remove_all ? n : n / 10); i++) {
+    int64_t id = remove_all ? i : rnd(n);
+    graph->live[id] = 0;
+    remove_paper(data, id);
+  }
+
+  return data;
+}
+
+/* Plain power iteration, by ID: every reference to a live paper is an edge */
+static double *model_ranks(Model_Graph *graph) {
+  double *rank = calloc(graph->n + 1, sizeof(double));
+  double *next = calloc(graph->n + 1, sizeof(double));
+  int *out_degree = calloc(graph->n + 1, sizeof(int));
+  int i, j, n = 0, iteration;
+
+  for (i = 0; i < graph->n; i++) {
+    for (j = 0; graph->live[i] && j < graph->num_refs[i]; j++) {
+      int64_t cited = graph->refs[i][j];
+      out_degree[i] += cited < graph->n && graph->live[cited];
+    }
+    n += graph->live[i];
+  }
+  for (i = 0; i < graph->n; i++) {
+    rank[i] = graph->live[i] ? 1.0 / n : 0;
+  }
+
+  for (iteration = 0; n && iteration < MAX_ITERATIONS; iteration++) {
+    double dangling = 0, change = 0;
+
+    for (i = 0; i < graph->n; i++) {
+      dangling += graph->live[i] && !out_degree[i] ? rank[i] : 0;
+    }
+    for (i = 0; i < graph->n; i++) {
+      next[i] = graph->live[i] ? (1 - DAMPING) / n + DAMPING * dangling / n
+                               : 0;
+    }
+    for (i = 0; i < graph->n; i++) {
+      for (j = 0; graph->live[i] && j < graph->num_refs[i]; j++) {
+        int64_t cited = graph->refs[i][j];
+        if (cited < graph->n && graph->live[cited]) {
+          next[cited] += DAMPING * rank[i] / out_degree[i];
+        }
+      }
+    }
+
+    for (i = 0; i < graph->n; i++) {
+      change += fabs(next[i] - rank[i]);
+      rank[i] = next[i];
+    }
+    if (change < TOLERANCE) {
+      break;
+    }
+  }
+
+  free(next);
+  free(out_degree);
+  return rank;
+}
+
+static double *scores;  // For the full sort
+
+static int compare_ids(const void *a, const void *b) {
+  int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+
+  if (scores[x] != scores[y]) {
+    return scores[x] < scores[y] ? 1 : -1;
+  }
+  return (x > y) - (x < y);
+}
+
+/* Number of mismatches */
+static int check_ranks(PublData *data, Model_Graph *graph) {
+  double *expected = model_ranks(graph);
+  int64_t *sorted = malloc((graph->n + 1) * sizeof(int64_t));
+  double sum = 0;
+  int i, n = 0, bad = 0;
+
+  scores = calloc(graph->n + 1, sizeof(double));
+  for (i = 0; i < graph->n; i++) {
+    scores[i] = get_influence_rank(data, i);
+    sum += scores[i];
+    if (fabs(scores[i] - expected[i]) > MAX_ERROR) {
+      fprintf(stderr, "paper %d: %g vs %g\n", i, scores[i], expected[i]);
+      bad++;
+    }
+    if (graph->live[i]) {
+      sorted[n++] = i;
+    }
+  }
+  if (n && fabs(sum - 1) > MAX_ERROR) {
+    fprintf(stderr, "%d papers: the scores add up to %.12f\n", n, sum);
+    bad++;
+  }
+
+  // The top k, for a few k (past the number of papers, too)
+  qsort(sorted, n, sizeof(int64_t), compare_ids);
+  int wanted[] = {1, 2, 10, n / 2, n, n + 5};
+  for (i = 0; i < (int)(sizeof(wanted) / sizeof(wanted[0])); i++) {
+    int k = wanted[i];
+    int64_t *top = get_most_influential_papers(data, &k);
+    int expected_k = wanted[i] < n ? wanted[i] : n;
+    if (k != expected_k || (k && memcmp(top, sorted, k * sizeof(int64_t))) ||
+        (k == 0 && top != NULL)) {
+      fprintf(stderr, "top %d of %d: different papers\n", wanted[i], n);
+      bad++;
+    }
+    free(top);
+  }
+
+  free(expected);
+  free(sorted);
+  free(scores);
+  return bad;
+}
+
+int main(int argc, char **argv) {
+  int rounds = argc > 1 ? atoi(argv[1]) : 30;
+  unsigned int first_seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  int round, bad = 0;
+
+  seed = first_seed;
+  for (round = 0; round < rounds && bad == 0; round++) {
+    // An empty graph first, a big one last
+    int n = round == rounds - 1 ? BIG_GRAPH : rnd(3000) * (round > 0);
+    Model_Graph graph;
+    PublData *data = random_graph(&graph, n);
+
+    if (rank_influence(data, DAMPING, TOLERANCE, MAX_ITERATIONS) < 0) {
+      fprintf(stderr, "rank_influence failed\n");
+      bad++;
+    } else {
+      bad += check_ranks(data, &graph);
+    }
+
+    destroy_publ_data(data);
+    free(graph.live);
+    free(graph.num_refs);
+    free(graph.refs);
+  }
+
+  if (bad) {
+    printf("rank_model: seed %u, round %d - FAILED\n", first_seed, round);
+    return 1;
+  }
+  printf("rank_model: %d rounds - OK\n", rounds);
+  return 0;
+}
@@ -0,0 +1,397 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+/*
+ * Randomized test of remove_paper / update_paper (see publications.h)
+ * A random stream of add / update / remove ops goes to a PublData. Every
+ * CHECK_EVERY steps, a fresh PublData gets only the live papers (in the order
+ * they were last added) and every index of the first one must match it: the
+ * venue, field and author postings, the edges waiting in Pending_HT, the
+ * citations carried over in Citations_HT and, per paper, the columns, the
+ * degrees and the resolved edges. Dense IDs differ between the two, so
+ * everything is compared by paper ID.
+ *
+ * Usage: remove_model [steps] [seed]  - exits with 1 on the first mismatch
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../publications.h"
+#include "../utils.h"
+
+#define CHECK_EVERY 100
+#define MAX_REFS 6
+
+static unsigned int seed;
+
+static int rnd(int n) {
+  seed = seed * 1103515245u + 12345u;
+  return (seed >> 8) % n;
+}
+
+/* What the test remembers about a paper ID */
+typedef struct model_paper {
+  int live;
+  int order;  // Step of its last add
+  char title[32], venue[16], fields[2][16], names[2][16], institutions[2][16];
+  int year, num_fields, num_refs;
+  int64_t author_ids[2], references[MAX_REFS];
+} Model_Paper;
+
+static void random_paper(Model_Paper *paper, int64_t id, int num_ids,
+                         int step) {
+  int i;
+
+  sprintf(paper->title, "T%" PRId64 "_%d", id, step);
+  sprintf(paper->venue, "V%d", rnd(7));
+  paper->year = 1950 + rnd(70);
+  paper->num_fields = 1 + rnd(2);
+  for (i = 0; i < paper->num_fields; i++) {
+    sprintf(paper->fields[i], "F%d", rnd(5));
+  }
+  for (i = 0; i < 2; i++) {
+    paper->author_ids[i] = rnd(30);
+    sprintf(paper->names[i], "A%" PRId64, paper->author_ids[i]);
+    sprintf(paper->institutions[i], "I%d", rnd(4));
+  }
+
+  // A few references to IDs that never get added, too
+  paper->num_refs = rnd(MAX_REFS + 1);
+  for (i = 0; i < paper->num_refs; i++) {
+    paper->references[i] = rnd(num_ids + 10);
+  }
+}
+
+static void add_model_paper(PublData *data, Model_Paper *paper, int64_t id,
+                            int update) {
+  const char *names[2] = {paper->names[0], paper->names[1]};
+  const char *institutions[2] = {paper->institutions[0],
+                                 paper->institutions[1]};
+  const char *fields[2] = {paper->fields[0], paper->fields[1]};
+
+  if (update) {
+    update_paper(data, paper->title, paper->venue, paper->year, names,
+                 paper->author_ids, institutions, 2, fields,
+                 paper->num_fields, id, paper->references, paper->num_refs);
+  } else {
+    add_paper(data, paper->title, paper->venue, paper->year, names,
+              paper->author_ids, institutions, 2, fields, paper->num_fields,
+              id, paper->references, paper->num_refs);
+  }
+}
+
+static int compare_int64(const void *a, const void *b) {
+  int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+  return (x > y) - (x < y);
+}
+
+/* IDs of the live papers among the dense IDs, sorted (n is updated) */
+static int64_t *live_ids(PublData *data, const int *idx, int *n) {
+  int64_t *ids = malloc((*n ? *n : 1) * sizeof(int64_t));
+  int i, num_ids = 0;
+
+  for (i = 0; i < *n; i++) {
+    if (data->papers[idx[i]]) {
+      ids[num_ids++] = data->papers[idx[i]]->id;
+    }
+  }
+  qsort(ids, num_ids, sizeof(int64_t), compare_int64);
+  *n = num_ids;
+
+  return ids;
+}
+
+/* 1 if the live IDs of the two dense ID lists differ */
+static int differ(PublData *data, const int *idx, int n, PublData *fresh,
+                  const int *fresh_idx, int fresh_n) {
+  int64_t *ids = live_ids(data, idx, &n);
+  int64_t *fresh_ids = live_ids(fresh, fresh_idx, &fresh_n);
+  int result = n != fresh_n || memcmp(ids, fresh_ids, n * sizeof(int64_t));
+
+  free(ids);
+  free(fresh_ids);
+
+  return result;
+}
+
+/* Same, for edge lists */
+static int edges_differ(PublData *data, const Edge_List *list,
+                        PublData *fresh, const Edge_List *fresh_list) {
+  int *idx = malloc((list->size ? list->size : 1) * sizeof(int));
+  int *fresh_idx =
+      malloc((fresh_list->size ? fresh_list->size : 1) * sizeof(int));
+  int n = 0, fresh_n = 0;
+  Edge_Iter it;
+
+  edge_iter_init(&it, list);
+  while (edge_iter_next_idx(&it, &idx[n])) {
+    n++;
+  }
+  edge_iter_init(&it, fresh_list);
+  while (edge_iter_next_idx(&it, &fresh_idx[fresh_n])) {
+    fresh_n++;
+  }
+  int result = differ(data, idx, n, fresh, fresh_idx, fresh_n);
+
+  free(idx);
+  free(fresh_idx);
+
+  return result;
+}
+
+static int check_postings(PublData *data, PublData *fresh) {
+  venue_ht_slot *venue;
+  field_ht_slot *field;
+  int bad = 0;
+
+  HT_FOREACH(data->venue_ht, venue) {
+    Paper_Postings *other = venue_ht_get(fresh->venue_ht, venue->key);
+    if (differ(data, venue->value.papers.items, venue->value.papers.size,
+               fresh, other ? other->papers.items : NULL,
+               other ? other->papers.size : 0)) {
+      fprintf(stderr, "venue %s: different papers\n", venue->key);
+      bad++;
+    }
+  }
+  HT_FOREACH(fresh->venue_ht, venue) {
+    if (!venue_ht_get(data->venue_ht, venue->key)) {
+      fprintf(stderr, "venue %s: missing\n", venue->key);
+      bad++;
+    }
+  }
+
+  HT_FOREACH(data->field_ht, field) {
+    Paper_Postings *other = field_ht_get(fresh->field_ht, field->key);
+    if (differ(data, field->value.papers.items, field->value.papers.size,
+               fresh, other ? other->papers.items : NULL,
+               other ? other->papers.size : 0)) {
+      fprintf(stderr, "field %s: different papers\n", field->key);
+      bad++;
+    }
+  }
+  HT_FOREACH(fresh->field_ht, field) {
+    if (!field_ht_get(data->field_ht, field->key)) {
+      fprintf(stderr, "field %s: missing\n", field->key);
+      bad++;
+    }
+  }
+
+  return bad;
+}
+
+/* Dense IDs of the author's papers (NULL author => none) */
+static int *author_papers(Author_Entry *author, int *n) {
+  *n = author ? author->papers.size : 0;
+  int *idx = malloc((*n ? *n : 1) * sizeof(int));
+  int i;
+
+  for (i = 0; i < *n; i++) {
+    idx[i] = author->papers.items[i].paper_idx;
+  }
+
+  return idx;
+}
+
+static int check_authors(PublData *data, PublData *fresh) {
+  int i, bad = 0;
+
+  for (i = 0; i < data->authors->num_authors; i++) {
+    Author_Entry *author = &data->authors->authors[i];
+    Author_Entry *other = find_author(fresh->authors, author->id);
+    int n, fresh_n;
+    int *idx = author_papers(author, &n);
+    int *fresh_idx = author_papers(other, &fresh_n);
+    if (differ(data, idx, n, fresh, fresh_idx, fresh_n)) {
+      fprintf(stderr, "author %" PRId64 ": different papers\n", author->id);
+      bad++;
+    }
+    free(idx);
+    free(fresh_idx);
+  }
+  for (i = 0; i < fresh->authors->num_authors; i++) {
+    if (!find_author(data->authors, fresh->authors->authors[i].id)) {
+      fprintf(stderr, "author %" PRId64 ": missing\n",
+              fresh->authors->authors[i].id);
+      bad++;
+    }
+  }
+
+  return bad;
+}
+
+/* The edges & citations still waiting for papers that are not added */
+static int check_pending(PublData *data, PublData *fresh) {
+  pending_ht_slot *pending;
+  cit_ht_slot *citations;
+  int bad = 0;
+
+  HT_FOREACH(data->pending_ht, pending) {
+    Idx_List *other = pending_ht_get(fresh->pending_ht, pending->key);
+    if (differ(data, pending->value.items, pending->value.size, fresh,
+               other ? other->items : NULL, other ? other->size : 0)) {
+      fprintf(stderr, "pending %" PRId64 ": different papers\n",
+              pending->key);
+      bad++;
+    }
+  }
+  HT_FOREACH(fresh->pending_ht, pending) {
+    Idx_List *other = pending_ht_get(data->pending_ht, pending->key);
+    if (other == NULL && pending->value.size) {
+      fprintf(stderr, "pending %" PRId64 ": missing\n", pending->key);
+      bad++;
+    }
+  }
+
+  HT_FOREACH(data->citations_ht, citations) {
+    if (citations->value !=
+        get_no_citations(fresh->citations_ht, citations->key)) {
+      fprintf(stderr, "citations of %" PRId64 ": %d vs %d\n",
+              citations->key, citations->value,
+              get_no_citations(fresh->citations_ht, citations->key));
+      bad++;
+    }
+  }
+  HT_FOREACH(fresh->citations_ht, citations) {
+    if (citations->value !=
+        get_no_citations(data->citations_ht, citations->key)) {
+      fprintf(stderr, "citations of %" PRId64 ": missing\n", citations->key);
+      bad++;
+    }
+  }
+
+  return bad;
+}
+
+/* Columns, degrees & resolved edges of one paper */
+static int check_paper(PublData *data, PublData *fresh, int64_t id) {
+  Paper *paper = find_paper_with_id(data, id);
+  Paper *other = find_paper_with_id(fresh, id);
+  int bad = 0;
+
+  if (paper == NULL || other == NULL) {
+    fprintf(stderr, "paper %" PRId64 ": missing\n", id);
+    return 1;
+  }
+
+  int idx = paper->idx, fresh_idx = other->idx;
+  Paper_Columns *columns = data->columns, *fresh_columns = fresh->columns;
+  if (columns->year[idx] != fresh_columns->year[fresh_idx] ||
+      columns->citations[idx] != fresh_columns->citations[fresh_idx] ||
+      columns->num_authors[idx] != fresh_columns->num_authors[fresh_idx] ||
+      columns->venue[idx] !=
+          venue_ht_get(data->venue_ht, paper->info->venue)->id ||
+      strcmp(paper->info->venue, other->info->venue)) {
+    fprintf(stderr, "paper %" PRId64 ": different columns\n", id);
+    bad++;
+  }
+
+  if (data->stats[idx].in_degree != fresh->stats[fresh_idx].in_degree ||
+      data->stats[idx].out_degree != fresh->stats[fresh_idx].out_degree) {
+    fprintf(stderr, "paper %" PRId64 ": degrees %d %d vs %d %d\n", id,
+            data->stats[idx].in_degree, data->stats[idx].out_degree,
+            fresh->stats[fresh_idx].in_degree,
+            fresh->stats[fresh_idx].out_degree);
+    bad++;
+  }
+
+  if (edges_differ(data, &paper->info->refs, fresh, &other->info->refs)) {
+    fprintf(stderr, "paper %" PRId64 ": different refs\n", id);
+    bad++;
+  }
+  if (edges_differ(data, &paper->influenced, fresh, &other->influenced)) {
+    fprintf(stderr, "paper %" PRId64 ": different influenced\n", id);
+    bad++;
+  }
+
+  return bad;
+}
+
+static int compare_order(const void *a, const void *b) {
+  const Model_Paper *x = *(Model_Paper *const *)a;
+  const Model_Paper *y = *(Model_Paper *const *)b;
+  return x->order - y->order;
+}
+
+/* Number of mismatches against a rebuild from the live papers */
+static int check_rebuild(PublData *data, Model_Paper *model, int num_ids) {
+  Model_Paper **live = malloc(num_ids * sizeof(*live));
+  int i, num_live = 0, bad = 0;
+
+  for (i = 0; i < num_ids; i++) {
+    if (model[i].live) {
+      live[num_live++] = &model[i];
+    }
+  }
+  qsort(live, num_live, sizeof(*live), compare_order);
+
+  PublData *fresh = init_publ_data();
+  for (i = 0; i < num_live; i++) {
+    add_model_paper(fresh, live[i], live[i] - model, 0);
+  }
+
+  for (i = 0; i < num_ids; i++) {
+    if (model[i].live) {
+      bad += check_paper(data, fresh, i);
+    } else if (find_paper_with_id(data, i)) {
+      fprintf(stderr, "paper %d: should be removed\n", i);
+      bad++;
+    }
+  }
+  bad += check_postings(data, fresh);
+  bad += check_authors(data, fresh);
+  bad += check_pending(data, fresh);
+
+  destroy_publ_data(fresh);
+  free(live);
+
+  return bad;
+}
+
+int main(int argc, char **argv) {
+  int steps = argc > 1 ? atoi(argv[1]) : 3000;
+  unsigned int first_seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  int num_ids = steps / 4 + 10;
+  int step, bad = 0;
+
+  seed = first_seed;
+  PublData *data = init_publ_data();
+  Model_Paper *model = calloc(num_ids, sizeof(Model_Paper));
+
+  for (step = 0; step < steps && bad == 0; step++) {
+    int64_t id = rnd(num_ids);
+    int type = rnd(10);
+    Model_Paper *paper = &model[id];
+
+    if (type >= 8) {
+      remove_paper(data, id);
+      paper->live = 0;
+    } else if (type >= 6 || !paper->live) {
+      // An update of an unknown ID adds it
+      random_paper(paper, id, num_ids, step);
+      add_model_paper(data, paper, id, type >= 6);
+      paper->live = 1;
+      paper->order = step;
+    } else {
+      // Already added => ignored
+      Model_Paper ignored;
+      random_paper(&ignored, id, num_ids, step);
+      add_model_paper(data, &ignored, id, 0);
+    }
+
+    if ((step + 1) % CHECK_EVERY == 0 || step == steps - 1) {
+      bad = check_rebuild(data, model, num_ids);
+    }
+  }
+
+  destroy_publ_data(data);
+  free(model);
+
+  if (bad) {
+    printf("remove_model: seed %u, step %d - FAILED\n", first_seed, step);
+    return 1;
+  }
+  printf("remove_model: %d steps - OK\n", steps);
+  return 0;
+}
@@ -0,0 +1,186 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+/*
+ * Randomized model test of the sharded mode (see Shards.h)
+ * The same random stream of add / update / remove ops goes, in batches of
+ * random sizes, to a Publ_Shards and, one by one, to a single PublData (the
+ * model). After every batch, random queries of tasks 1, 2, 3, 6 and 8 must
+ * give the same answers on both. The IDs are drawn from a small range, so
+ * updates and removals keep hitting added papers that are cited from other
+ * shards (the citations carried over by remove_own_paper).
+ *
+ * Usage: shards_model [steps] [seed]  - exits with 1 on the first mismatch
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../PaperOps.h"
+#include "../Shards.h"
+#include "../publications.h"
+
+#define MAX_SHARDS 7
+#define MAX_BATCH 64
+#define QUERIES_PER_BATCH 20
+
+static unsigned int seed;
+
+static int rnd(int n) {
+  seed = seed * 1103515245u + 12345u;
+  return (seed >> 8) % n;
+}
+
+/* A random op on one of the first num_ids IDs */
+static void random_op(Paper_Op *op, int num_ids, int step) {
+  char title[32], venue[16], field[16], names[2][16], institutions[2][16];
+  const char *author_names[2], *author_institutions[2], *fields[1];
+  int64_t author_ids[2], references[6];
+  int i;
+
+  int64_t id = rnd(num_ids);
+  int type = rnd(10);
+  if (type == 9) {
+    init_paper_op(op, OP_REMOVE_PAPER, NULL, NULL, 0, NULL, NULL, NULL, 0,
+                  NULL, 0, id, NULL, 0);
+    return;
+  }
+
+  sprintf(title, "T%" PRId64 "_%d", id, step);
+  sprintf(venue, "V%d", rnd(7));
+  sprintf(field, "F%d", rnd(5));
+  fields[0] = field;
+  for (i = 0; i < 2; i++) {
+    author_ids[i] = rnd(30);
+    sprintf(names[i], "A%" PRId64, author_ids[i]);
+    sprintf(institutions[i], "I%d", rnd(4));
+    author_names[i] = names[i];
+    author_institutions[i] = institutions[i];
+  }
+
+  int num_refs = rnd(6);
+  for (i = 0; i < num_refs; i++) {
+    references[i] = rnd(num_ids);
+  }
+
+  init_paper_op(op, type < 7 ? OP_ADD_PAPER : OP_UPDATE_PAPER, title, venue,
+                1950 + rnd(70), author_names, author_ids, author_institutions,
+                2, fields, 1, id, references, num_refs);
+}
+
+/* Number of mismatches */
+static int compare_queries(PublData *model, Publ_Shards *shards,
+                           int num_ids) {
+  int q, bad = 0;
+
+  for (q = 0; q < QUERIES_PER_BATCH; q++) {
+    int64_t id = rnd(num_ids);
+    int distance = 1 + rnd(5);
+    char venue[16];
+    sprintf(venue, "V%d", rnd(8));
+    int early_date = 1950 + rnd(70);
+    int late_date = early_date + rnd(30);
+    int64_t author = rnd(32);
+
+    char *expected = get_oldest_influence(model, id);
+    char *got = shards_get_oldest_influence(shards, id);
+    if (strcmp(expected, got)) {
+      fprintf(stderr, "task 1, %" PRId64 ": %s vs %s\n", id, expected, got);
+      bad++;
+    }
+
+    float impact_factor = get_venue_impact_factor(model, venue);
+    float shards_impact_factor = shards_get_venue_impact_factor(shards, venue);
+    if (impact_factor != shards_impact_factor) {
+      fprintf(stderr, "task 2, %s: %f vs %f\n", venue, impact_factor,
+              shards_impact_factor);
+      bad++;
+    }
+
+    int influenced = get_number_of_influenced_papers(model, id, distance);
+    int shards_influenced =
+        shards_get_number_of_influenced_papers(shards, id, distance);
+    if (influenced != shards_influenced) {
+      fprintf(stderr, "task 3, %" PRId64 " %d: %d vs %d\n", id, distance,
+              influenced, shards_influenced);
+      bad++;
+    }
+
+    int papers =
+        get_number_of_papers_between_dates(model, early_date, late_date);
+    int shards_papers = shards_get_number_of_papers_between_dates(
+        shards, early_date, late_date);
+    if (papers != shards_papers) {
+      fprintf(stderr, "task 6, [%d, %d]: %d vs %d\n", early_date, late_date,
+              papers, shards_papers);
+      bad++;
+    }
+
+    int num_years, shards_num_years;
+    int *histogram = get_histogram_of_citations(model, author, &num_years);
+    int *shards_histogram =
+        shards_get_histogram_of_citations(shards, author, &shards_num_years);
+    if (num_years != shards_num_years ||
+        memcmp(histogram, shards_histogram, num_years * sizeof(int))) {
+      fprintf(stderr, "task 8, %" PRId64 ": %d vs %d years\n", author,
+              num_years, shards_num_years);
+      bad++;
+    }
+    free(histogram);
+    free(shards_histogram);
+  }
+
+  return bad;
+}
+
+static int run_model(int num_shards, int steps) {
+  PublData *model = init_publ_data();
+  Publ_Shards *shards = init_publ_shards(num_shards);
+  Paper_Op batch[MAX_BATCH];
+  int num_ids = steps / 2 + 10;
+  int step, i, size = 0, batch_size = 1 + rnd(MAX_BATCH), bad = 0;
+
+  for (step = 0; step < steps && bad == 0; step++) {
+    random_op(&batch[size], num_ids, step);
+    apply_paper_op(model, &batch[size++]);
+
+    if (size < batch_size && step < steps - 1) {
+      continue;
+    }
+    shards_apply(shards, batch, size);
+    for (i = 0; i < size; i++) {
+      free_paper_op(&batch[i]);
+    }
+    size = 0;
+    batch_size = 1 + rnd(MAX_BATCH);
+
+    bad = compare_queries(model, shards, num_ids);
+  }
+
+  for (i = 0; i < size; i++) {
+    free_paper_op(&batch[i]);
+  }
+  destroy_publ_data(model);
+  destroy_publ_shards(shards);
+
+  return bad;
+}
+
+int main(int argc, char **argv) {
+  int steps = argc > 1 ? atoi(argv[1]) : 3000;
+  unsigned int first_seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  int num_shards;
+
+  for (num_shards = 1; num_shards <= MAX_SHARDS; num_shards++) {
+    seed = first_seed + num_shards;
+    if (run_model(num_shards, steps)) {
+      printf("shards_model: %d shards, seed %u - FAILED\n", num_shards,
+             first_seed);
+      return 1;
+    }
+  }
+
+  printf("shards_model: 1 .. %d shards, %d steps - OK\n", MAX_SHARDS, steps);
+  return 0;
+}
@@ -0,0 +1,214 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+/*
+ * Concurrency test of the snapshots (see Snapshots.h)
+ * A writer applies a random stream of add / update / remove ops, publishing
+ * a version every few ops, while readers keep entering and leaving (and
+ * opening and closing their readers). Every version also updates a marker
+ * paper titled with the version number, so a reader can tell which version
+ * it entered: its answers must be exactly the ones of that version, computed
+ * beforehand by the writer on a plain PublData that got the same ops.
+ *
+ * Usage: snapshots_model [steps] [seed]  - exits with 1 on a mismatch
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../Snapshots.h"
+#include "../publications.h"
+
+#define NUM_READERS 4
+#define OPS_PER_VERSION 16
+#define NUM_VENUES 7
+#define NUM_SOURCES 8
+#define NUM_ANSWERS (NUM_VENUES + NUM_SOURCES + 1)
+#define MARKER_ID 1000000000
+#define MARKER_CITER_ID 1000000001
+
+static unsigned int seed;
+
+static int rnd(int n) {
+  seed = seed * 1103515245u + 12345u;
+  return (seed >> 8) % n;
+}
+
+typedef struct test_state {
+  Publ_Snapshots *snapshots;
+  double (*answers)[NUM_ANSWERS];  // Per version, written before publishing
+  int num_ids;
+  _Atomic int done;
+  _Atomic int bad;
+  _Atomic int64_t checked;
+} Test_State;
+
+/* The same answers, from a replica or from the model */
+static void get_answers(PublData *data, int num_ids, double *answers) {
+  char venue[16];
+  int i;
+
+  for (i = 0; i < NUM_VENUES; i++) {
+    sprintf(venue, "V%d", i);
+    answers[i] = get_venue_impact_factor(data, venue);
+  }
+  for (i = 0; i < NUM_SOURCES; i++) {
+    answers[NUM_VENUES + i] =
+        get_number_of_influenced_papers(data, i * num_ids / NUM_SOURCES, 3);
+  }
+  answers[NUM_VENUES + NUM_SOURCES] =
+      get_number_of_papers_between_dates(data, 1950, 2019);
+}
+
+static void *reader_thread(void *arg) {
+  Test_State *state = arg;
+  double answers[NUM_ANSWERS];
+  char marker[16];
+  int round = 0;
+
+  while (!atomic_load(&state->done) && !atomic_load(&state->bad)) {
+    Snapshot_Reader *reader = open_snapshot_reader(state->snapshots);
+    int i;
+
+    for (i = 0; i < 1 + round % 5; i++) {
+      PublData *data = enter_snapshot(reader);
+
+      // The marker is the only paper its citer was influenced by
+      char *title = get_oldest_influence(data, MARKER_CITER_ID);
+      int version = atoi(title + 1);
+      sprintf(marker, "v%d", version);
+      get_answers(data, state->num_ids, answers);
+
+      // The title stays valid (and the same) until leave_snapshot, too
+      if (memcmp(answers, state->answers[version], sizeof(answers)) ||
+          strcmp(title, marker)) {
+        fprintf(stderr, "version %d: different answers\n", version);
+        atomic_store(&state->bad, 1);
+      }
+
+      leave_snapshot(reader);
+      atomic_fetch_add(&state->checked, 1);
+    }
+
+    close_snapshot_reader(reader);
+    round++;
+  }
+
+  return NULL;
+}
+
+/* One random op, on both the snapshots and the model */
+static void random_op(Publ_Snapshots *snapshots, PublData *model, int num_ids,
+                      int step) {
+  char title[32], venue[16], field[16], name[16];
+  const char *names[1] = {name}, *institutions[1] = {"I"};
+  const char *fields[1] = {field};
+  int64_t author_ids[1], references[4];
+  int i;
+
+  int64_t id = rnd(num_ids);
+  int type = rnd(10);
+  if (type == 9) {
+    snapshot_remove_paper(snapshots, id);
+    remove_paper(model, id);
+    return;
+  }
+
+  sprintf(title, "T%" PRId64 "_%d", id, step);
+  sprintf(venue, "V%d", rnd(NUM_VENUES));
+  sprintf(field, "F%d", rnd(3));
+  author_ids[0] = rnd(20);
+  sprintf(name, "A%" PRId64, author_ids[0]);
+  int year = 1950 + rnd(70);
+  int num_refs = rnd(5);
+  for (i = 0; i < num_refs; i++) {
+    references[i] = rnd(num_ids);
+  }
+
+  if (type < 7) {
+    snapshot_add_paper(snapshots, title, venue, year, names, author_ids,
+                       institutions, 1, fields, 1, id, references, num_refs);
+    add_paper(model, title, venue, year, names, author_ids, institutions, 1,
+              fields, 1, id, references, num_refs);
+  } else {
+    snapshot_update_paper(snapshots, title, venue, year, names, author_ids,
+                          institutions, 1, fields, 1, id, references,
+                          num_refs);
+    update_paper(model, title, venue, year, names, author_ids, institutions,
+                 1, fields, 1, id, references, num_refs);
+  }
+}
+
+/* The marker, titled after the version (outside the years of the queries) */
+static void set_marker(Publ_Snapshots *snapshots, PublData *model,
+                       int version) {
+  const char *names[1] = {"M"}, *institutions[1] = {"I"}, *fields[1] = {"M"};
+  int64_t author_ids[1] = {100}, marker_id = MARKER_ID;
+  char title[16];
+
+  sprintf(title, "v%d", version);
+  snapshot_update_paper(snapshots, title, "M", 1900, names, author_ids,
+                        institutions, 1, fields, 1, MARKER_ID, NULL, 0);
+  update_paper(model, title, "M", 1900, names, author_ids, institutions, 1,
+               fields, 1, MARKER_ID, NULL, 0);
+  if (version == 0) {
+    snapshot_add_paper(snapshots, "C", "M", 1901, names, author_ids,
+                       institutions, 1, fields, 1, MARKER_CITER_ID, &marker_id,
+                       1);
+    add_paper(model, "C", "M", 1901, names, author_ids, institutions, 1,
+              fields, 1, MARKER_CITER_ID, &marker_id, 1);
+  }
+}
+
+int main(int argc, char **argv) {
+  int steps = argc > 1 ? atoi(argv[1]) : 5000;
+  unsigned int first_seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  int num_versions = steps / OPS_PER_VERSION + 1;
+  pthread_t readers[NUM_READERS];
+  Test_State state = {0};
+  int i, step, version = 0;
+
+  seed = first_seed;
+  state.snapshots = init_publ_snapshots();
+  state.answers = calloc(num_versions + 1, sizeof(*state.answers));
+  state.num_ids = steps / 4 + 10;
+  PublData *model = init_publ_data();
+
+  set_marker(state.snapshots, model, 0);
+  get_answers(model, state.num_ids, state.answers[0]);
+  publish_snapshot(state.snapshots);
+
+  for (i = 0; i < NUM_READERS; i++) {
+    pthread_create(&readers[i], NULL, reader_thread, &state);
+  }
+
+  for (step = 0; step < steps && !atomic_load(&state.bad); step++) {
+    random_op(state.snapshots, model, state.num_ids, step);
+    if ((step + 1) % OPS_PER_VERSION == 0) {
+      version++;
+      set_marker(state.snapshots, model, version);
+      get_answers(model, state.num_ids, state.answers[version]);
+      publish_snapshot(state.snapshots);
+    }
+  }
+
+  atomic_store(&state.done, 1);
+  for (i = 0; i < NUM_READERS; i++) {
+    pthread_join(readers[i], NULL);
+  }
+
+  destroy_publ_snapshots(state.snapshots);
+  destroy_publ_data(model);
+  free(state.answers);
+
+  if (atomic_load(&state.bad)) {
+    printf("snapshots_model: seed %u - FAILED\n", first_seed);
+    return 1;
+  }
+  printf("snapshots_model: %d versions, %" PRId64 " snapshots read - OK\n",
+         version + 1, (int64_t)atomic_load(&state.checked));
+  return 0;
+}
@@ -0,0 +1,233 @@
+// Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
+
+/*
+ * Recovery test of the write-ahead log (see WriteAheadLog.h)
+ * Every round applies a random stream of add / update / remove ops through
+ * wal_apply (compacting once, somewhere in the middle), closes the log and
+ * recovers it into a fresh PublData, whose answers (tasks 1, 2, 3, 6 and 8)
+ * must be the ones of a model that got the same ops. Some rounds then damage
+ * the last record - cut short, as by a crash, or with a flipped byte - and
+ * the recovery must drop just that op; the next round keeps logging after
+ * it.
+ *
+ * Usage: wal_model [rounds] [seed]  - exits with 1 on the first mismatch
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../PaperOps.h"
+#include "../WriteAheadLog.h"
+#include "../publications.h"
+
+#define OPS_PER_ROUND 300
+#define NUM_IDS 400
+
+static unsigned int seed;
+
+static int rnd(int n) {
+  seed = seed * 1103515245u + 12345u;
+  return (seed >> 8) % n;
+}
+
+/* A random op on one of the first NUM_IDS IDs */
+static void random_op(Paper_Op *op, int step) {
+  char title[32], venue[16], field[16], names[2][16], institutions[2][16];
+  const char *author_names[2], *author_institutions[2], *fields[1];
+  int64_t author_ids[2], references[6];
+  int i;
+
+  int64_t id = rnd(NUM_IDS);
+  int type = rnd(10);
+  if (type == 9) {
+    init_paper_op(op, OP_REMOVE_PAPER, NULL, NULL, 0, NULL, NULL, NULL, 0,
+                  NULL, 0, id, NULL, 0);
+    return;
+  }
+
+  sprintf(title, "T%" PRId64 "_%d", id, step);
+  sprintf(venue, "V%d", rnd(7));
+  sprintf(field, "F%d", rnd(5));
+  fields[0] = field;
+  for (i = 0; i < 2; i++) {
+    author_ids[i] = rnd(30);
+    sprintf(names[i], "A%" PRId64 "_%d", author_ids[i], rnd(2));
+    sprintf(institutions[i], "I%d", rnd(4));
+    author_names[i] = names[i];
+    author_institutions[i] = institutions[i];
+  }
+
+  int num_refs = rnd(6);
+  for (i = 0; i < num_refs; i++) {
+    references[i] = rnd(NUM_IDS + 10);
+  }
+
+  init_paper_op(op, type < 7 ? OP_ADD_PAPER : OP_UPDATE_PAPER, title, venue,
+                1950 + rnd(70), author_names, author_ids, author_institutions,
+                2, fields, 1, id, references, num_refs);
+}
+
+/* Number of different answers */
+static int compare_data(PublData *model, PublData *data) {
+  char venue[16];
+  int i, bad = 0;
+
+  for (i = 0; i < NUM_IDS; i++) {
+    char *expected = get_oldest_influence(model, i);
+    char *got = get_oldest_influence(data, i);
+    if (strcmp(expected, got) ||
+        get_number_of_influenced_papers(model, i, 3) !=
+            get_number_of_influenced_papers(data, i, 3)) {
+      fprintf(stderr, "paper %d: different influence\n", i);
+      bad++;
+    }
+  }
+
+  for (i = 0; i < 8; i++) {
+    sprintf(venue, "V%d", i);
+    if (get_venue_impact_factor(model, venue) !=
+        get_venue_impact_factor(data, venue)) {
+      fprintf(stderr, "venue %s: different impact factor\n", venue);
+      bad++;
+    }
+  }
+
+  for (i = 1950; i < 2020; i += 7) {
+    if (get_number_of_papers_between_dates(model, i, i + 10) !=
+        get_number_of_papers_between_dates(data, i, i + 10)) {
+      fprintf(stderr, "years %d - %d: different counts\n", i, i + 10);
+      bad++;
+    }
+  }
+
+  for (i = 0; i < 30; i++) {
+    int num_years, data_num_years;
+    int *histogram = get_histogram_of_citations(model, i, &num_years);
+    int *data_histogram = get_histogram_of_citations(data, i, &data_num_years);
+    if (num_years != data_num_years ||
+        memcmp(histogram, data_histogram, num_years * sizeof(int))) {
+      fprintf(stderr, "author %d: different histograms\n", i);
+      bad++;
+    }
+    free(histogram);
+    free(data_histogram);
+  }
+
+  return bad;
+}
+
+static off_t log_size(const char *path) {
+  struct stat st;
+
+  return stat(path, &st) < 0 ? -1 : st.st_size;
+}
+
+/* Cuts the last record short, or flips a byte of it */
+static int damage_last_record(const char *path, off_t start, int torn) {
+  off_t end = log_size(path);
+  if (end <= start) {
+    return -1;
+  }
+
+  if (torn) {
+    return truncate(path, start + rnd(end - start));
+  }
+
+  int fd = open(path, O_RDWR);
+  if (fd < 0) {
+    return -1;
+  }
+  off_t pos = start + rnd(end - start);
+  unsigned char byte;
+  int ret = pread(fd, &byte, 1, pos) == 1 ? 0 : -1;
+  byte ^= 1u << rnd(8);
+  if (ret == 0 && pwrite(fd, &byte, 1, pos) != 1) {
+    ret = -1;
+  }
+  close(fd);
+
+  return ret;
+}
+
+int main(int argc, char **argv) {
+  int rounds = argc > 1 ? atoi(argv[1]) : 12;
+  unsigned int first_seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  char dir[] = "/tmp/wal_modelXXXXXX", path[64];
+  int round, i, bad = 0;
+  Paper_Op op;
+
+  seed = first_seed;
+  if (mkdtemp(dir) == NULL) {
+    perror("mkdtemp");
+    return 1;
+  }
+  sprintf(path, "%s/%s", dir, WAL_FILE);
+
+  PublData *model = init_publ_data();
+  PublData *data = init_publ_data();
+  Write_Ahead_Log *wal = open_write_ahead_log(dir, data);
+
+  for (round = 0; round < rounds && wal && bad == 0; round++) {
+    int compact_at = rnd(OPS_PER_ROUND);
+    int damage = round % 3;  // 0 - none, 1 - torn, 2 - corrupt
+    off_t start = 0;
+
+    for (i = 0; i < OPS_PER_ROUND; i++) {
+      if (i == compact_at && wal_compact(wal, data) < 0) {
+        perror("wal_compact");
+        bad++;
+      }
+
+      random_op(&op, round * OPS_PER_ROUND + i);
+      if (i == OPS_PER_ROUND - 1 && damage) {
+        // The record that gets damaged - lost, as far as the model knows
+        wal_sync(wal);
+        start = log_size(path);
+      } else {
+        apply_paper_op(model, &op);
+      }
+      wal_apply(wal, data, &op);
+      free_paper_op(&op);
+    }
+
+    close_write_ahead_log(wal);
+    if (damage && damage_last_record(path, start, damage == 1) < 0) {
+      perror("damage_last_record");
+      bad++;
+    }
+
+    // Recovery, as after a restart
+    destroy_publ_data(data);
+    data = init_publ_data();
+    wal = open_write_ahead_log(dir, data);
+    if (wal == NULL) {
+      perror("open_write_ahead_log");
+      bad++;
+    } else {
+      bad += compare_data(model, data);
+    }
+  }
+
+  if (wal) {
+    close_write_ahead_log(wal);
+  }
+  destroy_publ_data(data);
+  destroy_publ_data(model);
+
+  unlink(path);
+  sprintf(path, "%s/%s", dir, WAL_SNAPSHOT_FILE);
+  unlink(path);
+  rmdir(dir);
+
+  if (bad) {
+    printf("wal_model: seed %u, round %d - FAILED\n", first_seed, round);
+    return 1;
+  }
+  printf("wal_model: %d rounds - OK\n", rounds);
+  return 0;
+}
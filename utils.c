@@ -1,99 +1,163 @@
 // Copyright [2020] Razvan-Andrei Matisan, Radu-Stefan Minea
 
+#include <ctype.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "./AuthorRegistry.h"
 #include "./Hashtables.h"
 #include "./LinkedList.h"
+#include "./PaperFilter.h"
 #include "./publications.h"
 #include "./utils.h"
 
-unsigned int hash_function_int(void *a) {
-  /*
-   * Credits: https://stackoverflow.com/a/12996028/7883884
-   */
-  unsigned int uint_a = *((unsigned int *)a);
+Paper *find_paper_with_id(PublData *data, int64_t target_id) {
+  // Most misses (references outside the corpus) stop here
+  if (!paper_filter_may_contain(data->paper_filter, target_id)) {
+    return NULL;
+  }
+
+  Paper **publication = papers_ht_get(data->papers_ht, target_id);
+  if (publication) {
+    return *publication;
+  }
 
-  uint_a = ((uint_a >> 16u) ^ uint_a) * 0x45d9f3b;
-  uint_a = ((uint_a >> 16u) ^ uint_a) * 0x45d9f3b;
-  uint_a = (uint_a >> 16u) ^ uint_a;
-  return uint_a;
+  // Nothing found
+  return NULL;
 }
 
-int compare_function_strings(void *a, void *b) {
-  char *str_a = (char *)a;
-  char *str_b = (char *)b;
+/* Sign of (a - b), without truncating 64-bit ids to int */
+static int compare_ids(int64_t a, int64_t b) { return (a > b) - (a < b); }
 
-  return strcmp(str_a, str_b);
+/* ---------------- Traversal scratch ---------------- */
+Traversal_Scratch *begin_traversal(PublData *data) {
+  Traversal_Scratch *scratch = data->scratch;
+
+  if (scratch->cap < data->num_papers) {
+    int cap = scratch->cap ? scratch->cap : HMAX_BIG;
+    while (cap < data->num_papers) {
+      cap *= 2;
+    }
+
+    scratch->marks = realloc(scratch->marks, cap * sizeof(uint32_t));
+    DIE(scratch->marks == NULL, "scratch->marks realloc");
+    memset(scratch->marks + scratch->cap, 0,
+           (cap - scratch->cap) * sizeof(uint32_t));
+    scratch->cap = cap;
+  }
+
+  // Once every 2^32 searches the marks really are cleared
+  if (++scratch->round == 0) {
+    memset(scratch->marks, 0, scratch->cap * sizeof(uint32_t));
+    scratch->round = 1;
+  }
+
+  return scratch;
 }
 
-unsigned int hash_function_string(void *a) {
-  /*
-   * Credits: http://www.cse.yorku.ca/~oz/hash.html
-   */
-  unsigned char *puchar_a = (unsigned char *)a;
-  unsigned int hash = 5381;
-  int c;
+void free_traversal_scratch(Traversal_Scratch *scratch) {
+  if (scratch == NULL) {
+    return;
+  }
 
-  while ((c = *puchar_a++))
-    hash = ((hash << 5u) + hash) + c; /* hash * 33 + c */
+  free(scratch->marks);
+  free(scratch);
+}
 
-  return hash;
+/* ---------------- Generations (for the query cache) ---------------- */
+uint64_t next_generation(PublData *data) { return ++data->clock; }
+
+/* Root of the paper's region - papers linked by citations, in any direction */
+int find_region(PublData *data, int idx) {
+  int *parent = data->region_parent;
+
+  while (parent[idx] != idx) {
+    // Path halving
+    parent[idx] = parent[parent[idx]];
+    idx = parent[idx];
+  }
+
+  return idx;
 }
 
-int compare_function_ints(void *a, void *b) {
-  int int_a = *((int *)a);
-  int int_b = *((int *)b);
+int get_region(PublData *data, int idx) {
+  while (data->region_parent[idx] != idx) {
+    idx = data->region_parent[idx];
+  }
 
-  if (int_a == int_b) {
-    return 0;
-  } else if (int_a < int_b) {
-    return -1;
-  } else {
-    return 1;
+  return idx;
+}
+
+/* A new edge => both papers end up in the same, changed, region */
+void merge_regions(PublData *data, int idx1, int idx2) {
+  int root1 = find_region(data, idx1);
+  int root2 = find_region(data, idx2);
+
+  data->region_parent[root1] = root2;
+  data->region_generation[root2] = next_generation(data);
+}
+
+void touch_venue(PublData *data, const char *venue) {
+  Paper_Postings *postings = venue_ht_get(data->venue_ht, venue);
+  if (postings) {
+    postings->generation = next_generation(data);
   }
 }
 
-Paper *find_paper_with_id(PublData *data, int64_t target_id) {
-  unsigned int hash = data->hash_function(&target_id) % data->hmax;
-  struct Node *curr = data->buckets[hash]->head;
-  Paper *publication;
-
-  while (curr) {
-    publication = (Paper *)curr->data;
-    if (publication->id == target_id) {
-      return publication;
-    }
-    curr = curr->next;
+void touch_field(PublData *data, const char *field) {
+  Paper_Postings *postings = field_ht_get(data->field_ht, field);
+  if (postings) {
+    postings->generation = next_generation(data);
   }
+}
 
-  // Nothing found
-  return NULL;
+void touch_author(PublData *data, int author) {
+  data->authors->authors[author].generation = next_generation(data);
 }
 
-/* DFS-Style breadcrum cleaing - cleaning strictly the path we've been up on */
-void clean_refs_aux_data(PublData *data, Paper *start_publication) {
+/* The paper's number of citations changed */
+void touch_cited_paper(PublData *data, Paper *cited) {
   int i;
 
-  // Freeing current publications'
-  start_publication->ok = 0;
-  start_publication->citations = 0;
-  start_publication->distance = -1;
-
-  for (i = 0; i < start_publication->num_refs; i++) {
-    Paper *curr_publication =
-        find_paper_with_id(data, start_publication->references[i]);
-
-    // If current neighbors is found (added in the HT)
-    if (curr_publication) {
-      if (curr_publication->ok) {
-        // Freeing next's neighbors' aux data
-        clean_refs_aux_data(data, curr_publication);
-      }
+  touch_venue(data, cited->info->venue);
+  for (i = 0; i < cited->info->num_authors; i++) {
+    touch_author(data, cited->info->authors[i].author);
+  }
+}
+
+/* ---------------- Command parsing ---------------- */
+char *next_argument(const char **line) {
+  const char *p = *line;
+
+  while (isspace((unsigned char)*p)) {
+    p++;
+  }
+  if (*p == '\0') {
+    return NULL;
+  }
+
+  const char *start = p;
+  if (*p == '"') {
+    start = ++p;
+    while (*p && *p != '"') {
+      p++;
+    }
+  } else {
+    while (*p && !isspace((unsigned char)*p)) {
+      p++;
     }
   }
+
+  size_t len = p - start;
+  char *token = malloc(len + 1);
+  DIE(token == NULL, "token malloc");
+  memcpy(token, start, len);
+  token[len] = '\0';
+
+  *line = *p == '"' ? p + 1 : p;
+  return token;
 }
 
 // > 0 --> older influence found
@@ -106,56 +170,31 @@ int compare_task1(PublData *data, Paper *challenger, Paper *titleholder) {
   if (challenger->year != titleholder->year) {
     return titleholder->year - challenger->year;
   } else {
-    if (!challenger->citations) {
-      challenger->citations =
-          get_no_citations(data->citations_ht, challenger->id);
-    }
-    if (!titleholder->citations) {
-      titleholder->citations =
-          get_no_citations(data->citations_ht, titleholder->id);
-    }
-    if (challenger->citations != titleholder->citations) {
-      return challenger->citations - titleholder->citations;
+    int challenger_citations = get_paper_citations(data, challenger);
+    int titleholder_citations = get_paper_citations(data, titleholder);
+
+    if (challenger_citations != titleholder_citations) {
+      return challenger_citations - titleholder_citations;
     } else {
-      return titleholder->id - challenger->id;
+      return compare_ids(titleholder->id, challenger->id);
     }
   }
 }
 
 /* --------------------- Pentru Taskul 5 ------------------------ */
-int no_papers_with_field(Field_HT *field_ht, const char *field,
-                         int64_t ids_with_field[NMAX]) {
-  unsigned int hash = field_ht->hash_function(field) % field_ht->hmax;
-  struct Node *curr = field_ht->buckets[hash].head;
-  int i = 0;
-
-  while (curr) {
-    field_paper *publication = (field_paper *)curr->data;
-    if (!strcmp(publication->field, field)) {
-      ids_with_field[i] = publication->id;
-      i++;
-    }
-    curr = curr->next;
-  }
-
-  return i;
-}
-
 int compare_task5(PublData *data, Paper *publication1, Paper *publication2) {
   if (!publication1 || !publication2 || publication1->id == publication2->id) {
     return 0;
   }
-  publication1->citations =
-      get_no_citations(data->citations_ht, publication1->id);
-  publication2->citations =
-      get_no_citations(data->citations_ht, publication2->id);
+  int citations1 = get_paper_citations(data, publication1);
+  int citations2 = get_paper_citations(data, publication2);
 
-  if (publication1->citations != publication2->citations) {
-    return publication1->citations - publication2->citations;
+  if (citations1 != citations2) {
+    return citations1 - citations2;
   } else if (publication1->year != publication2->year) {
     return publication1->year - publication2->year;
   } else {
-    return publication2->id - publication1->id;
+    return compare_ids(publication2->id, publication1->id);
   }
 }
 
@@ -164,15 +203,3 @@ void swap(int64_t *a, int64_t *b) {
   *a = *b;
   *b = aux;
 }
-
-/* ----------------------------- Taskul 7   -----------------------*/
-int is_in_array(char *arr_to_find, char **arr, int length) {
-  int i;
-
-  for (i = 0; i < length; i++) {
-    if (!strcmp(arr[i], arr_to_find)) {
-      return 1;
-    }
-  }
-  return 0;
-}
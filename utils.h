@@ -9,30 +9,78 @@
 #define CURR_YEAR 2020
 #define MAX_YEAR 2050
 #define INITIAL_HISTOGRAM_SIZE 1
-#define VISITED 1
-#define UNVISITED 0
 
-unsigned int hash_function_int(void *a);
+/* Frontiers this big are expanded by the thread pool (see Task 3) */
+#ifndef PARALLEL_BFS_THRESHOLD
+#define PARALLEL_BFS_THRESHOLD 4096
+#endif
+#define PARALLEL_BFS_CHUNK 256
 
-int compare_function_ints(void *a, void *b);
+/* Searches run together by the multi-source BFS (one bit each) */
+#define MULTI_BFS_WIDTH 64
 
-unsigned int hash_function_string(void *a);
+Paper *find_paper_with_id(PublData *data, int64_t target_id);
 
-int compare_function_strings(void *a, void *b);
+static inline int get_paper_citations(PublData *data, Paper *publication) {
+  return data->columns->citations[publication->idx];
+}
 
-Paper *find_paper_with_id(PublData *data, int64_t target_id);
+/*
+ * Traversal Scratch - the "visited" marks of the searches (tasks 1 & 3), kept
+ * outside the papers so that readers searching the same snapshot side by
+ * side (see Snapshots.h) never share them
+ * A paper is visited if its mark is the current round => starting a new
+ * search unmarks every paper at once, with nothing to clean afterwards.
+ */
+typedef struct Traversal_Scratch {
+  uint32_t *marks;  // By dense ID
+  int cap;
+  uint32_t round;
+} Traversal_Scratch;
 
-void clean_refs_aux_data(PublData *data, Paper *start_publication);
+/* New round of marks, covering all the dense IDs of data */
+Traversal_Scratch *begin_traversal(PublData *data);
 
-int compare_task1(PublData *data, Paper *challenger, Paper *titleholder);
+/* 1 if the paper was not visited yet (and now is) */
+static inline int visit_paper(Traversal_Scratch *scratch, int idx) {
+  if (scratch->marks[idx] == scratch->round) {
+    return 0;
+  }
+
+  scratch->marks[idx] = scratch->round;
+  return 1;
+}
+
+void free_traversal_scratch(Traversal_Scratch *scratch);
+
+uint64_t next_generation(PublData *data);
+
+int find_region(PublData *data, int idx);
+
+/* Same as find_region, without writing anything - for the queries */
+int get_region(PublData *data, int idx);
 
-int no_papers_with_field(Field_HT *field_ht, const char *field,
-                         int64_t ids_with_field[NMAX]);
+void merge_regions(PublData *data, int idx1, int idx2);
+
+void touch_venue(PublData *data, const char *venue);
+
+void touch_field(PublData *data, const char *field);
+
+void touch_author(PublData *data, int author);
+
+void touch_cited_paper(PublData *data, Paper *cited);
+
+/*
+ * Next argument of a command line (see parse_query), as a new string -
+ * NULL if none is left. Arguments are separated by whitespace; a quoted one
+ * may contain it.
+ */
+char *next_argument(const char **line);
+
+int compare_task1(PublData *data, Paper *challenger, Paper *titleholder);
 
 int compare_task5(PublData *data, Paper *publication1, Paper *publication2);
 
 void swap(int64_t *a, int64_t *b);
 
-int is_in_array(char *arr_to_find, char **arr, int length);
-
 #endif /* UTILS_H_ */